@@ -0,0 +1,211 @@
+// coroutine_benchmark.cpp
+// Runs the same requests through a blocking thread pool and through
+// coroutines on epoll executors with the same number of threads, all pinned
+// to the same `threads` CPUs. A request spins `cpu_us` (decoding, session
+// lookup), waits `lookup_us` for an external lookup and appends its CDR to
+// `cdr_file`. A pool thread blocks through both waits; a coroutine suspends
+// on an executor timer and on the CDR flusher, which appends the records of
+// every coroutine waiting at that moment at once. Each executor keeps
+// `inflight` requests going. Prints requests per second and the latency of a
+// request from its start to its CDR being written.
+//
+// Usage: coroutine_benchmark [requests] [threads] [inflight] [cpu_us] [lookup_us] [cdr_file]
+
+#include "server/cdr_flusher.hpp"
+#include "server/cdr_writer.hpp"
+#include "server/coro_executor.hpp"
+#include "server/spin_policy.hpp"
+#include <sched.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Options {
+    size_t requests = 20000;
+    size_t threads = 4;
+    size_t inflight = 64;
+    int64_t cpu_ns = 5000;
+    int64_t lookup_ns = 200000;
+    std::string cdr_file = "/tmp/coroutine_benchmark_cdr.log";
+};
+
+struct Result {
+    double seconds = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+    double p999_us = 0;
+};
+
+void spin(int64_t ns) {
+    int64_t until = now_ns() + ns;
+    while (now_ns() < until) cpu_relax();
+}
+
+std::string imsi_of(size_t request) {
+    std::string digits = std::to_string(request);
+    return std::string(15 - std::min<size_t>(15, digits.size()), '0') + digits;
+}
+
+// Pins the calling thread, and every thread it starts later, to the first
+// `count` CPUs it may run on. Returns how many it got.
+size_t pin_process(size_t count) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return 0;
+    cpu_set_t chosen;
+    CPU_ZERO(&chosen);
+    size_t taken = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE && taken < count; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            CPU_SET(cpu, &chosen);
+            ++taken;
+        }
+    }
+    return sched_setaffinity(0, sizeof(chosen), &chosen) == 0 ? taken : 0;
+}
+
+Result summarize(std::vector<std::vector<int64_t>>& latencies, int64_t start_ns, int64_t end_ns) {
+    std::vector<int64_t> all;
+    for (const auto& own : latencies) {
+        all.insert(all.end(), own.begin(), own.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&](size_t per_mille) {
+        return all.empty() ? 0 : all[std::min(all.size() - 1, all.size() * per_mille / 1000)] / 1e3;
+    };
+    Result result;
+    result.seconds = (end_ns - start_ns) / 1e9;
+    result.p50_us = percentile(500);
+    result.p99_us = percentile(990);
+    result.p999_us = percentile(999);
+    return result;
+}
+
+// One request per thread at a time: the thread sleeps through the lookup
+// and the CDR append.
+Result run_thread_pool(const Options& options) {
+    CdrWriter writer(options.cdr_file);
+    std::atomic<size_t> next{0};
+    std::vector<std::vector<int64_t>> latencies(options.threads);
+
+    int64_t start_ns = now_ns();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < options.threads; ++t) {
+        threads.emplace_back([&, t] {
+            std::vector<CdrRecord> records(1);
+            size_t request;
+            while ((request = next.fetch_add(1, std::memory_order_relaxed)) < options.requests) {
+                int64_t started = now_ns();
+                spin(options.cpu_ns);
+                std::this_thread::sleep_for(std::chrono::nanoseconds(options.lookup_ns));
+                records[0] = {imsi_of(request), "create"};
+                writer.write(records);
+                latencies[t].push_back(now_ns() - started);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return summarize(latencies, start_ns, now_ns());
+}
+
+struct ExecutorState {
+    CoroExecutor executor;
+    size_t running = 0;
+    std::vector<int64_t> latencies;
+};
+
+CoroTask serve_requests(const Options& options, std::atomic<size_t>& next, CdrFlusher& flusher, ExecutorState& state) {
+    std::vector<CdrRecord> records(1);
+    size_t request;
+    while ((request = next.fetch_add(1, std::memory_order_relaxed)) < options.requests) {
+        int64_t started = now_ns();
+        spin(options.cpu_ns);
+        co_await state.executor.sleep_for(std::chrono::nanoseconds(options.lookup_ns));
+        records[0] = {imsi_of(request), "create"};
+        co_await flusher.flush(state.executor, records);
+        state.latencies.push_back(now_ns() - started);
+    }
+    if (--state.running == 0) state.executor.stop();
+}
+
+// `inflight` coroutines per executor thread; the flusher thread shares the same CPUs.
+Result run_coroutines(const Options& options) {
+    CdrWriter writer(options.cdr_file);
+    CdrFlusher flusher(writer);
+    flusher.start("bench-cdr", {});
+    std::atomic<size_t> next{0};
+    std::vector<std::unique_ptr<ExecutorState>> states;
+    for (size_t t = 0; t < options.threads; ++t) {
+        states.push_back(std::make_unique<ExecutorState>());
+        if (!states.back()->executor.open()) std::exit(1);
+    }
+
+    int64_t start_ns = now_ns();
+    std::vector<std::thread> threads;
+    for (auto& state : states) {
+        threads.emplace_back([&options, &next, &flusher, &state = *state] {
+            state.running = options.inflight;
+            for (size_t i = 0; i < options.inflight; ++i) {
+                state.executor.spawn(serve_requests(options, next, flusher, state));
+            }
+            state.executor.run();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    int64_t end_ns = now_ns();
+    flusher.stop();
+
+    std::vector<std::vector<int64_t>> latencies;
+    for (auto& state : states) {
+        latencies.push_back(std::move(state->latencies));
+    }
+    return summarize(latencies, start_ns, end_ns);
+}
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (argc > 1) options.requests = std::strtoul(argv[1], nullptr, 10);
+    if (argc > 2) options.threads = std::strtoul(argv[2], nullptr, 10);
+    if (argc > 3) options.inflight = std::strtoul(argv[3], nullptr, 10);
+    if (argc > 4) options.cpu_ns = std::strtol(argv[4], nullptr, 10) * 1000;
+    if (argc > 5) options.lookup_ns = std::strtol(argv[5], nullptr, 10) * 1000;
+    if (argc > 6) options.cdr_file = argv[6];
+    if (options.requests == 0 || options.threads == 0 || options.inflight == 0) {
+        std::fprintf(stderr, "Usage: %s [requests] [threads] [inflight] [cpu_us] [lookup_us] [cdr_file]\n", argv[0]);
+        return 1;
+    }
+
+    size_t cpus = pin_process(options.threads);
+    std::printf("%zu requests, %zu threads on %zu CPUs, %zu in flight per executor, %lld us CPU, %lld us lookup, CDRs to %s\n\n",
+                options.requests, options.threads, cpus, options.inflight,
+                static_cast<long long>(options.cpu_ns / 1000), static_cast<long long>(options.lookup_ns / 1000),
+                options.cdr_file.c_str());
+    std::printf("%-16s %12s %10s %10s %10s\n", "path", "requests/s", "p50 us", "p99 us", "p99.9 us");
+    auto print = [&](const char* label, const Result& result) {
+        std::printf("%-16s %12.0f %10.1f %10.1f %10.1f\n", label, options.requests / result.seconds,
+                    result.p50_us, result.p99_us, result.p999_us);
+    };
+    std::remove(options.cdr_file.c_str());
+    print("thread pool", run_thread_pool(options));
+    std::remove(options.cdr_file.c_str());
+    print("coroutines", run_coroutines(options));
+    std::remove(options.cdr_file.c_str());
+    return 0;
+}
@@ -0,0 +1,213 @@
+// dispatch_benchmark.cpp
+// Feeds the same bursty load with a heavy-tailed service time to the single
+// task queue shared by all workers and to per-worker queues with work
+// stealing, and prints throughput and the latency from enqueue to the end of
+// service side by side. Most tasks take `short_us`, every 100th takes
+// `long_us`; the producer deals `burst` tasks at a time and keeps at most
+// `window` tasks in flight.
+//
+// Usage: dispatch_benchmark [tasks] [workers] [burst] [window] [short_us] [long_us]
+
+#include "server/bounded_queue.hpp"
+#include "server/futex_event.hpp"
+#include "server/spin_policy.hpp"
+#include "server/worker_queues.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr size_t LONG_TASK_EVERY = 100;
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Task {
+    int64_t enqueued_ns = 0;
+    int64_t service_ns = 0;
+};
+
+struct Options {
+    size_t tasks = 200000;
+    size_t workers = 4;
+    size_t burst = 64;
+    size_t window = 1024;
+    int64_t short_ns = 2000;
+    int64_t long_ns = 200000;
+};
+
+struct Result {
+    double seconds = 0;
+    size_t steals = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+    double p999_us = 0;
+};
+
+// The pool before work stealing: every worker pops the head of one queue.
+class SharedQueue {
+public:
+    SharedQueue(size_t /*workers*/, const QueueLimits& limits) : tasks_(limits) {}
+
+    bool push(Task&& task, std::chrono::steady_clock::time_point now) {
+        if (tasks_.push(std::move(task), now) != BoundedQueue<Task>::PushResult::Queued) return false;
+        ++dealt_;
+        return true;
+    }
+    void notify() {
+        work_ready_.notify(static_cast<int>(dealt_));
+        dealt_ = 0;
+    }
+    void notify_all() { work_ready_.notify_all(); }
+    bool pop(size_t /*worker*/, Task& task, std::chrono::steady_clock::time_point now,
+             QueueConsumer& consumer, bool& stolen) {
+        stolen = false;
+        return tasks_.pop(task, now, consumer);
+    }
+    bool empty() const { return tasks_.empty(); }
+    FutexEvent& work_ready(size_t /*worker*/) { return work_ready_; }
+
+private:
+    BoundedQueue<Task> tasks_;
+    FutexEvent work_ready_;
+    size_t dealt_ = 0;
+};
+
+class StealingQueues {
+public:
+    StealingQueues(size_t workers, const QueueLimits& limits) : queues_(workers, limits) {}
+
+    bool push(Task&& task, std::chrono::steady_clock::time_point now) {
+        return queues_.push(std::move(task), now) == WorkerQueues<Task>::PushResult::Queued;
+    }
+    void notify() { queues_.notify_dealt(); }
+    void notify_all() { queues_.notify_all(); }
+    bool pop(size_t worker, Task& task, std::chrono::steady_clock::time_point now,
+             QueueConsumer& consumer, bool& stolen) {
+        return queues_.pop(worker, task, now, consumer, stolen);
+    }
+    bool empty() const { return queues_.empty(); }
+    FutexEvent& work_ready(size_t worker) { return queues_.work_ready(worker); }
+
+private:
+    WorkerQueues<Task> queues_;
+};
+
+void serve(int64_t service_ns) {
+    int64_t until = now_ns() + service_ns;
+    while (now_ns() < until) cpu_relax();
+}
+
+template <typename Pool>
+Result run_pool(const Options& options) {
+    QueueLimits limits;
+    limits.capacity = options.window;
+    Pool pool(options.workers, limits);
+    std::atomic<size_t> done{0};
+    std::atomic<bool> finished{false};
+    std::atomic<size_t> steals{0};
+    std::vector<std::vector<int64_t>> latencies(options.workers);
+
+    std::vector<std::thread> workers;
+    for (size_t worker = 0; worker < options.workers; ++worker) {
+        workers.emplace_back([&, worker] {
+            QueueConsumer consumer(limits);
+            std::vector<int64_t>& own = latencies[worker];
+            own.reserve(options.tasks / options.workers * 2);
+            Task task;
+            bool stolen = false;
+            while (true) {
+                if (pool.pop(worker, task, std::chrono::steady_clock::now(), consumer, stolen)) {
+                    if (stolen) steals.fetch_add(1, std::memory_order_relaxed);
+                    serve(task.service_ns);
+                    own.push_back(now_ns() - task.enqueued_ns);
+                    done.fetch_add(1, std::memory_order_release);
+                    continue;
+                }
+                if (finished.load(std::memory_order_acquire)) break;
+                FutexEvent& work_ready = pool.work_ready(worker);
+                uint32_t epoch = work_ready.prepare_wait();
+                if (pool.empty() && !finished.load(std::memory_order_acquire)) work_ready.wait(epoch);
+                work_ready.finish_wait();
+            }
+        });
+    }
+
+    int64_t start_ns = now_ns();
+    size_t pushed = 0;
+    while (pushed < options.tasks) {
+        size_t in_flight = pushed - done.load(std::memory_order_acquire);
+        size_t burst = std::min({options.burst, options.tasks - pushed, options.window - std::min(options.window, in_flight)});
+        if (burst == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        auto now = std::chrono::steady_clock::now();
+        int64_t stamp = now_ns();
+        for (size_t i = 0; i < burst; ++i, ++pushed) {
+            bool heavy = pushed % LONG_TASK_EVERY == LONG_TASK_EVERY - 1;
+            if (!pool.push(Task{stamp, heavy ? options.long_ns : options.short_ns}, now)) break;
+        }
+        pool.notify();
+    }
+    while (done.load(std::memory_order_acquire) < options.tasks) {
+        std::this_thread::yield();
+    }
+    int64_t end_ns = now_ns();
+    finished.store(true, std::memory_order_release);
+    pool.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    std::vector<int64_t> all;
+    for (const auto& own : latencies) {
+        all.insert(all.end(), own.begin(), own.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&](size_t per_mille) {
+        return all[std::min(all.size() - 1, all.size() * per_mille / 1000)] / 1e3;
+    };
+    Result result;
+    result.seconds = (end_ns - start_ns) / 1e9;
+    result.steals = steals.load();
+    result.p50_us = percentile(500);
+    result.p99_us = percentile(990);
+    result.p999_us = percentile(999);
+    return result;
+}
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    options.workers = std::max(2u, std::thread::hardware_concurrency());
+    if (argc > 1) options.tasks = std::strtoul(argv[1], nullptr, 10);
+    if (argc > 2) options.workers = std::strtoul(argv[2], nullptr, 10);
+    if (argc > 3) options.burst = std::strtoul(argv[3], nullptr, 10);
+    if (argc > 4) options.window = std::strtoul(argv[4], nullptr, 10);
+    if (argc > 5) options.short_ns = std::strtol(argv[5], nullptr, 10) * 1000;
+    if (argc > 6) options.long_ns = std::strtol(argv[6], nullptr, 10) * 1000;
+    if (options.tasks == 0 || options.workers == 0 || options.burst == 0 || options.window == 0) {
+        std::fprintf(stderr, "Usage: %s [tasks] [workers] [burst] [window] [short_us] [long_us]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("%zu tasks, %zu workers, burst %zu, window %zu, %lld us tasks with every %zuth %lld us\n\n",
+                options.tasks, options.workers, options.burst, options.window,
+                static_cast<long long>(options.short_ns / 1000), LONG_TASK_EVERY,
+                static_cast<long long>(options.long_ns / 1000));
+    std::printf("%-16s %12s %10s %10s %10s %10s\n", "pool", "tasks/s", "steals", "p50 us", "p99 us", "p99.9 us");
+    auto print = [&](const char* label, const Result& result) {
+        std::printf("%-16s %12.0f %10zu %10.1f %10.1f %10.1f\n", label, options.tasks / result.seconds,
+                    result.steals, result.p50_us, result.p99_us, result.p999_us);
+    };
+    print("single queue", run_pool<SharedQueue>(options));
+    print("work stealing", run_pool<StealingQueues>(options));
+    return 0;
+}
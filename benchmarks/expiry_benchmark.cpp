@@ -0,0 +1,128 @@
+// expiry_benchmark.cpp
+// Cost of one expiry sweep, the time a shard lock is held for it. `sessions`
+// subscribers start their sessions spread evenly over one `timeout_ms`, then
+// the clock moves on by `tick_ms` for another timeout and a sweep runs at
+// every tick, so each sweep finds the sessions of one tick due; as many new
+// sessions are opened after each sweep, so the table keeps its size. The same
+// sweeps run over a std::unordered_map that is walked in full each time, as
+// the session table used to be, and over FlatSessionMap, which takes the due
+// sessions from its timing wheel. Prints the mean and the longest sweep of
+// each in microseconds.
+//
+// Usage: expiry_benchmark [sessions] [timeout_ms] [tick_ms]
+
+#include "server/flat_session_map.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    size_t sessions = 1000000;
+    long timeout_ms = 30000;
+    long tick_ms = 100;
+};
+
+struct Result {
+    double mean_us = 0;
+    double max_us = 0;
+    size_t expired = 0;
+};
+
+ImsiKey imsi_key(size_t n) {
+    return (ImsiKey{15} << 56) | (1010000000000ULL + n);
+}
+
+// Start of the n-th session, on a tick within the first timeout.
+Clock::time_point start_of(const Options& options, Clock::time_point epoch, size_t n) {
+    long ticks = options.timeout_ms / options.tick_ms;
+    return epoch + std::chrono::milliseconds(static_cast<long>(n * ticks / options.sessions) * options.tick_ms);
+}
+
+// Runs a sweep at every tick of the second timeout and times each one; the
+// refills after the sweeps are not timed.
+template <typename Sweep, typename Open>
+Result run_sweeps(const Options& options, Clock::time_point epoch, Sweep sweep, Open open) {
+    Result result;
+    long ticks = options.timeout_ms / options.tick_ms;
+    double total_us = 0;
+    for (long tick = ticks; tick <= 2 * ticks + 1; ++tick) {
+        auto now = epoch + std::chrono::milliseconds(tick * options.tick_ms);
+        auto start = Clock::now();
+        size_t expired = sweep(now);
+        double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        total_us += us;
+        result.max_us = std::max(result.max_us, us);
+        for (size_t i = 0; i < expired; ++i) {
+            open(imsi_key(options.sessions + result.expired + i), now);
+        }
+        result.expired += expired;
+    }
+    result.mean_us = total_us / (ticks + 2);
+    return result;
+}
+
+Result run_scan(const Options& options) {
+    auto epoch = Clock::now();
+    std::unordered_map<ImsiKey, Clock::time_point> sessions;
+    for (size_t i = 0; i < options.sessions; ++i) {
+        sessions.emplace(imsi_key(i), start_of(options, epoch, i));
+    }
+    auto timeout = std::chrono::milliseconds(options.timeout_ms);
+    return run_sweeps(options, epoch, [&](Clock::time_point now) {
+        size_t expired = 0;
+        for (auto it = sessions.begin(); it != sessions.end(); ) {
+            if (now - it->second > timeout) {
+                it = sessions.erase(it);
+                ++expired;
+            } else {
+                ++it;
+            }
+        }
+        return expired;
+    }, [&](ImsiKey imsi, Clock::time_point now) { sessions.emplace(imsi, now); });
+}
+
+Result run_wheel(const Options& options) {
+    auto epoch = Clock::now();
+    FlatSessionMap sessions(epoch, std::chrono::milliseconds(options.tick_ms));
+    for (size_t i = 0; i < options.sessions; ++i) {
+        sessions.open(imsi_key(i), start_of(options, epoch, i));
+    }
+    auto timeout = std::chrono::milliseconds(options.timeout_ms);
+    std::vector<ImsiKey> expired;
+    return run_sweeps(options, epoch, [&](Clock::time_point now) {
+        expired.clear();
+        sessions.expire(now, timeout, expired);
+        return expired.size();
+    }, [&](ImsiKey imsi, Clock::time_point now) { sessions.open(imsi, now); });
+}
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (argc > 1) options.sessions = std::strtoul(argv[1], nullptr, 10);
+    if (argc > 2) options.timeout_ms = std::strtol(argv[2], nullptr, 10);
+    if (argc > 3) options.tick_ms = std::strtol(argv[3], nullptr, 10);
+    if (options.sessions == 0 || options.sessions > 1000000000 || options.tick_ms <= 0 ||
+        options.timeout_ms < options.tick_ms || options.timeout_ms % options.tick_ms != 0) {
+        std::fprintf(stderr, "Usage: %s [sessions] [timeout_ms] [tick_ms], timeout_ms a multiple of tick_ms\n", argv[0]);
+        return 1;
+    }
+
+    Result scan = run_scan(options);
+    Result wheel = run_wheel(options);
+
+    std::printf("%zu sessions, timeout %ld ms, sweep every %ld ms\n\n", options.sessions, options.timeout_ms,
+                options.tick_ms);
+    std::printf("%-24s %12s %12s %10s\n", "table", "mean us", "longest us", "expired");
+    std::printf("%-24s %12.1f %12.1f %10zu\n", "unordered_map, full scan", scan.mean_us, scan.max_us, scan.expired);
+    std::printf("%-24s %12.1f %12.1f %10zu\n", "FlatSessionMap, wheel", wheel.mean_us, wheel.max_us, wheel.expired);
+    std::printf("\nThe longest sweep is %.1fx shorter with the wheel\n", scan.max_us / wheel.max_us);
+    return scan.expired == wheel.expired ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+// ingress_benchmark.cpp
+// Drives every IngressBackend with the same loopback load and prints pps,
+// CPU time of the receiving thread per packet and delivery latency side by
+// side. Each datagram carries its send time; the sender keeps at most
+// `window` datagrams in flight so the latency is not dominated by queueing.
+//
+// Usage: ingress_benchmark [packets] [window] [port]
+
+#include "server/ingress_backend.hpp"
+#include "server/socket_filters.hpp"
+#include <arpa/inet.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+namespace {
+constexpr size_t SEND_BURST = 32;
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t thread_cpu_ns() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+struct Result {
+    size_t sent = 0;
+    size_t received = 0;
+    double seconds = 0;
+    double cpu_ns_per_packet = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+};
+
+// Records the latency of every datagram and stops the backend once all
+// `expected` datagrams arrived.
+class LatencySink : public IngressSink {
+public:
+    LatencySink(int event_fd, size_t expected) : event_fd_(event_fd), expected_(expected) {
+        latencies_ns.reserve(expected);
+    }
+
+    void deliver(const Datagram* datagrams, size_t count, size_t /*capacity*/) override {
+        int64_t now = now_ns();
+        for (size_t i = 0; i < count; ++i) {
+            int64_t sent_at = 0;
+            if (datagrams[i].length < sizeof(sent_at)) continue;
+            std::memcpy(&sent_at, datagrams[i].data, sizeof(sent_at));
+            latencies_ns.push_back(now - sent_at);
+        }
+        last_ns = now;
+        received.store(latencies_ns.size(), std::memory_order_release);
+        if (latencies_ns.size() >= expected_) {
+            uint64_t signal = 1;
+            write(event_fd_, &signal, sizeof(signal));
+        }
+    }
+
+    std::atomic<size_t> received{0};
+    std::vector<int64_t> latencies_ns;
+    int64_t last_ns = 0;
+
+private:
+    int event_fd_;
+    size_t expected_;
+};
+
+bool run_backend(IngressBackend& backend, size_t packets, size_t window, uint16_t port, Result& result) {
+    int server_fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    int client_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int event_fd = eventfd(0, EFD_NONBLOCK);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    auto cleanup = [&] {
+        close(server_fd);
+        close(client_fd);
+        close(event_fd);
+    };
+    if (server_fd < 0 || client_fd < 0 || event_fd < 0 ||
+        bind(server_fd, (sockaddr*)&addr, sizeof(addr)) < 0 || !backend.open(server_fd, event_fd)) {
+        cleanup();
+        return false;
+    }
+    // Same as the server: a ring-fed reactor only sends on its UDP socket.
+    if (!backend.reads_socket()) {
+        attach_drop_all(server_fd);
+    }
+
+    LatencySink sink(event_fd, packets);
+    int64_t cpu_ns = 0;
+    std::thread receiver([&] {
+        int64_t cpu_start = thread_cpu_ns();
+        backend.serve(sink);
+        cpu_ns = thread_cpu_ns() - cpu_start;
+    });
+
+    std::vector<std::array<int64_t, 2>> payloads(SEND_BURST);
+    std::vector<mmsghdr> msgs(SEND_BURST);
+    std::vector<iovec> iovecs(SEND_BURST);
+    for (size_t i = 0; i < SEND_BURST; ++i) {
+        iovecs[i] = {payloads[i].data(), sizeof(payloads[i])};
+        msgs[i].msg_hdr = {};
+        msgs[i].msg_hdr.msg_iov = &iovecs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &addr;
+        msgs[i].msg_hdr.msg_namelen = sizeof(addr);
+    }
+
+    int64_t start_ns = now_ns();
+    int64_t progress_ns = start_ns;
+    size_t last_received = 0;
+    size_t sent = 0;
+    while (sent < packets) {
+        size_t received = sink.received.load(std::memory_order_acquire);
+        if (received != last_received) {
+            last_received = received;
+            progress_ns = now_ns();
+        }
+        // Datagrams lost in the kernel never come back: give up after a second without progress.
+        if (now_ns() - progress_ns > 1000000000) break;
+
+        size_t burst = std::min({SEND_BURST, packets - sent, window - std::min(window, sent - received)});
+        if (burst == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        int64_t stamp = now_ns();
+        for (size_t i = 0; i < burst; ++i) {
+            payloads[i] = {stamp, static_cast<int64_t>(sent + i)};
+        }
+        int n = sendmmsg(client_fd, msgs.data(), burst, 0);
+        if (n > 0) sent += n;
+    }
+
+    // Wait for the tail, then stop the backend if it is still short of datagrams.
+    int64_t deadline = now_ns() + 1000000000;
+    while (sink.received.load(std::memory_order_acquire) < sent && now_ns() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    uint64_t signal = 1;
+    write(event_fd, &signal, sizeof(signal));
+    receiver.join();
+    cleanup();
+
+    result.sent = sent;
+    result.received = sink.latencies_ns.size();
+    if (result.received == 0) return true;
+
+    result.seconds = (sink.last_ns - start_ns) / 1e9;
+    result.cpu_ns_per_packet = static_cast<double>(cpu_ns) / result.received;
+    std::vector<int64_t>& latencies = sink.latencies_ns;
+    std::sort(latencies.begin(), latencies.end());
+    result.p50_us = latencies[latencies.size() / 2] / 1e3;
+    result.p99_us = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)] / 1e3;
+    return true;
+}
+}
+
+int main(int argc, char* argv[]) {
+    size_t packets = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    size_t window = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256;
+    uint16_t port = argc > 3 ? static_cast<uint16_t>(std::strtoul(argv[3], nullptr, 10)) : 9896;
+    if (packets == 0 || window == 0) {
+        std::fprintf(stderr, "Usage: %s [packets] [window] [port]\n", argv[0]);
+        return 1;
+    }
+    spdlog::set_level(spdlog::level::warn);
+
+    struct Backend {
+        const char* label;
+        std::function<std::unique_ptr<IngressBackend>()> make;
+    };
+    const std::vector<Backend> backends = {
+        {"epoll", [] { return std::make_unique<EpollBackend>(1); }},
+        {"epoll+recvmmsg", [] { return std::make_unique<EpollBackend>(32); }},
+        {"io_uring", [] { return std::make_unique<IoUringBackend>(32); }},
+        {"packet_mmap", [port] { return std::make_unique<PacketRingBackend>("lo", "127.0.0.1", port); }},
+    };
+
+    std::printf("%zu datagrams over 127.0.0.1:%u, window %zu\n\n", packets, port, window);
+    std::printf("%-16s %10s %10s %12s %12s %10s %10s\n",
+                "backend", "received", "lost", "pps", "cpu ns/pkt", "p50 us", "p99 us");
+    for (const auto& backend : backends) {
+        auto instance = backend.make();
+        Result result;
+        if (!run_backend(*instance, packets, window, port, result)) {
+            std::printf("%-16s %10s\n", backend.label, "unavailable");
+            continue;
+        }
+        double pps = result.seconds > 0 ? result.received / result.seconds : 0;
+        std::printf("%-16s %10zu %10zu %12.0f %12.0f %10.1f %10.1f\n", backend.label, result.received,
+                    result.sent - result.received, pps, result.cpu_ns_per_packet, result.p50_us, result.p99_us);
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+// session_benchmark.cpp
+// Contention on the session table: 1, 2, 4, ... up to `max_threads` threads
+// open sessions and ask whether IMSIs have one (`lookup_percent` of the
+// operations, like /check_subscriber) over `sessions` subscribers, half of
+// which have a session when the run starts. The same load, on packed IMSI
+// keys, runs against one map behind one mutex, the table before it was
+// sharded, and against ShardedSessionTable with `shards` shards. Prints millions of operations
+// per second for each and how much faster the sharded table is.
+//
+// Usage: session_benchmark [ops_per_thread] [max_threads] [sessions] [shards] [lookup_percent]
+
+#include "server/session_store.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    size_t ops = 200000;
+    size_t max_threads = 32;
+    size_t sessions = 100000;
+    size_t shards = ShardedSessionTable::DEFAULT_SHARDS;
+    unsigned lookup_percent = 50;
+};
+
+// The session table before sharding: every thread takes the same lock.
+class GlobalSessionTable {
+public:
+    explicit GlobalSessionTable(size_t /*shards*/) {}
+
+    bool active(ImsiKey imsi) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sessions_.contains(imsi);
+    }
+
+    bool open(ImsiKey imsi, Clock::time_point now) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sessions_.open(imsi, now);
+    }
+
+private:
+    std::mutex mutex_;
+    FlatSessionMap sessions_;
+};
+
+std::vector<ImsiKey> make_imsis(size_t count) {
+    std::vector<ImsiKey> imsis;
+    imsis.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string digits = std::to_string(i);
+        imsis.push_back(pack_imsi("00101" + std::string(10 - digits.size(), '0') + digits));
+    }
+    return imsis;
+}
+
+uint64_t next_random(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// Millions of operations per second over all threads.
+template <typename Table>
+double run(const Options& options, const std::vector<ImsiKey>& imsis, size_t threads) {
+    Table table(options.shards);
+    auto now = Clock::now();
+    for (size_t i = 0; i < imsis.size(); i += 2) {
+        table.open(imsis[i], now);
+    }
+
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::atomic<size_t> found{0};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            uint64_t state = 0x9e3779b97f4a7c15ULL * (t + 1);
+            size_t hits = 0;
+            ++ready;
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (size_t i = 0; i < options.ops; ++i) {
+                ImsiKey imsi = imsis[next_random(state) % imsis.size()];
+                if (next_random(state) % 100 < options.lookup_percent) {
+                    hits += table.active(imsi);
+                } else {
+                    hits += table.open(imsi, Clock::now());
+                }
+            }
+            found += hits;
+        });
+    }
+    while (ready.load() < threads) {
+        std::this_thread::yield();
+    }
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return threads * options.ops / seconds / 1e6;
+}
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (argc > 1) options.ops = std::strtoul(argv[1], nullptr, 10);
+    if (argc > 2) options.max_threads = std::strtoul(argv[2], nullptr, 10);
+    if (argc > 3) options.sessions = std::strtoul(argv[3], nullptr, 10);
+    if (argc > 4) options.shards = std::strtoul(argv[4], nullptr, 10);
+    if (argc > 5) options.lookup_percent = std::strtoul(argv[5], nullptr, 10);
+    if (options.ops == 0 || options.max_threads == 0 || options.sessions == 0 || options.shards == 0 ||
+        options.lookup_percent > 100) {
+        std::fprintf(stderr, "Usage: %s [ops_per_thread] [max_threads] [sessions] [shards] [lookup_percent]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<ImsiKey> imsis = make_imsis(options.sessions);
+    std::printf("%zu operations per thread over %zu IMSIs, %u%% lookups, %zu shards, %u CPUs\n\n",
+                options.ops, options.sessions, options.lookup_percent, options.shards,
+                std::thread::hardware_concurrency());
+    std::printf("%8s %14s %14s %8s\n", "threads", "global Mops/s", "sharded Mops/s", "speedup");
+    for (size_t threads = 1; threads <= options.max_threads; threads *= 2) {
+        double global = run<GlobalSessionTable>(options, imsis, threads);
+        double sharded = run<ShardedSessionTable>(options, imsis, threads);
+        std::printf("%8zu %14.2f %14.2f %7.2fx\n", threads, global, sharded, sharded / global);
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+// session_memory_benchmark.cpp
+// Memory of the session table: `sessions` subscribers get a session in the
+// map the server used before, std::unordered_map from IMSI digits to a
+// time point, and in FlatSessionMap keyed by packed IMSI. The heap taken by
+// each is read from mallinfo2 before and after filling it. Prints bytes per
+// session, how many times less FlatSessionMap takes, and the nanoseconds per
+// open and per lookup (`lookups` of them, half for IMSIs with no session).
+//
+// Usage: session_memory_benchmark [sessions] [lookups]
+
+#include "server/flat_session_map.hpp"
+#include <malloc.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    double bytes_per_session = 0;
+    double open_ns = 0;
+    double lookup_ns = 0;
+    size_t found = 0;
+};
+
+size_t heap_in_use() {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+// Writes the n-th test IMSI, 00101 and ten digits, into `digits`.
+void write_imsi(size_t n, char* digits) {
+    for (int i = 14; i >= 5; --i) {
+        digits[i] = static_cast<char>('0' + n % 10);
+        n /= 10;
+    }
+}
+
+std::string imsi_string(size_t n) {
+    std::string digits = "001010000000000";
+    write_imsi(n, digits.data());
+    return digits;
+}
+
+ImsiKey imsi_key(size_t n) {
+    return pack_imsi(imsi_string(n));
+}
+
+uint64_t next_random(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+double ns_per(Clock::time_point start, size_t count) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+}
+
+// Key is how each table is asked: digits for the old map, a packed key for
+// the new one. Building the key is timed as part of each operation.
+template <typename Table, typename Open, typename Find, typename Key>
+Result measure(size_t sessions, size_t lookups, Open open, Find find, Key key) {
+    Result result;
+    size_t before = heap_in_use();
+    {
+        Table table;
+        auto now = Clock::now();
+        auto start = Clock::now();
+        for (size_t i = 0; i < sessions; ++i) {
+            open(table, key(i), now);
+        }
+        result.open_ns = ns_per(start, sessions);
+        result.bytes_per_session = static_cast<double>(heap_in_use() - before) / sessions;
+
+        uint64_t state = 0x9e3779b97f4a7c15ULL;
+        start = Clock::now();
+        for (size_t i = 0; i < lookups; ++i) {
+            result.found += find(table, key(next_random(state) % (2 * sessions)));
+        }
+        result.lookup_ns = ns_per(start, lookups);
+    }
+    return result;
+}
+}
+
+int main(int argc, char* argv[]) {
+    size_t sessions = 10000000;
+    size_t lookups = 10000000;
+    if (argc > 1) sessions = std::strtoul(argv[1], nullptr, 10);
+    if (argc > 2) lookups = std::strtoul(argv[2], nullptr, 10);
+    if (sessions == 0 || sessions > 5000000000ULL || lookups == 0) {
+        std::fprintf(stderr, "Usage: %s [sessions] [lookups]\n", argv[0]);
+        return 1;
+    }
+
+    using StringMap = std::unordered_map<std::string, Clock::time_point>;
+    Result strings = measure<StringMap>(
+        sessions, lookups,
+        [](StringMap& table, std::string imsi, Clock::time_point now) { table.try_emplace(std::move(imsi), now); },
+        [](StringMap& table, const std::string& imsi) { return table.count(imsi) > 0; },
+        imsi_string);
+    Result flat = measure<FlatSessionMap>(
+        sessions, lookups,
+        [](FlatSessionMap& table, ImsiKey imsi, Clock::time_point now) { table.open(imsi, now); },
+        [](FlatSessionMap& table, ImsiKey imsi) { return table.contains(imsi); },
+        imsi_key);
+
+    std::printf("%zu sessions, %zu lookups\n\n", sessions, lookups);
+    std::printf("%-28s %14s %10s %10s %8s\n", "table", "bytes/session", "open ns", "lookup ns", "found");
+    std::printf("%-28s %14.1f %10.1f %10.1f %8zu\n", "unordered_map<string, time>",
+                strings.bytes_per_session, strings.open_ns, strings.lookup_ns, strings.found);
+    std::printf("%-28s %14.1f %10.1f %10.1f %8zu\n", "FlatSessionMap",
+                flat.bytes_per_session, flat.open_ns, flat.lookup_ns, flat.found);
+    std::printf("\nFlatSessionMap takes %.1fx less memory\n", strings.bytes_per_session / flat.bytes_per_session);
+    return strings.found == flat.found ? 0 : 1;
+}
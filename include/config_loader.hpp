@@ -14,6 +14,52 @@ struct ServerConfig {
     int session_timeout_sec;
     std::string cdr_file;
     std::vector<std::string> blacklist;
+    int recv_batch_size = 32;
+    int send_batch_size = 32;
+    std::string send_flush = "end_of_batch";
+    int reactor_count = 1;
+    std::string reactor_steering = "flow";
+    bool socket_filter = false;
+    std::string io_backend = "epoll";
+    std::string packet_interface;
+    std::string dispatch_mode = "worker_pool";
+    int socket_rcvbuf = 0;
+    int socket_sndbuf = 0;
+    int spin_budget_us = 0;
+    int busy_poll_us = 0;
+    int rate_limit_ip_rate = 0;
+    int rate_limit_ip_burst = 64;
+    int rate_limit_imsi_rate = 0;
+    int rate_limit_imsi_burst = 8;
+    int rate_limit_table_size = 65536;
+    int rate_limit_idle_sec = 60;
+    int queue_capacity = 65536;
+    std::string queue_policy = "tail_drop";
+    int codel_target_us = 5000;
+    int codel_interval_us = 100000;
+    // 0 sizes the pool from the CPU budget of the process.
+    int worker_count = 0;
+    // Tasks a worker takes and resolves at once.
+    int worker_batch_size = 32;
+    // Shards of the session table, each with its own lock.
+    int session_shards = 64;
+    // Tick of the session timing wheels: the expiry granularity and how often the cleaner runs.
+    int session_tick_ms = 1000;
+    // 0 keeps session_timeout_sec; otherwise the session timeout in milliseconds, which may be under a second.
+    int session_timeout_ms = 0;
+    // worker_pool only: the pool grows and shrinks between elastic_min_workers and
+    // elastic_max_workers (0 = worker_count, or the CPU budget) with the queue pressure.
+    bool elastic_workers = false;
+    int elastic_min_workers = 1;
+    int elastic_max_workers = 0;
+    int elastic_grow_sojourn_us = 1000;
+    int elastic_shrink_sojourn_us = 100;
+    int elastic_shrink_after_sec = 10;
+    // CPUs each thread role is pinned to, parsed from lists like "0-3,8"; empty leaves the role unpinned.
+    std::vector<int> reactor_cpus;
+    std::vector<int> worker_cpus;
+    std::vector<int> cleaner_cpus;
+    std::vector<int> http_cpus;
 };
 
 struct ClientConfig {
@@ -31,4 +77,11 @@ void run_udp_server(const ServerConfig& config);
 
 bool is_valid_ip(const std::string& ip);
 bool is_valid_log_level(const std::string& level);
+bool is_valid_send_flush(const std::string& mode);
+bool is_valid_reactor_steering(const std::string& mode);
+bool is_valid_io_backend(const std::string& backend);
+bool is_valid_dispatch_mode(const std::string& mode);
+bool is_valid_queue_policy(const std::string& policy);
+// Parses a CPU list in the kernel's cpuset format ("0-3,8") into sorted CPU numbers.
+bool parse_cpu_list(const std::string& list, std::vector<int>& cpus);
 void validate_blacklist(const std::vector<std::string>& blacklist);
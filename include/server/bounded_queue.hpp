@@ -0,0 +1,133 @@
+#pragma once
+
+#include "mpmc_ring.hpp"
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <utility>
+
+// bounded_queue.hpp
+// Task queue with a capacity and an overload policy, on a lock-free MpmcRing:
+// the reactor pushes and its workers pop without a mutex.
+
+enum class OverloadPolicy {
+    TailDrop,    // a full queue refuses new items
+    DropOldest,  // a full queue discards its head to make room
+    CoDel        // tail drop when full, plus CoDel drops on time spent queued
+};
+
+// Parses the queue_policy config value; false for an unknown name.
+bool parse_overload_policy(const std::string& name, OverloadPolicy& policy);
+
+struct QueueLimits {
+    size_t capacity = 65536;
+    OverloadPolicy policy = OverloadPolicy::TailDrop;
+    std::chrono::nanoseconds codel_target = std::chrono::milliseconds(5);
+    std::chrono::nanoseconds codel_interval = std::chrono::milliseconds(100);
+};
+
+// Controlled Delay (RFC 8289) decision for each item leaving the queue. Once
+// the sojourn time has stayed above `target` for a whole `interval`, items
+// are dropped at intervals that shrink with the square root of the drop
+// count, until the sojourn time falls back below the target.
+class CoDel {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CoDel(std::chrono::nanoseconds target, std::chrono::nanoseconds interval);
+
+    // `queue_empty` tells whether the item was the last one queued.
+    bool should_drop(std::chrono::nanoseconds sojourn, Clock::time_point now, bool queue_empty);
+
+    bool dropping() const { return dropping_; }
+
+private:
+    bool above_target(std::chrono::nanoseconds sojourn, Clock::time_point now, bool queue_empty);
+    Clock::time_point control_law(Clock::time_point from) const;
+
+    std::chrono::nanoseconds target_;
+    std::chrono::nanoseconds interval_;
+    Clock::time_point first_above_{};
+    Clock::time_point drop_next_{};
+    size_t count_ = 0;
+    size_t last_count_ = 0;
+    bool dropping_ = false;
+};
+
+// What one consumer of a BoundedQueue keeps between pops. Each worker runs
+// its own CoDel over the tasks it takes, so the decision needs no shared state.
+struct QueueConsumer {
+    explicit QueueConsumer(const QueueLimits& limits) : codel(limits.codel_target, limits.codel_interval) {}
+
+    CoDel codel;
+    // Tasks CoDel discarded, accumulated until the caller resets it.
+    size_t dropped = 0;
+    // Time the last popped (or CoDel-dropped) task spent in the queue.
+    std::chrono::nanoseconds last_sojourn{0};
+};
+
+template <typename T>
+class BoundedQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class PushResult {
+        Queued,
+        DroppedOldest,  // queued after discarding the head
+        Rejected        // full, the item was not queued
+    };
+
+    // The capacity is exact while one thread pushes; concurrent producers may
+    // overshoot it up to the ring's power of two. A zero capacity refuses everything.
+    explicit BoundedQueue(const QueueLimits& limits)
+        : policy_(limits.policy), capacity_(limits.capacity), ring_(limits.capacity) {}
+
+    // Safe from any thread. With drop_oldest the producer takes the head itself.
+    PushResult push(T&& item, Clock::time_point now) {
+        Entry entry{std::move(item), now};
+        if (!full() && ring_.try_push(std::move(entry))) return PushResult::Queued;
+        if (policy_ != OverloadPolicy::DropOldest || capacity_ == 0) return PushResult::Rejected;
+
+        Entry oldest;
+        bool dropped = ring_.try_pop(oldest);
+        if (!ring_.try_push(std::move(entry))) return PushResult::Rejected;
+        return dropped ? PushResult::DroppedOldest : PushResult::Queued;
+    }
+
+    // Takes the head into `item` unless the queue is empty. With CoDel the
+    // items discarded on the way are added to consumer.dropped.
+    bool pop(T& item, Clock::time_point now, QueueConsumer& consumer) {
+        Entry entry;
+        while (ring_.try_pop(entry)) {
+            consumer.last_sojourn = now - entry.enqueued;
+            bool drop = policy_ == OverloadPolicy::CoDel &&
+                        consumer.codel.should_drop(consumer.last_sojourn, now, ring_.empty());
+            if (!drop) {
+                item = std::move(entry.item);
+                return true;
+            }
+            ++consumer.dropped;
+        }
+        return false;
+    }
+
+    // True when push() would refuse the next item, so the caller can skip building it.
+    bool rejects_push() const {
+        return full() && (policy_ != OverloadPolicy::DropOldest || capacity_ == 0);
+    }
+
+    bool full() const { return ring_.size() >= capacity_; }
+    bool empty() const { return ring_.empty(); }
+    size_t size() const { return ring_.size(); }
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct Entry {
+        T item{};
+        Clock::time_point enqueued{};
+    };
+
+    OverloadPolicy policy_;
+    size_t capacity_;
+    MpmcRing<Entry> ring_;
+};
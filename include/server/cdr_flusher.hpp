@@ -0,0 +1,70 @@
+#pragma once
+
+#include "cdr_writer.hpp"
+#include "coro_executor.hpp"
+#include "futex_event.hpp"
+#include <coroutine>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// cdr_flusher.hpp
+// Appends CDRs on a thread of its own so that coroutines never block on the
+// file. A coroutine hands over its records with co_await flush(...) and is
+// resumed on its executor once they are in the file. Everything handed over
+// while the previous append ran goes out in the next one, so under load
+// many coroutines share one open and write of the file.
+class CdrFlusher {
+public:
+    explicit CdrFlusher(CdrWriter& writer);
+    ~CdrFlusher();
+
+    // Starts the flusher thread, named `name` and pinned to `cpus`.
+    void start(const std::string& name, const std::vector<int>& cpus);
+    // Writes whatever is still handed over, then joins the thread.
+    void stop();
+
+    class FlushAwaiter;
+    // `records` must stay alive until the coroutine is resumed. Without a
+    // running flusher they are written on the calling thread.
+    FlushAwaiter flush(CoroExecutor& executor, const std::vector<CdrRecord>& records);
+
+private:
+    struct Pending {
+        const std::vector<CdrRecord>* records;
+        CoroExecutor* executor;
+        std::coroutine_handle<> handle;
+    };
+
+    bool hand_over(const Pending& pending);
+    void run();
+
+    CdrWriter& writer_;
+    std::thread thread_;
+    std::mutex mutex_;
+    bool running_ = false;
+    std::vector<Pending> pending_;
+    FutexEvent work_ready_;
+};
+
+class CdrFlusher::FlushAwaiter {
+public:
+    FlushAwaiter(CdrFlusher& flusher, CoroExecutor& executor, const std::vector<CdrRecord>& records)
+        : flusher_(flusher), executor_(executor), records_(records) {}
+
+    bool await_ready() const { return records_.empty(); }
+    bool await_suspend(std::coroutine_handle<> handle) {
+        return flusher_.hand_over({&records_, &executor_, handle});
+    }
+    void await_resume() const {}
+
+private:
+    CdrFlusher& flusher_;
+    CoroExecutor& executor_;
+    const std::vector<CdrRecord>& records_;
+};
+
+inline CdrFlusher::FlushAwaiter CdrFlusher::flush(CoroExecutor& executor, const std::vector<CdrRecord>& records) {
+    return FlushAwaiter(*this, executor, records);
+}
@@ -5,9 +5,15 @@
 #include <sstream>
 #include <chrono>
 #include <iomanip>
+#include <vector>
 #include <spdlog/spdlog.h>
 
 // cdr_writer.hpp
+struct CdrRecord {
+    std::string imsi;
+    std::string action;
+};
+
 class CdrWriter {
 public:
     explicit CdrWriter(const std::string& cdr_file);
@@ -17,6 +23,8 @@ public:
 #endif
 
     void write(const std::string& imsi, const std::string& action);
+    // Appends every record with one open of the file and one timestamp.
+    void write(const std::vector<CdrRecord>& records);
 
 private:
     std::string cdr_file_;
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "udp_batch.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <netinet/in.h>
+
+// client_task.hpp
+// A datagram handed from a reactor to its workers. The payload is stored
+// inline, so a task is a fixed-size value that lives in a cell of the task
+// ring: the cells are allocated once with the queue and reused for every
+// datagram, and queueing or taking a task never touches the heap.
+struct ClientTask {
+    // Longest payload any queueing backend delivers.
+    static constexpr size_t MAX_PAYLOAD = UdpRecvBatch::MAX_DATAGRAM_SIZE;
+
+    ClientTask() = default;
+
+    // Bytes past MAX_PAYLOAD are cut off.
+    ClientTask(int sockfd, const sockaddr_in& client_addr, const uint8_t* data, size_t length)
+        : sockfd(sockfd), client_addr(client_addr), length(std::min(length, MAX_PAYLOAD)) {
+        std::memcpy(payload.data(), data, this->length);
+    }
+
+    const uint8_t* data() const { return payload.data(); }
+
+    int sockfd = -1;
+    sockaddr_in client_addr{};
+    size_t length = 0;
+    std::array<uint8_t, MAX_PAYLOAD> payload{};
+};
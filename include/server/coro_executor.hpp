@@ -0,0 +1,181 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// coro_executor.hpp
+// A single-threaded executor for C++20 coroutines driven by epoll. A
+// coroutine that waits for a socket, a timer or work done on another thread
+// suspends instead of blocking: the executor thread goes on with the other
+// coroutines and resumes it from its epoll loop once the wait is over.
+
+class CoroExecutor;
+
+// A coroutine run by a CoroExecutor. It starts only once spawned and frees
+// its frame when it finishes; nothing waits for its result.
+class CoroTask {
+public:
+    struct promise_type {
+        CoroExecutor* executor = nullptr;
+
+        CoroTask get_return_object() {
+            return CoroTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept { return FinalAwaiter{}; }
+        void return_void() {}
+        // Logged; the task ends as if it returned.
+        void unhandled_exception();
+    };
+
+    CoroTask(CoroTask&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    CoroTask(const CoroTask&) = delete;
+    CoroTask& operator=(const CoroTask&) = delete;
+    ~CoroTask() {
+        if (handle_) handle_.destroy();
+    }
+
+private:
+    friend class CoroExecutor;
+
+    // Frees the frame and tells the executor that one task fewer is alive.
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+        void await_resume() const noexcept {}
+    };
+
+    explicit CoroTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+class CoroExecutor {
+public:
+    CoroExecutor() = default;
+    ~CoroExecutor();
+    CoroExecutor(const CoroExecutor&) = delete;
+    CoroExecutor& operator=(const CoroExecutor&) = delete;
+
+    // Creates the epoll instance with its wake-up eventfd and timerfd.
+    bool open();
+
+    // Executor thread only. Runs the task on the calling thread until its
+    // first suspension; the executor owns it from then on.
+    void spawn(CoroTask task);
+
+    // Any thread: resumes the coroutine on the executor thread.
+    void post(std::coroutine_handle<> handle);
+
+    // Runs until `stop_fd` becomes readable (it is left unread, like the
+    // shutdown eventfd in the ingress backends) or stop() is called, and then
+    // until every task has finished. Waits on file descriptors end at once
+    // from then on; timers and posted resumptions still complete. Returns
+    // true after `stop_fd` fired, false after stop() or an epoll failure.
+    bool run(int stop_fd = -1);
+
+    // Executor thread only: ends run() as if `stop_fd` fired, but returns false.
+    void stop();
+
+    bool stopping() const { return stopping_; }
+    // Tasks spawned and not finished yet.
+    size_t tasks() const { return tasks_; }
+
+    class ReadableAwaiter;
+    class SleepAwaiter;
+
+    // co_await readable(fd) suspends until `fd` is readable and returns true,
+    // or false once the executor is stopping.
+    ReadableAwaiter readable(int fd);
+    // co_await sleep_for(d) resumes after `d` at the earliest.
+    SleepAwaiter sleep_for(std::chrono::nanoseconds duration);
+
+private:
+    friend class CoroTask;
+    using Clock = std::chrono::steady_clock;
+
+    struct Timer {
+        Clock::time_point deadline;
+        std::coroutine_handle<> handle;
+        bool operator>(const Timer& other) const { return deadline > other.deadline; }
+    };
+
+    bool watch(ReadableAwaiter& awaiter);
+    void add_timer(Clock::time_point deadline, std::coroutine_handle<> handle);
+    void arm_timer();
+    void fire_timers();
+    void resume_posted();
+    void cancel_waits();
+    void finished() { --tasks_; }
+
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    int timer_fd_ = -1;
+    int stop_fd_ = -1;
+    bool stopping_ = false;
+    bool stopped_ = false;
+    size_t tasks_ = 0;
+    // Coroutines suspended in readable(), resumed by their epoll event.
+    std::unordered_set<ReadableAwaiter*> waiting_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    Clock::time_point armed_ = Clock::time_point::max();
+    // Filled by post() from other threads; the eventfd is written only when
+    // it was empty, so a burst of completions costs one wake-up.
+    std::mutex posted_mutex_;
+    std::vector<std::coroutine_handle<>> posted_;
+    std::vector<std::coroutine_handle<>> resuming_;
+};
+
+class CoroExecutor::ReadableAwaiter {
+public:
+    ReadableAwaiter(CoroExecutor& executor, int fd) : executor_(executor), fd_(fd) {}
+
+    bool await_ready() const { return executor_.stopping_; }
+    bool await_suspend(std::coroutine_handle<> handle) {
+        handle_ = handle;
+        return executor_.watch(*this);
+    }
+    bool await_resume() const { return ready_; }
+
+private:
+    friend class CoroExecutor;
+
+    CoroExecutor& executor_;
+    int fd_;
+    bool ready_ = false;
+    std::coroutine_handle<> handle_;
+};
+
+class CoroExecutor::SleepAwaiter {
+public:
+    SleepAwaiter(CoroExecutor& executor, Clock::time_point deadline) : executor_(executor), deadline_(deadline) {}
+
+    bool await_ready() const { return Clock::now() >= deadline_; }
+    void await_suspend(std::coroutine_handle<> handle) { executor_.add_timer(deadline_, handle); }
+    void await_resume() const {}
+
+private:
+    CoroExecutor& executor_;
+    Clock::time_point deadline_;
+};
+
+inline void CoroTask::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+    CoroExecutor* executor = handle.promise().executor;
+    handle.destroy();
+    if (executor) executor->finished();
+}
+
+inline CoroExecutor::ReadableAwaiter CoroExecutor::readable(int fd) {
+    return ReadableAwaiter(*this, fd);
+}
+
+inline CoroExecutor::SleepAwaiter CoroExecutor::sleep_for(std::chrono::nanoseconds duration) {
+    return SleepAwaiter(*this, Clock::now() + duration);
+}
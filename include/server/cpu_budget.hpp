@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+
+// cpu_budget.hpp
+// How many CPUs the server may actually use. In a container
+// std::thread::hardware_concurrency() reports every core of the host, while
+// the cgroup v2 CPU quota (cpu.max) and cpuset allow far fewer; a pool sized
+// by the host gets throttled. Each limit is 0 when it is absent or unreadable.
+struct CpuBudget {
+    // std::thread::hardware_concurrency().
+    unsigned hardware = 0;
+    // CPUs in the affinity mask of the process (sched_getaffinity).
+    unsigned affinity = 0;
+    // CPUs in cpuset.cpus.effective of the process's cgroup.
+    unsigned cpuset = 0;
+    // Tightest quota / period of cpu.max on the way from the cgroup to the root, in CPUs.
+    double quota = 0;
+
+    // The smallest of the limits, the quota rounded up, and at least 1.
+    unsigned cpus() const;
+    // "cpu.max 2.5, cpuset 4, affinity 4, hardware 64" with "-" for absent limits.
+    std::string describe() const;
+};
+
+// Reads the limits of the calling process. The paths are parameters so the
+// cgroup tree can be mocked in tests.
+CpuBudget detect_cpu_budget(const std::string& cgroup_mount = "/sys/fs/cgroup",
+                            const std::string& proc_self_cgroup = "/proc/self/cgroup");
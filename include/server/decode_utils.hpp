@@ -3,8 +3,33 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <cstddef>
+
+// An IMSI packed into 64 bits: its digits as a decimal number in the low 56
+// bits and their count in the top byte, so leading zeros are kept. A
+// 15-digit IMSI needs 50 bits. 0 is no IMSI. Sessions, the blacklist and the
+// worker queues use keys; digits are only spelled out for logs, CDRs and HTTP.
+using ImsiKey = uint64_t;
+
+constexpr size_t MAX_IMSI_DIGITS = 15;
+
+inline size_t imsi_digits(ImsiKey key) { return key >> 56; }
+
+// 0 unless `digits` holds 1-15 decimal digits and nothing else.
+ImsiKey pack_imsi(const std::string& digits);
+// The digits of a key from pack_imsi; empty for 0.
+std::string unpack_imsi(ImsiKey key);
 
 class BcdDecoder {
 public:
     std::string decode(const std::vector<uint8_t>& bcd) const;
+    std::string decode(const uint8_t* bcd, size_t len) const;
+
+    // Hash of the decoded IMSI: hash(bcd, len) == hash(decode(bcd, len)),
+    // but the BCD form is hashed without building the string.
+    uint64_t hash(const uint8_t* bcd, size_t len) const;
+    uint64_t hash(const std::string& imsi) const;
+
+    // pack(bcd, len) == pack_imsi(decode(bcd, len)), without building the string.
+    ImsiKey pack(const uint8_t* bcd, size_t len) const;
 };
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+// elastic_policy.hpp
+// How many workers a reactor runs in the elastic pool. Once a second the
+// policy sees how many tasks are queued and the longest time a task waited
+// in the queue since the previous sample. The pool grows by half as soon as
+// one sample is hot, so an attach storm is met within a few seconds, and
+// shrinks by one worker only after `shrink_after` calm samples in a row.
+// The gap between the two thresholds and the streak keep it from flapping.
+struct ElasticLimits {
+    size_t min_workers = 1;
+    size_t max_workers = 1;
+    // Hot: a task waited longer than this, or more than `grow_depth` tasks per worker are queued.
+    std::chrono::nanoseconds grow_sojourn{std::chrono::milliseconds(1)};
+    size_t grow_depth = 32;
+    // Calm: no task waited longer than this and less than one task per worker is queued.
+    std::chrono::nanoseconds shrink_sojourn{std::chrono::microseconds(100)};
+    int shrink_after = 10;
+};
+
+class ElasticPolicy {
+public:
+    // `workers` is clamped to the limits.
+    ElasticPolicy(const ElasticLimits& limits, size_t workers);
+
+    size_t workers() const { return workers_; }
+
+    // Takes one sample and returns the number of workers to run from now on.
+    size_t update(size_t depth, std::chrono::nanoseconds peak_sojourn);
+
+private:
+    ElasticLimits limits_;
+    size_t workers_;
+    int calm_samples_ = 0;
+};
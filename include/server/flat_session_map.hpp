@@ -0,0 +1,75 @@
+#pragma once
+
+#include "decode_utils.hpp"
+#include "timing_wheel.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// flat_session_map.hpp
+// Sessions keyed by packed IMSI in flat arrays, found by linear probing:
+// no node, no string and no pointer per session. The keys are probed in an
+// array of their own, eight to a cache line; the start of each session sits
+// at the same index in a second array as a 32-bit tick. A removal shifts the
+// rest of its probe run back instead of leaving a tombstone. Every session
+// also has an entry in a TimingWheel, its slot at its start tick, so expiry
+// visits only the sessions that are due; a session moved to another slot, by
+// a removal or by growth, is scheduled again there. A third array keeps how
+// far into its start tick each session started, so ages are not rounded to ticks.
+class FlatSessionMap {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::milliseconds DEFAULT_TICK{1000};
+
+    // Starts are kept as 32-bit ticks since `epoch`, modulo 2^32, so ages
+    // are exact up to 2^31 ticks (24 days at 1 ms) whatever the uptime.
+    explicit FlatSessionMap(Clock::time_point epoch = Clock::now(), std::chrono::milliseconds tick = DEFAULT_TICK);
+
+    // Opens a session started at `now` unless the IMSI has one already,
+    // which is left as it is. True when the session was opened.
+    bool open(ImsiKey imsi, Clock::time_point now);
+    // Opens the session, or moves its start to `started`.
+    void insert(ImsiKey imsi, Clock::time_point started);
+    bool contains(ImsiKey imsi) const;
+
+    // Removes the sessions at least one tick older than `timeout` rounded up
+    // to ticks, and appends their IMSIs to `expired`. With a 1-second tick
+    // and a timeout in seconds that is duration_cast<seconds>(age) > timeout.
+    void expire(Clock::time_point now, std::chrono::milliseconds timeout, std::vector<ImsiKey>& expired);
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return keys_.size(); }
+    std::chrono::milliseconds tick() const { return std::chrono::duration_cast<std::chrono::milliseconds>(tick_); }
+    // Bytes held by the arrays and the timing wheel.
+    size_t memory() const {
+        return keys_.capacity() * sizeof(ImsiKey) + started_.capacity() * sizeof(uint32_t) +
+               phase_.capacity() * sizeof(uint16_t) + wheel_.memory();
+    }
+
+private:
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    size_t slot_of(ImsiKey imsi) const;
+    // The slot holding `imsi`, or the empty slot ending its probe run.
+    size_t find(ImsiKey imsi) const;
+    uint32_t stamp(Clock::time_point time) const;
+    uint16_t phase(Clock::time_point time) const;
+    size_t place(ImsiKey imsi, uint32_t started, uint16_t phase);
+    void grow();
+    void erase_at(size_t slot);
+
+    Clock::time_point epoch_;
+    Clock::duration tick_;
+    std::vector<ImsiKey> keys_;
+    std::vector<uint32_t> started_;
+    // How far into its start tick each session started, in 1/65536 of a tick.
+    std::vector<uint16_t> phase_;
+    size_t size_ = 0;
+    // log2(capacity()), for the multiplicative hash.
+    int bits_ = 0;
+    TimingWheel wheel_;
+    // Slots taken from the wheel by the last expire(), kept for their capacity.
+    std::vector<uint32_t> due_;
+};
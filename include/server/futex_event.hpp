@@ -0,0 +1,31 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// futex_event.hpp
+// Where idle workers sleep. Producers pay for a wake-up (a FUTEX_WAKE system
+// call) only while a consumer is actually asleep; otherwise notify() is a
+// fence and a load.
+//
+// Consumer protocol:
+//     uint32_t epoch = event.prepare_wait();
+//     if (<nothing to do>) event.wait(epoch);
+//     event.finish_wait();
+// A notify() between prepare_wait() and wait() changes the epoch, so wait()
+// returns at once instead of missing it.
+class FutexEvent {
+public:
+    uint32_t prepare_wait();
+    // Sleeps until notify() or a spurious wake-up; the caller re-checks its condition.
+    void wait(uint32_t epoch);
+    void finish_wait();
+
+    // Wakes up to `count` sleeping consumers.
+    void notify(int count);
+    void notify_all();
+
+private:
+    std::atomic<uint32_t> epoch_{0};
+    std::atomic<uint32_t> waiters_{0};
+};
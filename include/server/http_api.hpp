@@ -2,20 +2,21 @@
 #include <string>
 #include <thread>
 #include <atomic>
-#include <unordered_map>
-#include <mutex>
 #include <unistd.h>   
 #include <stdint.h>  
 #include <httplib.h> 
 #include "../config_loader.hpp"
+#include "server_stats.hpp"
+#include "session_store.hpp"
 
 class HttpServer {
 public:
+    // /check_subscriber asks `sessions`, from whichever thread owns them.
     HttpServer(const ServerConfig& config,
                std::atomic<bool>& running,
-               std::unordered_map<std::string, std::chrono::steady_clock::time_point>& sessions,
-               std::mutex& session_mutex,
-               int event_fd);
+               SessionStore& sessions,
+               int event_fd,
+               const ServerStats* stats = nullptr);
 
     void run();
     void stop();
@@ -23,9 +24,9 @@ public:
 private:
     const ServerConfig& config_;
     std::atomic<bool>& running_;
-    std::unordered_map<std::string, std::chrono::steady_clock::time_point>& sessions_;
-    std::mutex& session_mutex_;
+    SessionStore& sessions_;
     httplib::Server svr_;
     std::thread server_thread_;
     int event_fd_; 
+    const ServerStats* stats_;
 };
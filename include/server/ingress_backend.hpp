@@ -0,0 +1,140 @@
+#pragma once
+
+#include "udp_batch.hpp"
+#include "io_uring_backend.hpp"
+#include "packet_ring.hpp"
+#include <atomic>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <netinet/in.h>
+
+// ingress_backend.hpp
+// How a reactor receives datagrams and what its workers send the responses
+// with. PgwServer drives every backend the same way: open() on the reactor's
+// UDP socket, then serve() until the shutdown eventfd fires. Received batches
+// go to an IngressSink, which decides whether to queue or process them.
+
+// One received datagram. `data` is valid only during IngressSink::deliver().
+struct Datagram {
+    const uint8_t* data;
+    size_t length;
+    sockaddr_in source;
+};
+
+class IngressSink {
+public:
+    virtual ~IngressSink() = default;
+
+    // Called on the reactor thread with every received batch; `capacity` is
+    // how many datagrams the backend could have returned at once.
+    virtual void deliver(const Datagram* datagrams, size_t count, size_t capacity) = 0;
+};
+
+class IngressBackend {
+public:
+    virtual ~IngressBackend() = default;
+
+    virtual const char* name() const = 0;
+
+    // Prepares the backend for the reactor's bound UDP socket and the shutdown
+    // eventfd. Returns false when the kernel interface is unavailable.
+    virtual bool open(int sockfd, int event_fd) = 0;
+
+    // Receives until the shutdown eventfd becomes readable (returns true, the
+    // eventfd is left unread for the other reactors) or the backend fails
+    // (returns false, the caller may fall back to another backend).
+    virtual bool serve(IngressSink& sink) = 0;
+
+    // Response batch for a worker of this reactor.
+    virtual std::unique_ptr<UdpSendBatch> make_send_batch(size_t capacity) const;
+
+    // True when payloads live in memory shared with the kernel: the server
+    // processes them inline instead of copying them into the task queue.
+    virtual bool zero_copy() const { return false; }
+
+    // False when datagrams are read elsewhere and the UDP socket only sends.
+    virtual bool reads_socket() const { return true; }
+
+    // Datagrams the kernel dropped before the backend could read them, as of
+    // the last receive: the socket's SO_RXQ_OVFL counter (receive-buffer
+    // overflows, plus socket filter rejections, which the kernel counts
+    // alike) or the packet ring's drops. Sampled from the session cleaner
+    // thread while the reactor receives, never on the receive path: for the
+    // packet ring it is a getsockopt().
+    virtual uint64_t kernel_drops() { return 0; }
+};
+
+// epoll on the UDP socket; recvmmsg batches when batch_size > 1, otherwise
+// one recvfrom() per readiness event. With busy_poll_us > 0 epoll_wait polls
+// the NIC queue for that long before it sleeps (EPIOCSPARAMS, Linux 6.9+).
+class EpollBackend : public IngressBackend {
+public:
+    explicit EpollBackend(size_t batch_size, int busy_poll_us = 0);
+    ~EpollBackend() override;
+
+    const char* name() const override { return "epoll"; }
+    bool open(int sockfd, int event_fd) override;
+    bool serve(IngressSink& sink) override;
+    uint64_t kernel_drops() override;
+
+    // Reads what the socket holds without waiting, for a caller that waits
+    // for readiness in its own event loop. Returns false on a receive error.
+    bool drain(IngressSink& sink);
+
+private:
+    void enable_busy_poll();
+
+    size_t batch_size_;
+    int busy_poll_us_;
+    UdpRecvBatch rx_batch_;
+    std::vector<Datagram> datagrams_;
+    std::atomic<uint32_t> kernel_drops_{0};
+    int sockfd_ = -1;
+    int event_fd_ = -1;
+    int epoll_fd_ = -1;
+};
+
+// Multishot recvmsg on io_uring (IoUringReceiver); workers send through
+// IoUringSendBatch.
+class IoUringBackend : public IngressBackend {
+public:
+    explicit IoUringBackend(size_t batch_size);
+
+    const char* name() const override { return "io_uring"; }
+    bool open(int sockfd, int event_fd) override;
+    bool serve(IngressSink& sink) override;
+    std::unique_ptr<UdpSendBatch> make_send_batch(size_t capacity) const override;
+    uint64_t kernel_drops() override { return receiver_.kernel_drops(); }
+
+private:
+    IoUringReceiver receiver_;
+    std::vector<Datagram> datagrams_;
+};
+
+// TPACKET_V3 ring on an AF_PACKET socket (PacketRing). The UDP socket stays
+// bound for the responses only.
+class PacketRingBackend : public IngressBackend {
+public:
+    PacketRingBackend(const std::string& interface, const std::string& ip, uint16_t port);
+
+    const char* name() const override { return "packet_mmap"; }
+    bool open(int sockfd, int event_fd) override;
+    bool serve(IngressSink& sink) override;
+    bool zero_copy() const override { return true; }
+    bool reads_socket() const override { return false; }
+    uint64_t kernel_drops() override { return ring_.dropped(); }
+
+    // See PacketRing::join_fanout.
+    bool join_fanout(uint16_t& group) { return ring_.join_fanout(group); }
+
+private:
+    PacketRing ring_;
+    std::string interface_;
+    std::string ip_;
+    uint16_t port_;
+    int event_fd_ = -1;
+    std::vector<Datagram> datagrams_;
+};
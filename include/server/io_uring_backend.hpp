@@ -0,0 +1,141 @@
+#pragma once
+
+#include "udp_batch.hpp"
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+// io_uring_backend.hpp
+// io_uring on raw syscalls (no liburing): the reactors receive through a
+// multishot IORING_OP_RECVMSG fed from a provided buffer ring, the workers
+// send their response batches as IORING_OP_SENDMSG SQEs with one
+// io_uring_enter() per batch. Every class reports failure instead of
+// throwing so the server can fall back to epoll + recvmmsg/sendmmsg.
+
+// Submission and completion rings of one io_uring instance.
+class IoUring {
+public:
+    IoUring() = default;
+    ~IoUring();
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // Creates the ring and maps it. Returns false when the kernel refuses
+    // (no io_uring, io_uring_disabled, seccomp), errno is left set.
+    bool init(unsigned sq_entries, unsigned cq_entries = 0);
+    void reset();
+    bool ready() const { return ring_fd_ != -1; }
+    int fd() const { return ring_fd_; }
+
+    // Next free SQE (zeroed), nullptr when the submission ring is full.
+    io_uring_sqe* get_sqe();
+
+    // Submits pending SQEs and waits for at least wait_nr completions.
+    // Returns the number of SQEs submitted or -1 with errno set.
+    int submit_and_wait(unsigned wait_nr);
+
+    // Oldest unseen completion or nullptr; cqe_seen() releases it.
+    io_uring_cqe* peek_cqe();
+    void cqe_seen();
+
+private:
+    int ring_fd_ = -1;
+    void* sq_ptr_ = nullptr;
+    void* cq_ptr_ = nullptr;
+    size_t sq_map_size_ = 0;
+    size_t cq_map_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_map_size_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned sqe_tail_ = 0;
+    unsigned submitted_tail_ = 0;
+
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+};
+
+// Multishot recvmsg on one UDP socket plus a one-shot poll on the shutdown
+// eventfd. Mirrors UdpRecvBatch: wait() fills a batch that stays valid until
+// the next wait(), which hands the buffers back to the kernel.
+class IoUringReceiver {
+public:
+    static constexpr unsigned BUFFER_COUNT = 1024;
+    static constexpr size_t BUFFER_SIZE =
+        sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_in) + RXQ_OVFL_CONTROL_SIZE + UdpRecvBatch::MAX_DATAGRAM_SIZE;
+
+    explicit IoUringReceiver(size_t capacity);
+    ~IoUringReceiver();
+    IoUringReceiver(const IoUringReceiver&) = delete;
+    IoUringReceiver& operator=(const IoUringReceiver&) = delete;
+
+    // Sets up the ring, registers the buffer ring and arms both requests.
+    // Returns false when any of it is unsupported by the running kernel.
+    bool init(int sockfd, int event_fd);
+
+    // Blocks until at least one datagram or the shutdown event arrives.
+    // Returns the number of datagrams in the batch, -1 on error.
+    int wait();
+
+    bool shutdown_requested() const { return shutdown_; }
+    size_t capacity() const { return capacity_; }
+    const uint8_t* data(size_t i) const { return entries_[i].data; }
+    size_t length(size_t i) const { return entries_[i].length; }
+    const sockaddr_in& address(size_t i) const { return entries_[i].addr; }
+
+    // Latest SO_RXQ_OVFL counter seen on the socket, 0 until the first drop.
+    uint32_t kernel_drops() const { return kernel_drops_.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        const uint8_t* data;
+        size_t length;
+        sockaddr_in addr;
+        uint16_t bid;
+    };
+
+    bool arm_receive();
+    bool arm_shutdown_poll();
+    void cancel_requests();
+    void provide_buffer(uint16_t bid);
+    void recycle_buffers();
+    void take_datagram(const io_uring_cqe* cqe);
+
+    IoUring ring_;
+    io_uring_buf_ring* buf_ring_ = nullptr;
+    size_t buf_ring_size_ = 0;
+    uint16_t buf_tail_ = 0;
+    std::vector<uint8_t> buffers_;
+    msghdr recv_msg_{};
+    std::vector<Entry> entries_;
+    size_t capacity_;
+    int sockfd_ = -1;
+    int event_fd_ = -1;
+    bool rearm_ = false;
+    bool shutdown_ = false;
+    // Read by the stats sampler on another thread.
+    std::atomic<uint32_t> kernel_drops_{0};
+};
+
+// UdpSendBatch flushed through io_uring: one SENDMSG SQE per queued response,
+// a single io_uring_enter() submits the batch and reaps the completions.
+// Falls back to sendmmsg() when the ring cannot be created or breaks.
+class IoUringSendBatch : public UdpSendBatch {
+public:
+    explicit IoUringSendBatch(size_t capacity);
+
+    int flush() override;
+    bool uses_io_uring() const { return ring_.ready(); }
+
+private:
+    IoUring ring_;
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <netinet/in.h>
+
+// packet_ring.hpp
+// AF_PACKET receive path: a TPACKET_V3 block ring mapped into the process.
+// The kernel fills whole blocks of IPv4 packets, PacketRing parses the IP/UDP
+// headers in place and exposes the UDP payloads as pointers into the ring, so
+// nothing is copied per packet. Responses still leave through the UDP socket.
+
+// One UDP datagram inside a ring block. `payload` points into the ring and is
+// valid until the block is released.
+struct PacketView {
+    const uint8_t* payload;
+    size_t length;
+    sockaddr_in source;
+};
+
+// Parses an IPv4 packet (starting at the IP header) carrying a UDP datagram to
+// `port` and, unless `dst_ip` is INADDR_ANY, to `dst_ip` (network byte order).
+// Rejects fragments, truncated headers and inconsistent lengths.
+bool parse_udp_packet(const uint8_t* packet, size_t len, in_addr_t dst_ip, uint16_t port, PacketView& view);
+
+// Verifies the UDP checksum of a packet accepted by parse_udp_packet. A zero
+// checksum field means the sender did not compute one and is accepted.
+bool udp_checksum_valid(const uint8_t* packet, size_t len);
+
+class PacketRing {
+public:
+    static constexpr unsigned BLOCK_BYTES = 1 << 18;
+    static constexpr unsigned BLOCK_COUNT = 64;
+    static constexpr unsigned FRAME_SIZE = 2048;
+    // A block is handed to user space when full or after this many milliseconds.
+    static constexpr unsigned BLOCK_TIMEOUT_MS = 2;
+
+    PacketRing() = default;
+    ~PacketRing();
+    PacketRing(const PacketRing&) = delete;
+    PacketRing& operator=(const PacketRing&) = delete;
+
+    // Opens the ring on `interface` (all interfaces when empty) for UDP to
+    // `ip`:`port`. Returns false when AF_PACKET is unavailable (e.g. no CAP_NET_RAW).
+    bool open(const std::string& interface, const std::string& ip, uint16_t port);
+    void close();
+    int fd() const { return fd_; }
+
+    // Shares the traffic with the other rings of `group` by flow hash
+    // (PACKET_FANOUT_HASH). With group == 0 a new group is created and its id
+    // is stored in `group` for the next rings to join.
+    bool join_fanout(uint16_t& group);
+
+    // Takes the next block owned by user space and parses its UDP datagrams.
+    // Returns false when the kernel has not handed over a block yet.
+    bool next_block();
+
+    // Hands the current block back to the kernel; views into it become invalid.
+    void release_block();
+
+    size_t size() const { return views_.size(); }
+    const uint8_t* data(size_t i) const { return views_[i].payload; }
+    size_t length(size_t i) const { return views_[i].length; }
+    const sockaddr_in& address(size_t i) const { return views_[i].source; }
+
+    // Packets the ring dropped because no block was free (PACKET_STATISTICS).
+    uint64_t dropped();
+
+private:
+    int fd_ = -1;
+    uint8_t* map_ = nullptr;
+    size_t map_size_ = 0;
+    unsigned current_ = 0;
+    bool holding_ = false;
+    in_addr_t ip_ = INADDR_ANY;
+    uint16_t port_ = 0;
+    uint64_t dropped_ = 0;
+    std::vector<PacketView> views_;
+};
@@ -2,6 +2,22 @@
 #include "../include/server/decode_utils.hpp"
 #include "../include/server/cdr_writer.hpp"
 #include "../include/server/http_api.hpp"
+#include "../include/server/server_stats.hpp"
+#include "../include/server/udp_batch.hpp"
+#include "../include/server/socket_filters.hpp"
+#include "../include/server/ingress_backend.hpp"
+#include "../include/server/spin_policy.hpp"
+#include "../include/server/rate_limiter.hpp"
+#include "../include/server/bounded_queue.hpp"
+#include "../include/server/worker_queues.hpp"
+#include "../include/server/futex_event.hpp"
+#include "../include/server/client_task.hpp"
+#include "../include/server/thread_topology.hpp"
+#include "../include/server/cpu_budget.hpp"
+#include "../include/server/elastic_policy.hpp"
+#include "../include/server/coro_executor.hpp"
+#include "../include/server/cdr_flusher.hpp"
+#include "../include/server/session_store.hpp"
 #include <iostream>
 #include <arpa/inet.h>
 #include <sys/socket.h>
@@ -10,11 +26,12 @@
 #include <unistd.h>
 #include <unordered_set>
 #include <unordered_map>
+#include <future>
 #include <thread>
 #include <mutex>
 #include <atomic>
-#include <queue>
-#include <condition_variable>
+#include <memory>
+#include <algorithm>
 
 class PgwServer {
 public:
@@ -23,32 +40,202 @@ public:
     void run();
 
 private:
-    struct ClientTask {
-        int sockfd;
-        sockaddr_in client_addr;
-        std::vector<uint8_t> buffer;
+    enum class ResponseCode {
+        None,
+        Created,
+        Rejected
+    };
+
+    // A request of a batch: decoded first, then resolved together with the
+    // rest of the batch.
+    struct SessionRequest {
+        ImsiKey imsi = 0;
+        bool valid = false;
+        ResponseCode code = ResponseCode::None;
+    };
+
+    // Scratch space of the thread that processes batches, reused across batches.
+    struct RequestBatch {
+        std::vector<SessionRequest> requests;
+        std::vector<CdrRecord> cdrs;
+    };
+
+    // What a worker of the pool allocates when it starts and reuses for every batch.
+    struct WorkerScratch {
+        WorkerScratch(size_t batch_size, std::unique_ptr<UdpSendBatch> tx, const QueueLimits& limits)
+            : tasks(batch_size), tx_batch(std::move(tx)), consumer(limits) {
+            batch.requests.resize(batch_size);
+        }
+
+        std::vector<ClientTask> tasks;
+        RequestBatch batch;
+        std::unique_ptr<UdpSendBatch> tx_batch;
+        QueueConsumer consumer;
+    };
+
+    // One UDP socket with its own ingress backend and the queues of the
+    // workers serving it. With reactor_count > 1 every reactor binds the same
+    // address through SO_REUSEPORT.
+    struct Reactor {
+        explicit Reactor(const QueueLimits& limits) : cdr_queue(limits.capacity) {}
+
+        // The thread of one worker queue; started and retired under pool_mutex_.
+        struct WorkerSlot {
+            std::thread thread;
+            bool running = false;
+        };
+
+        size_t index = 0;
+        int sockfd = -1;
+        std::unique_ptr<IngressBackend> ingress;
+        // The epoll backend that takes over once `ingress` fails at runtime,
+        // published by `fell_back` to the session cleaner sampling its drops.
+        std::unique_ptr<IngressBackend> fallback;
+        std::atomic<bool> fell_back{false};
+        // One queue per worker serving the reactor, created by start_thread_pool.
+        std::unique_ptr<WorkerQueues<ClientTask>> task_queues;
+        // CDR writes handed to the workers when the reactor answers inline.
+        MpmcRing<CdrRecord> cdr_queue;
+        // One per worker queue, only the first task_queues->active() run.
+        std::vector<WorkerSlot> workers;
+        // Only in the elastic pool: sizes it from the samples of the session cleaner.
+        std::unique_ptr<ElasticPolicy> elastic;
+        // Longest time in queue of the tasks taken since the last sample.
+        std::atomic<int64_t> peak_sojourn_ns{0};
+        // Only in coroutine mode: runs the reactor's coroutines on its thread.
+        std::unique_ptr<CoroExecutor> executor;
+        // Datagrams whose coroutine has not answered yet; executor thread only.
+        size_t in_flight = 0;
+
+        // The backend receiving now. Any thread.
+        IngressBackend* receiving() const {
+            return fell_back.load(std::memory_order_acquire) ? fallback.get() : ingress.get();
+        }
+    };
+
+    // /check_subscriber asking the worker that owns an IMSI about its session.
+    struct SessionQuery {
+        ImsiKey imsi = 0;
+        std::promise<bool> active;
+    };
+
+    // imsi_affinity: one worker, its task queue and the sessions of the IMSIs
+    // that hash to it. Only that worker touches `sessions`, so they need no
+    // lock; other threads reach them through `queries` and `expire_due`.
+    struct SessionPartition {
+        static constexpr size_t QUERY_CAPACITY = 64;
+
+        SessionPartition(const QueueLimits& limits, std::chrono::milliseconds tick)
+            : task_queue(limits), queries(QUERY_CAPACITY), sessions(std::chrono::steady_clock::now(), tick) {}
+
+        size_t index = 0;
+        BoundedQueue<ClientTask> task_queue;
+        MpmcRing<std::shared_ptr<SessionQuery>> queries;
+        // Raised by the session cleaner, the worker then sweeps its sessions.
+        std::atomic<bool> expire_due{false};
+        FutexEvent work_ready;
+        FlatSessionMap sessions;
+    };
+
+    // /check_subscriber in imsi_affinity mode: asks the worker owning the IMSI.
+    class PartitionedSessions : public SessionStore {
+    public:
+        explicit PartitionedSessions(PgwServer& server) : server_(server) {}
+        bool active(const std::string& imsi) override { return server_.session_active(imsi); }
+
+    private:
+        PgwServer& server_;
+    };
+
+    // Receives a reactor's batches from its backend: drops what is over the
+    // rate limits, then copies the rest into the task queue, or processes it
+    // on the reactor thread in run_to_completion mode and when the backend is
+    // zero-copy. In imsi_affinity mode the tasks go to the workers owning
+    // their IMSIs instead.
+    class ReactorSink : public IngressSink {
+    public:
+        ReactorSink(PgwServer& server, Reactor& reactor);
+        void deliver(const Datagram* datagrams, size_t count, size_t capacity) override;
+
+    private:
+        size_t admit(const Datagram* datagrams, size_t count);
+
+        PgwServer& server_;
+        Reactor& reactor_;
+        std::unique_ptr<UdpSendBatch> tx_batch_;
+        RequestBatch requests_;
+        std::vector<Datagram> admitted_;
     };
 
     int setup_socket();
-    int setup_epoll(int sockfd);
+    void set_socket_buffer(int sockfd, int option, int force_option, int bytes);
+    QueueLimits queue_limits() const;
+    bool open_reactors(int event_fd);
+    bool open_ingress(Reactor& reactor, int event_fd);
+    bool open_packet_rings(int event_fd);
+    void close_reactors();
+    void sample_kernel_counters();
+    void sample_rate_limiter();
+    void reactor_loop(Reactor& reactor, int event_fd);
     void start_session_cleaner();
-    void start_thread_pool(size_t num_threads);
+    std::chrono::milliseconds session_timeout() const;
+    void expire_sessions(std::chrono::steady_clock::time_point now);
+    void expire_sessions(FlatSessionMap& sessions, std::chrono::steady_clock::time_point now);
+    void write_timeouts(const std::vector<ImsiKey>& expired);
+    void open_partitions(size_t count);
+    SessionPartition& owner_of(uint64_t imsi_hash);
+    bool session_active(const std::string& imsi);
+    void start_thread_pool(size_t num_threads, size_t min_threads = 0);
+    void stop_thread_pool();
+    void start_worker(Reactor& reactor, size_t worker);
+    bool retire_worker(Reactor& reactor, size_t worker);
+    void scale_workers();
     void handle_client(int sockfd, const sockaddr_in& client_addr, const std::vector<uint8_t>& buffer);
-    void worker_thread();
+    ResponseCode process_request(const std::vector<uint8_t>& buffer);
+    ResponseCode process_request(const uint8_t* data, size_t len);
+    void resolve_requests(RequestBatch& batch, size_t count, Reactor* cdr_reactor);
+    void open_sessions(RequestBatch& batch, size_t count);
+    ResponseCode process_owned(SessionPartition& partition, const uint8_t* data, size_t len);
+    bool decode_imsi(const uint8_t* data, size_t len, ImsiKey& imsi);
+    bool open_session(ImsiKey imsi);
+    bool open_session(FlatSessionMap& sessions, ImsiKey imsi);
+    bool session_opened(ImsiKey imsi, bool opened);
+    void write_cdrs(Reactor* reactor, std::vector<CdrRecord>& records);
+    void queue_response(UdpSendBatch& batch, int sockfd, const sockaddr_in& client_addr, ResponseCode code);
+    void flush_responses(UdpSendBatch& batch);
+    std::unique_ptr<UdpSendBatch> make_worker_batch(const IngressBackend& backend) const;
+    void worker_thread(Reactor& reactor, size_t worker);
+    size_t serve_tasks(Reactor& reactor, size_t worker, WorkerScratch& scratch);
+    void partition_worker(SessionPartition& partition);
+    template <typename HasWork>
+    void wait_for_work(FutexEvent& work_ready, SpinPolicy& spin, HasWork has_work);
+    void enqueue_batch(Reactor& reactor, const Datagram* datagrams, size_t count);
+    void enqueue_by_imsi(Reactor& reactor, const Datagram* datagrams, size_t count);
+    void process_inline(Reactor& reactor, UdpSendBatch& tx_batch, RequestBatch& batch,
+                        const Datagram* datagrams, size_t count);
+    void spawn_requests(Reactor& reactor, UdpSendBatch& tx_batch, const Datagram* datagrams, size_t count);
+    bool serve_coroutines(Reactor& reactor, ReactorSink& sink, int event_fd);
+    CoroTask serve_socket(Reactor& reactor, ReactorSink& sink);
+    CoroTask serve_requests(Reactor& reactor, UdpSendBatch& tx_batch, std::vector<ClientTask> tasks);
 
     ServerConfig config_;
     CdrWriter cdr_writer_;
+    // Only started in coroutine mode.
+    CdrFlusher cdr_flusher_;
     BcdDecoder decoder_;
-    std::unordered_set<std::string> blacklist_;
-    std::unordered_map<std::string, std::chrono::steady_clock::time_point> session_table_;
-    std::mutex session_mutex_;
+    std::unordered_set<ImsiKey> blacklist_;
+    ShardedSessionTable session_table_;
     std::atomic<bool> running_;
     std::thread cleaner_thread_;
     std::vector<std::thread> thread_pool_;
-    std::queue<ClientTask> task_queue_;
-    std::mutex queue_mutex_;
-    std::condition_variable queue_cond_;
+    std::vector<std::unique_ptr<Reactor>> reactors_;
+    // Only in imsi_affinity mode, which keeps session_table_ empty.
+    std::vector<std::unique_ptr<SessionPartition>> partitions_;
     std::atomic<bool> pool_running_;
+    // Guards starting and retiring the worker threads of the reactors.
+    std::mutex pool_mutex_;
+    ServerStats stats_;
+    RateLimiter rate_limiter_;
 
     friend class PgwServerTest_HandleClient_BlacklistedImsiGetsRejected_Test;
     friend class PgwServerTest_HandleClient_NewImsiCreatesSession_Test;
@@ -56,6 +243,7 @@ private:
     friend class PgwServerTest_HandleClient_EmptyImsi_Test;
     friend class PgwServerTest_SessionCleanerRemovesExpiredSessions_Test;
     friend class PgwServerTest_SessionCleanerDoesNotRemoveActiveSessions_Test;
+    friend class PgwServerTest_KernelDropsFollowTheEpollFallback_Test;
 
 #ifdef UNIT_TEST
 public:
@@ -67,7 +255,7 @@ public:
         start_session_cleaner();
     }
 
-    std::unordered_map<std::string, std::chrono::steady_clock::time_point>& test_sessions() {
+    ShardedSessionTable& test_sessions() {
         return session_table_;
     }
 
@@ -83,13 +271,48 @@ public:
         return setup_socket();
     }
 
-    int test_setup_epoll(int sockfd) {
-        return setup_epoll(sockfd);
-    }
-
     std::vector<std::thread>& test_thread_pool() {
         return thread_pool_;
     }
 
+    const ServerStats& test_stats() const {
+        return stats_;
+    }
+
+    void test_sample_kernel_counters() {
+        sample_kernel_counters();
+    }
+
+    // Opens the reactors and gives the first one queues for `workers`
+    // workers without starting them: the test deals the tasks with
+    // test_enqueue and serves them with test_serve_tasks.
+    bool test_open_worker_queues(int event_fd, size_t workers) {
+        if (!open_reactors(event_fd)) return false;
+        reactors_[0]->task_queues = std::make_unique<WorkerQueues<ClientTask>>(workers, queue_limits());
+        return true;
+    }
+
+    void test_enqueue(const Datagram* datagrams, size_t count) {
+        enqueue_batch(*reactors_[0], datagrams, count);
+    }
+
+    std::unique_ptr<WorkerScratch> test_worker_scratch() {
+        return std::make_unique<WorkerScratch>(config_.worker_batch_size, make_worker_batch(*reactors_[0]->ingress),
+                                               queue_limits());
+    }
+
+    size_t test_serve_tasks(size_t worker, WorkerScratch& scratch) {
+        return serve_tasks(*reactors_[0], worker, scratch);
+    }
+
+    // Only once the workers have stopped.
+    size_t test_partition_sessions() const {
+        size_t count = 0;
+        for (const auto& partition : partitions_) {
+            count += partition->sessions.size();
+        }
+        return count;
+    }
+
 #endif
 };
\ No newline at end of file
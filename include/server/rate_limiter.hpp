@@ -0,0 +1,77 @@
+#pragma once
+
+#include "../config_loader.hpp"
+#include "ingress_backend.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+// rate_limiter.hpp
+// Per-source admission control, checked on the reactor thread before a
+// datagram is queued or processed.
+
+// Fixed-size table of token buckets keyed by a non-zero 64-bit key, shared by
+// all reactors without a lock. A bucket is stored as its theoretical arrival
+// time (GCRA, the one-word form of a token bucket): a datagram passes when
+// the arrival time is at most (burst - 1) intervals ahead of now, and then
+// moves it one interval of 1/rate further. Keys live in a short linear probe
+// window; when the window is full, the entry idle the longest is replaced.
+class TokenBucketTable {
+public:
+    // Keys that hash to the same place share this many candidate slots.
+    static constexpr size_t PROBE_WINDOW = 8;
+
+    // `capacity` is rounded up to a power of two.
+    TokenBucketTable(size_t capacity, uint32_t rate, uint32_t burst, std::chrono::nanoseconds idle_timeout);
+
+    // Takes one token from the bucket of `key` at `now_ns` (steady clock,
+    // non-zero). Returns false when the bucket is empty.
+    bool consume(uint64_t key, uint64_t now_ns);
+
+    size_t capacity() const { return mask_ + 1; }
+    // Buckets used within the idle timeout.
+    size_t active(uint64_t now_ns) const;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> key{0};
+        // Theoretical arrival time in ns; 0 for a bucket that is full.
+        std::atomic<uint64_t> tat{0};
+    };
+
+    Slot& claim(uint64_t key, size_t start);
+    bool idle(uint64_t tat, uint64_t now_ns) const;
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    uint64_t interval_ns_;
+    uint64_t tolerance_ns_;
+    uint64_t idle_ns_;
+};
+
+class RateLimiter {
+public:
+    enum class Verdict {
+        Pass,
+        SourceIp,
+        Imsi
+    };
+
+    // Tables are only allocated for the limits enabled in the config.
+    explicit RateLimiter(const ServerConfig& config);
+
+    bool enabled() const { return by_ip_ || by_imsi_; }
+
+    // The IMSI bucket is keyed by the raw BCD payload, so nothing is decoded
+    // here; datagrams that are not 8 bytes long only go through the IP limit.
+    Verdict check(const Datagram& datagram, uint64_t now_ns);
+
+    const TokenBucketTable* by_ip() const { return by_ip_.get(); }
+    const TokenBucketTable* by_imsi() const { return by_imsi_.get(); }
+
+private:
+    std::unique_ptr<TokenBucketTable> by_ip_;
+    std::unique_ptr<TokenBucketTable> by_imsi_;
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// server_stats.hpp
+// Lock-free counters shared by the reactor, the workers and the HTTP API.
+class ServerStats {
+public:
+    // Batch fill is bucketed by tenths of capacity: 0-9%, 10-19%, ..., 100%.
+    static constexpr size_t FILL_BUCKETS = 11;
+    static constexpr size_t MAX_REACTORS = 64;
+    static constexpr size_t MAX_PARTITIONS = 1024;
+
+    // Why the server itself discarded a datagram it had already received.
+    enum class DropReason : size_t {
+        Invalid,          // not a 15-digit IMSI
+        RateLimitedIp,    // source IP over rate_limit_ip_rate
+        RateLimitedImsi,  // IMSI over rate_limit_imsi_rate
+        QueueFull,        // task queue at queue_capacity (tail_drop, drop_oldest)
+        QueueCoDel,       // queued for too long (codel)
+        Count
+    };
+    static constexpr size_t DROP_REASONS = static_cast<size_t>(DropReason::Count);
+    static const char* drop_reason_name(DropReason reason);
+
+    void record_rx_batch(size_t received, size_t capacity);
+    void record_tx_batch(size_t sent);
+    void record_reactor_rx(size_t reactor, size_t received);
+    // Datagrams the kernel dropped on the UDP sockets, whatever the cause:
+    // socket filter rejections and receive-buffer overflows alike.
+    void set_socket_drops(uint64_t dropped) { socket_drops_.store(dropped, std::memory_order_relaxed); }
+    // A socket filter is attached, so the kernel drop counters include its rejections.
+    void set_socket_filter(bool attached) { socket_filter_.store(attached, std::memory_order_relaxed); }
+    void record_app_drop(DropReason reason, size_t count = 1);
+    // The kernel counters are cumulative per socket, so each reactor stores its latest value.
+    void set_reactor_kernel_drops(size_t reactor, uint64_t dropped);
+    // Time workers spent waiting for an empty queue: spinning (woken = work
+    // arrived during the spin) or parked until woken.
+    void record_worker_spin(uint64_t ns, bool woken);
+    void record_worker_park(uint64_t ns);
+    // A worker with an empty queue took a task from a sibling's queue.
+    void record_worker_steal() { worker_steals_.fetch_add(1, std::memory_order_relaxed); }
+    // Rate-limit buckets used within rate_limit_idle_sec, sampled by the session cleaner.
+    void set_rate_limit_buckets(uint64_t ip, uint64_t imsi);
+    // Gauges of a reactor's task queue: its length and how long the last
+    // task taken from it had waited.
+    void set_queue_depth(size_t reactor, uint64_t depth);
+    void set_queue_sojourn(size_t reactor, uint64_t ns);
+    // Workers a reactor runs, which the elastic pool changes over time.
+    void set_active_workers(size_t reactor, uint64_t workers);
+    // imsi_affinity: how many session partitions there are, one per worker,
+    // and the length of each one's task queue, set by its worker.
+    void set_partitions(size_t count);
+    void set_partition_depth(size_t partition, uint64_t depth);
+
+    uint64_t rx_datagrams() const { return rx_datagrams_.load(std::memory_order_relaxed); }
+    uint64_t rx_batches() const { return rx_batches_.load(std::memory_order_relaxed); }
+    uint64_t rx_batch_fill(size_t bucket) const { return rx_batch_fill_[bucket].load(std::memory_order_relaxed); }
+    uint64_t tx_datagrams() const { return tx_datagrams_.load(std::memory_order_relaxed); }
+    uint64_t tx_batches() const { return tx_batches_.load(std::memory_order_relaxed); }
+    uint64_t reactor_rx(size_t reactor) const { return reactor_rx_[reactor].load(std::memory_order_relaxed); }
+    uint64_t socket_drops() const { return socket_drops_.load(std::memory_order_relaxed); }
+    bool socket_filter() const { return socket_filter_.load(std::memory_order_relaxed); }
+    uint64_t app_dropped(DropReason reason) const {
+        return app_dropped_[static_cast<size_t>(reason)].load(std::memory_order_relaxed);
+    }
+    uint64_t app_dropped() const;
+    uint64_t kernel_rx_dropped() const;
+    uint64_t worker_spin_ns() const { return worker_spin_ns_.load(std::memory_order_relaxed); }
+    uint64_t worker_spin_wakeups() const { return worker_spin_wakeups_.load(std::memory_order_relaxed); }
+    uint64_t worker_park_ns() const { return worker_park_ns_.load(std::memory_order_relaxed); }
+    uint64_t worker_parks() const { return worker_parks_.load(std::memory_order_relaxed); }
+    uint64_t worker_steals() const { return worker_steals_.load(std::memory_order_relaxed); }
+    uint64_t rate_limit_ip_buckets() const { return rate_limit_ip_buckets_.load(std::memory_order_relaxed); }
+    uint64_t queue_depth(size_t reactor) const { return queue_depth_[reactor].load(std::memory_order_relaxed); }
+    uint64_t queue_sojourn_ns(size_t reactor) const { return queue_sojourn_ns_[reactor].load(std::memory_order_relaxed); }
+    uint64_t active_workers(size_t reactor) const { return active_workers_[reactor].load(std::memory_order_relaxed); }
+    size_t partitions() const { return partitions_.load(std::memory_order_relaxed); }
+    uint64_t partition_depth(size_t partition) const {
+        return partition_depth_[partition].load(std::memory_order_relaxed);
+    }
+    uint64_t rate_limit_imsi_buckets() const { return rate_limit_imsi_buckets_.load(std::memory_order_relaxed); }
+
+    // Plain-text "name value" lines, one counter per line.
+    std::string render() const;
+
+private:
+    std::atomic<uint64_t> rx_datagrams_{0};
+    std::atomic<uint64_t> rx_batches_{0};
+    std::array<std::atomic<uint64_t>, FILL_BUCKETS> rx_batch_fill_{};
+    std::atomic<uint64_t> tx_datagrams_{0};
+    std::atomic<uint64_t> tx_batches_{0};
+    std::array<std::atomic<uint64_t>, MAX_REACTORS> reactor_rx_{};
+    std::atomic<uint64_t> socket_drops_{0};
+    std::atomic<bool> socket_filter_{false};
+    std::array<std::atomic<uint64_t>, DROP_REASONS> app_dropped_{};
+    std::array<std::atomic<uint64_t>, MAX_REACTORS> reactor_kernel_drops_{};
+    std::atomic<uint64_t> worker_spin_ns_{0};
+    std::atomic<uint64_t> worker_spin_wakeups_{0};
+    std::atomic<uint64_t> worker_park_ns_{0};
+    std::atomic<uint64_t> worker_parks_{0};
+    std::atomic<uint64_t> worker_steals_{0};
+    std::atomic<uint64_t> rate_limit_ip_buckets_{0};
+    std::atomic<uint64_t> rate_limit_imsi_buckets_{0};
+    std::array<std::atomic<uint64_t>, MAX_REACTORS> queue_depth_{};
+    std::array<std::atomic<uint64_t>, MAX_REACTORS> queue_sojourn_ns_{};
+    std::array<std::atomic<uint64_t>, MAX_REACTORS> active_workers_{};
+    std::atomic<size_t> partitions_{0};
+    std::array<std::atomic<uint64_t>, MAX_PARTITIONS> partition_depth_{};
+};
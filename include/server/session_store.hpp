@@ -0,0 +1,66 @@
+#pragma once
+
+#include "flat_session_map.hpp"
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// session_store.hpp
+// Where the sessions of the subscribers live, as seen by the threads that
+// only ask about them, like the HTTP API.
+class SessionStore {
+public:
+    virtual ~SessionStore() = default;
+
+    // Whether the IMSI, given as digits, has a session. Any thread.
+    virtual bool active(const std::string& imsi) = 0;
+};
+
+// The sessions shared by the workers, split into shards by IMSI, each a
+// FlatSessionMap. Each shard has its own lock and cache line, so workers opening the
+// sessions of different subscribers, /check_subscriber and the expiry sweep
+// rarely wait for one another. A sweep holds one shard at a time, and only
+// for as long as it takes to remove that shard's due sessions.
+class ShardedSessionTable : public SessionStore {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t DEFAULT_SHARDS = 64;
+
+    // At least one shard. `tick` is the expiry granularity of every shard.
+    explicit ShardedSessionTable(size_t shards = DEFAULT_SHARDS,
+                                 std::chrono::milliseconds tick = FlatSessionMap::DEFAULT_TICK);
+
+    // False for anything pack_imsi refuses.
+    bool active(const std::string& imsi) override;
+    bool active(ImsiKey imsi);
+
+    // Opens a session started at `now` unless the IMSI has one already,
+    // which is left as it is. True when the session was opened.
+    bool open(ImsiKey imsi, Clock::time_point now);
+    // Opens the session, or moves its start to `started`.
+    void insert(ImsiKey imsi, Clock::time_point started);
+
+    // Removes the sessions older than `timeout`, counted in whole ticks as
+    // FlatSessionMap::expire, and appends their IMSIs to `expired`.
+    void expire(Clock::time_point now, std::chrono::milliseconds timeout, std::vector<ImsiKey>& expired);
+
+    // Sums the shards one at a time, so it is exact only while nothing else changes them.
+    size_t size();
+    bool empty() { return size() == 0; }
+    size_t shards() const { return shard_count_; }
+
+private:
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        FlatSessionMap sessions;
+    };
+
+    Shard& shard_of(ImsiKey imsi);
+
+    size_t shard_count_;
+    std::unique_ptr<Shard[]> shards_;
+};
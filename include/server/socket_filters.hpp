@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <linux/filter.h>
+
+// socket_filters.hpp
+// Classic BPF programs attached to the server's sockets. Reuseport programs
+// see the UDP payload at offset 0, UDP socket filters see the UDP header first
+// and packet socket filters (SOCK_DGRAM) the IPv4 header.
+
+// Number of payload bytes the steering hash reads (a 15-digit IMSI in BCD).
+constexpr size_t IMSI_STEERING_BYTES = 8;
+
+// SO_ATTACH_REUSEPORT_CBPF program that returns the index of the socket in the
+// reuseport group chosen by IMSI hash. Payloads shorter than IMSI_STEERING_BYTES
+// return `groups`, which makes the kernel fall back to its 4-tuple hash.
+std::vector<sock_filter> build_imsi_steering_program(uint32_t groups);
+
+// User-space mirror of the steering program, used to predict the owning reactor.
+uint32_t imsi_steering_index(const uint8_t* payload, size_t len, uint32_t groups);
+
+// Attaches the steering program to the reuseport group `sockfd` belongs to.
+bool attach_imsi_steering(int sockfd, uint32_t groups);
+
+// SO_ATTACH_FILTER program that accepts only an 8-byte payload of BCD digits
+// whose last high nibble is the 0xF padding of a 15-digit IMSI.
+std::vector<sock_filter> build_imsi_validation_program();
+
+// Attaches the validation program: malformed datagrams are dropped in the kernel.
+bool attach_imsi_validation(int sockfd);
+
+// Datagrams the kernel dropped on this socket (SK_MEMINFO_DROPS): filter
+// rejections plus receive-buffer overflows. Returns 0 when unavailable.
+uint64_t socket_drop_count(int sockfd);
+
+// SO_ATTACH_FILTER program for an AF_PACKET SOCK_DGRAM socket bound to ETH_P_IP:
+// accepts unfragmented UDP datagrams to `port` and drops everything else.
+std::vector<sock_filter> build_udp_port_program(uint16_t port);
+
+// Attaches a program that drops every datagram. Used to keep a UDP socket bound
+// for sending while its datagrams are read from a packet ring instead.
+bool attach_drop_all(int sockfd);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+
+// spin_policy.hpp
+// How long a worker spins on an empty queue before it parks on its
+// FutexEvent. The budget follows the observed gaps between arrivals: a worker
+// spins about twice the average gap while that fits into the configured
+// maximum and parks right away once arrivals are further apart, since the
+// spin would then burn CPU without saving a wake-up.
+class SpinPolicy {
+public:
+    // A zero max_budget disables spinning.
+    explicit SpinPolicy(std::chrono::nanoseconds max_budget);
+
+    std::chrono::nanoseconds budget() const { return budget_; }
+
+    // How long the queue stayed empty before the next item arrived, whether
+    // the worker spun or parked meanwhile.
+    void record_wait(std::chrono::nanoseconds waited);
+
+private:
+    std::chrono::nanoseconds max_budget_;
+    std::chrono::nanoseconds average_gap_;
+    std::chrono::nanoseconds budget_;
+};
+
+// Tells the CPU the thread is busy-waiting so the sibling hyperthread gets the core.
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
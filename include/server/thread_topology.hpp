@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// thread_topology.hpp
+// Names and CPU pinning of the server threads. Each thread role (reactors,
+// workers, session cleaner, HTTP) has its own CPU list in the config.
+// Reactors and workers are dealt the CPUs of their list in turn, one CPU
+// each, so every one of them keeps its caches; the cleaner and the HTTP
+// thread may run on any CPU of theirs. A role without a list is not pinned.
+
+// Names the calling thread as seen in top -H, perf and /proc/<pid>/task/*/comm.
+// Names longer than 15 characters are cut off.
+void set_thread_name(const std::string& name);
+
+// Pins the calling thread to `cpus`, setting errno on failure. An empty list leaves it as it is.
+bool pin_thread(const std::vector<int>& cpus);
+
+// The CPU of the index-th thread of a role, or an empty list when the role is not pinned.
+std::vector<int> cpu_of(const std::vector<int>& cpus, size_t index);
+
+// Names and pins the calling thread; a failed pinning is logged and the thread keeps running unpinned.
+void apply_thread_role(const std::string& name, const std::vector<int>& cpus);
+
+// "0-3,8", or "any" for an empty list.
+std::string format_cpu_list(const std::vector<int>& cpus);
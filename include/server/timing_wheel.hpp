@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// timing_wheel.hpp
+// Hierarchical timing wheel of 32-bit ids, such as slots of a table. A tick
+// is a level-0 unit; a unit of each level above spans 256 units of the level
+// below, and every level has slots for two units of the level above it, the
+// current one and the next. An entry sits on the lowest level whose window
+// holds its tick. While the wheel goes through a unit of a level, the entries
+// of the next unit are moved down a level a share at a time, so no tick moves
+// a whole slot at once: each tick costs its due entries plus a few moved ones.
+//
+// An entry is only an id, four bytes: its tick is read from the caller's
+// array of ticks whenever the wheel needs it. An id given a new tick, or
+// reused for something else, is scheduled again; the entry left behind is
+// dropped once the wheel finds its id at another tick.
+class TimingWheel {
+public:
+    static constexpr int LEVELS = 4;
+    static constexpr int UNIT_BITS = 8;
+    static constexpr size_t SLOTS = size_t{2} << UNIT_BITS;
+
+    // `now` is the first tick advance() takes entries from. Ticks are 32-bit
+    // and wrap: a tick is after another when it is less than 2^31 ahead.
+    explicit TimingWheel(uint32_t now = 0);
+
+    // An entry for a tick the wheel has already passed waits aside and is
+    // taken by the first advance() reaching that tick.
+    void schedule(uint32_t id, uint32_t tick);
+    // Takes out every entry whose tick in `ticks` is up to `to` and appends
+    // its id to `due`. An id can be taken twice for the same tick.
+    void advance(uint32_t to, const std::vector<uint32_t>& ticks, std::vector<uint32_t>& due);
+    // Drops every entry; the wheel stays at its tick.
+    void clear();
+
+    // Entries held, the left-behind ones not dropped yet included.
+    size_t size() const;
+    // Bytes held by the slots and their blocks.
+    size_t memory() const;
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    static constexpr size_t BLOCK_ENTRIES = 62;
+
+    // Slots hold chains of blocks; emptied blocks go to a free list.
+    struct Block {
+        uint32_t ids[BLOCK_ENTRIES];
+        uint32_t count = 0;
+        uint32_t next = NONE;
+    };
+
+    static size_t slot_of(int level, uint32_t unit);
+    void place(uint32_t id, uint32_t tick);
+    void push(uint32_t& head, uint32_t id);
+    uint32_t allocate();
+    // Returns the blocks of a chain to the free list.
+    void release(uint32_t chain);
+    // Moves up to `count` entries of a slot on `level`, the one of the unit
+    // starting at `first`, down to the levels below.
+    void move_down(int level, size_t slot, uint32_t first, size_t count, const std::vector<uint32_t>& ticks);
+    void step(const std::vector<uint32_t>& ticks, std::vector<uint32_t>& due);
+    // The tick advance() may jump to from now_ because nothing happens before it.
+    uint32_t next_event() const;
+
+    std::deque<Block> blocks_;
+    uint32_t free_ = NONE;
+    uint32_t heads_[LEVELS][SLOTS];
+    uint32_t slot_counts_[LEVELS][SLOTS] = {};
+    size_t counts_[LEVELS] = {};
+    uint32_t overdue_ = NONE;
+    size_t overdue_count_ = 0;
+    uint32_t now_;
+};
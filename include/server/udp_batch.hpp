@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+// udp_batch.hpp
+// Control buffer room for the SO_RXQ_OVFL counter attached to a datagram.
+constexpr size_t RXQ_OVFL_CONTROL_SIZE = CMSG_SPACE(sizeof(uint32_t));
+
+// Reads the SO_RXQ_OVFL counter (datagrams the kernel dropped on the socket
+// so far) from a received message. Returns false when none is attached: the
+// kernel only adds it once the socket has dropped something.
+bool read_rxq_ovfl(const msghdr& msg, uint32_t& drops);
+
+// Preallocated recvmmsg() batch: message headers, iovecs, peer addresses and
+// payload slots are allocated once and reused for every receive call.
+class UdpRecvBatch {
+public:
+    static constexpr size_t MAX_DATAGRAM_SIZE = 16;
+
+    explicit UdpRecvBatch(size_t capacity);
+
+    // Returns the number of datagrams received, 0 when the socket is drained, -1 on error.
+    int receive(int sockfd);
+
+    size_t capacity() const { return msgs_.size(); }
+    const uint8_t* data(size_t i) const { return &buffers_[i * MAX_DATAGRAM_SIZE]; }
+    size_t length(size_t i) const { return msgs_[i].msg_len; }
+    const sockaddr_in& address(size_t i) const { return addrs_[i]; }
+
+    // Latest SO_RXQ_OVFL counter seen on the socket, 0 until the first drop.
+    // A drop is reported by the next datagram the kernel queues after it.
+    uint32_t kernel_drops() const { return kernel_drops_.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<mmsghdr> msgs_;
+    std::vector<iovec> iovecs_;
+    std::vector<sockaddr_in> addrs_;
+    std::vector<uint8_t> buffers_;
+    std::vector<uint64_t> controls_;
+    // Read by the stats sampler on another thread.
+    std::atomic<uint32_t> kernel_drops_{0};
+};
+
+// Preallocated sendmmsg() batch. Payloads are not copied: callers pass
+// buffers that outlive the batch (the server's static response strings).
+class UdpSendBatch {
+public:
+    static constexpr size_t MAX_CAPACITY = 1024;
+
+    explicit UdpSendBatch(size_t capacity);
+    virtual ~UdpSendBatch() = default;
+
+    // Returns false when the batch is full or already targets another socket.
+    bool add(int sockfd, const sockaddr_in& addr, const char* data, size_t len);
+
+    // Sends every queued datagram and empties the batch. Returns the number sent.
+    virtual int flush();
+
+    size_t size() const { return count_; }
+    size_t capacity() const { return msgs_.size(); }
+    bool empty() const { return count_ == 0; }
+    bool full() const { return count_ == msgs_.size(); }
+
+protected:
+    std::vector<mmsghdr> msgs_;
+    std::vector<iovec> iovecs_;
+    std::vector<sockaddr_in> addrs_;
+    size_t count_ = 0;
+    int sockfd_ = -1;
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "bounded_queue.hpp"
+#include "futex_event.hpp"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <memory>
+#include <vector>
+
+// worker_queues.hpp
+// Task queues of the workers serving one reactor. The reactor deals tasks out
+// to the queues in turn, so the workers do not all contend for the head of a
+// single queue, and a worker whose own queue is empty steals the head of a
+// sibling's: a burst that piles up behind a busy worker is still taken by the
+// idle ones. Every queue is a BoundedQueue on a lock-free ring, so a steal is
+// a pop from another worker's ring.
+//
+// Only the first active() queues have a running worker and are dealt tasks.
+// The queues of retired workers take tasks only when every active queue is
+// full, and the active workers steal those tasks like any other.
+template <typename T>
+class WorkerQueues {
+public:
+    using Clock = std::chrono::steady_clock;
+    using PushResult = typename BoundedQueue<T>::PushResult;
+
+    // limits.capacity is split among the queues, so it still bounds the total.
+    WorkerQueues(size_t workers, const QueueLimits& limits) {
+        workers = std::max<size_t>(workers, 1);
+        for (size_t i = 0; i < workers; ++i) {
+            QueueLimits share = limits;
+            share.capacity = limits.capacity / workers + (i < limits.capacity % workers ? 1 : 0);
+            queues_.push_back(std::make_unique<Queue>(share));
+        }
+        active_.store(workers);
+    }
+
+    size_t workers() const { return queues_.size(); }
+
+    size_t active() const { return active_.load(); }
+
+    // Any thread. Clamped to 1..workers(); the workers being retired are woken
+    // so they notice.
+    void set_active(size_t count) {
+        count = std::clamp<size_t>(count, 1, queues_.size());
+        size_t previous = active_.exchange(count);
+        for (size_t i = count; i < previous; ++i) {
+            queues_[i]->work_ready.notify_all();
+        }
+    }
+
+    // Producer side, from one thread. The next queue in turn with room takes
+    // the item; when every queue is full, the next one's overload policy decides.
+    PushResult push(T&& item, Clock::time_point now) {
+        Queue& queue = next_queue();
+        PushResult result = queue.tasks.push(std::move(item), now);
+        if (result != PushResult::Rejected) ++queue.dealt;
+        return result;
+    }
+
+    // Producer side: wakes each worker dealt tasks since the last call, once.
+    // Tasks that went to a retired worker's queue wake an active worker to steal them.
+    void notify_dealt() {
+        size_t active = active_.load();
+        for (size_t i = 0; i < queues_.size(); ++i) {
+            Queue& queue = *queues_[i];
+            if (queue.dealt == 0) continue;
+            queues_[i % active]->work_ready.notify(static_cast<int>(std::min<size_t>(queue.dealt, INT_MAX)));
+            queue.dealt = 0;
+        }
+    }
+
+    // Producer side: wakes the next active worker in turn, for work kept outside the queues.
+    void notify_one() {
+        size_t active = active_.load();
+        if (next_ >= active) next_ = 0;
+        queues_[next_]->work_ready.notify(1);
+        next_ = (next_ + 1) % active;
+    }
+
+    void notify_all() {
+        for (auto& queue : queues_) {
+            queue->work_ready.notify_all();
+        }
+    }
+
+    // Takes the head of the worker's own queue, otherwise steals the head of
+    // the first sibling queue holding a task, starting after the worker so
+    // that idle workers spread over different victims.
+    bool pop(size_t worker, T& item, Clock::time_point now, QueueConsumer& consumer, bool& stolen) {
+        stolen = false;
+        if (queues_[worker]->tasks.pop(item, now, consumer)) return true;
+        for (size_t step = 1; step < queues_.size(); ++step) {
+            BoundedQueue<T>& victim = queues_[(worker + step) % queues_.size()]->tasks;
+            if (!victim.empty() && victim.pop(item, now, consumer)) {
+                stolen = true;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Where the worker sleeps when no queue holds a task.
+    FutexEvent& work_ready(size_t worker) { return queues_[worker]->work_ready; }
+
+    // Snapshots, exact only while no other thread pushes or pops.
+    bool empty() const {
+        for (const auto& queue : queues_) {
+            if (!queue->tasks.empty()) return false;
+        }
+        return true;
+    }
+    size_t size() const {
+        size_t total = 0;
+        for (const auto& queue : queues_) {
+            total += queue->tasks.size();
+        }
+        return total;
+    }
+    size_t size(size_t worker) const { return queues_[worker]->tasks.size(); }
+    size_t capacity() const {
+        size_t total = 0;
+        for (const auto& queue : queues_) {
+            total += queue->tasks.capacity();
+        }
+        return total;
+    }
+
+private:
+    struct Queue {
+        explicit Queue(const QueueLimits& limits) : tasks(limits) {}
+
+        BoundedQueue<T> tasks;
+        FutexEvent work_ready;
+        // Items dealt since the last notify_dealt(); producer only.
+        size_t dealt = 0;
+    };
+
+    Queue& next_queue() {
+        size_t active = active_.load();
+        if (next_ >= active) next_ = 0;
+        size_t start = next_;
+        for (size_t attempt = 0; attempt < active; ++attempt) {
+            Queue& queue = *queues_[next_];
+            next_ = (next_ + 1) % active;
+            if (!queue.tasks.full()) return queue;
+        }
+        // Every active queue is full: overflow into a retired worker's queue.
+        for (size_t i = active; i < queues_.size(); ++i) {
+            if (!queues_[i]->tasks.full()) return *queues_[i];
+        }
+        next_ = (start + 1) % active;
+        return *queues_[start];
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::atomic<size_t> active_{0};
+    // Next queue to deal to; producer only.
+    size_t next_ = 0;
+};
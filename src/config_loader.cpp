@@ -1,8 +1,23 @@
 #include "../include/config_loader.hpp"
+#include <algorithm>
 #include <regex>
 #include <stdexcept>
 #include <sstream>
 
+namespace {
+// CPU_SETSIZE: pthread_setaffinity_np takes no CPU past it.
+constexpr int MAX_CPUS = 1024;
+
+std::vector<int> load_cpu_list(const nlohmann::json& j, const std::string& key) {
+    std::vector<int> cpus;
+    std::string list = j.value(key, "");
+    if (!parse_cpu_list(list, cpus)) {
+        throw std::runtime_error("Invalid " + key + ": " + list + " (expected a CPU list like 0-3,8)");
+    }
+    return cpus;
+}
+}
+
 bool is_valid_ip(const std::string& ip) {
     std::regex ip_regex(R"(^((25[0-5]|2[0-4]\d|1\d{2}|[1-9]?\d)(\.|$)){4}$)");
     return std::regex_match(ip, ip_regex);
@@ -12,6 +27,46 @@ bool is_valid_log_level(const std::string& level) {
     return level == "info" || level == "debug" || level == "warning" || level == "error";
 }
 
+bool is_valid_send_flush(const std::string& mode) {
+    return mode == "batch_size" || mode == "end_of_batch";
+}
+
+bool is_valid_reactor_steering(const std::string& mode) {
+    return mode == "flow" || mode == "imsi";
+}
+
+bool is_valid_io_backend(const std::string& backend) {
+    return backend == "epoll" || backend == "io_uring" || backend == "packet_mmap";
+}
+
+bool is_valid_dispatch_mode(const std::string& mode) {
+    return mode == "worker_pool" || mode == "run_to_completion" || mode == "imsi_affinity" || mode == "coroutine";
+}
+
+bool is_valid_queue_policy(const std::string& policy) {
+    return policy == "tail_drop" || policy == "drop_oldest" || policy == "codel";
+}
+
+bool parse_cpu_list(const std::string& list, std::vector<int>& cpus) {
+    static const std::regex range_regex(R"(^\s*(\d{1,4})\s*(-\s*(\d{1,4})\s*)?$)");
+    cpus.clear();
+    if (list.find_first_not_of(" \t") == std::string::npos) return true;
+
+    std::istringstream ranges(list + ',');
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        std::smatch match;
+        if (!std::regex_match(range, match, range_regex)) return false;
+        int first = std::stoi(match[1]);
+        int last = match[3].matched ? std::stoi(match[3]) : first;
+        if (first > last || last >= MAX_CPUS) return false;
+        for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return true;
+}
+
 void validate_blacklist(const std::vector<std::string>& blacklist) {
     for (const auto& imsi : blacklist) {
         if (imsi.size() != 15 || !std::all_of(imsi.begin(), imsi.end(), ::isdigit)) {
@@ -52,8 +107,9 @@ ServerConfig load_config_server(const std::string& filepath) {
     }
 
     config.session_timeout_sec = j.value("session_timeout_sec", 30);
-    if (config.session_timeout_sec <= 0) {
-        throw std::runtime_error("Invalid session_timeout_sec: must be > 0");
+    // Session starts are kept as 32-bit ticks, exact for ages up to 24 days at 1 ms.
+    if (config.session_timeout_sec <= 0 || config.session_timeout_sec > 1000000) {
+        throw std::runtime_error("Invalid session_timeout_sec: must be 1-1000000");
     }
 
     config.cdr_file = j.value("cdr_file", "cdr.log");
@@ -61,6 +117,182 @@ ServerConfig load_config_server(const std::string& filepath) {
     config.blacklist = j.value("blacklist", std::vector<std::string>{});
     validate_blacklist(config.blacklist);
 
+    config.recv_batch_size = j.value("recv_batch_size", 32);
+    if (config.recv_batch_size <= 0 || config.recv_batch_size > 1024) {
+        throw std::runtime_error("Invalid recv_batch_size: must be 1-1024");
+    }
+
+    config.send_batch_size = j.value("send_batch_size", 32);
+    if (config.send_batch_size <= 0 || config.send_batch_size > 1024) {
+        throw std::runtime_error("Invalid send_batch_size: must be 1-1024");
+    }
+
+    config.send_flush = j.value("send_flush", "end_of_batch");
+    if (!is_valid_send_flush(config.send_flush)) {
+        throw std::runtime_error("Invalid send_flush: " + config.send_flush);
+    }
+
+    config.reactor_count = j.value("reactor_count", 1);
+    if (config.reactor_count <= 0 || config.reactor_count > 64) {
+        throw std::runtime_error("Invalid reactor_count: must be 1-64");
+    }
+
+    config.reactor_steering = j.value("reactor_steering", "flow");
+    if (!is_valid_reactor_steering(config.reactor_steering)) {
+        throw std::runtime_error("Invalid reactor_steering: " + config.reactor_steering);
+    }
+
+    config.socket_filter = j.value("socket_filter", false);
+
+    config.io_backend = j.value("io_backend", "epoll");
+    if (!is_valid_io_backend(config.io_backend)) {
+        throw std::runtime_error("Invalid io_backend: " + config.io_backend);
+    }
+
+    config.packet_interface = j.value("packet_interface", "");
+
+    config.dispatch_mode = j.value("dispatch_mode", "worker_pool");
+    if (!is_valid_dispatch_mode(config.dispatch_mode)) {
+        throw std::runtime_error("Invalid dispatch_mode: " + config.dispatch_mode);
+    }
+    if (config.dispatch_mode == "coroutine" && config.io_backend != "epoll") {
+        throw std::runtime_error("Invalid io_backend: the coroutine dispatch mode waits for the sockets in its own epoll executor");
+    }
+
+    // 0 keeps the kernel default (net.core.rmem_default / wmem_default).
+    config.socket_rcvbuf = j.value("socket_rcvbuf", 0);
+    if (config.socket_rcvbuf < 0) {
+        throw std::runtime_error("Invalid socket_rcvbuf: must be >= 0");
+    }
+
+    config.socket_sndbuf = j.value("socket_sndbuf", 0);
+    if (config.socket_sndbuf < 0) {
+        throw std::runtime_error("Invalid socket_sndbuf: must be >= 0");
+    }
+
+    // 0 parks idle workers right away and leaves busy polling to the sysctls.
+    config.spin_budget_us = j.value("spin_budget_us", 0);
+    if (config.spin_budget_us < 0 || config.spin_budget_us > 10000) {
+        throw std::runtime_error("Invalid spin_budget_us: must be 0-10000");
+    }
+
+    config.busy_poll_us = j.value("busy_poll_us", 0);
+    if (config.busy_poll_us < 0 || config.busy_poll_us > 10000) {
+        throw std::runtime_error("Invalid busy_poll_us: must be 0-10000");
+    }
+
+    // Rates are datagrams per second per source IP / per IMSI; 0 disables the limit.
+    config.rate_limit_ip_rate = j.value("rate_limit_ip_rate", 0);
+    if (config.rate_limit_ip_rate < 0 || config.rate_limit_ip_rate > 1000000000) {
+        throw std::runtime_error("Invalid rate_limit_ip_rate: must be 0-1000000000");
+    }
+
+    config.rate_limit_ip_burst = j.value("rate_limit_ip_burst", 64);
+    if (config.rate_limit_ip_burst <= 0) {
+        throw std::runtime_error("Invalid rate_limit_ip_burst: must be > 0");
+    }
+
+    config.rate_limit_imsi_rate = j.value("rate_limit_imsi_rate", 0);
+    if (config.rate_limit_imsi_rate < 0 || config.rate_limit_imsi_rate > 1000000000) {
+        throw std::runtime_error("Invalid rate_limit_imsi_rate: must be 0-1000000000");
+    }
+
+    config.rate_limit_imsi_burst = j.value("rate_limit_imsi_burst", 8);
+    if (config.rate_limit_imsi_burst <= 0) {
+        throw std::runtime_error("Invalid rate_limit_imsi_burst: must be > 0");
+    }
+
+    config.rate_limit_table_size = j.value("rate_limit_table_size", 65536);
+    if (config.rate_limit_table_size <= 0 || config.rate_limit_table_size > 16777216) {
+        throw std::runtime_error("Invalid rate_limit_table_size: must be 1-16777216");
+    }
+
+    config.rate_limit_idle_sec = j.value("rate_limit_idle_sec", 60);
+    if (config.rate_limit_idle_sec <= 0) {
+        throw std::runtime_error("Invalid rate_limit_idle_sec: must be > 0");
+    }
+
+    config.queue_capacity = j.value("queue_capacity", 65536);
+    if (config.queue_capacity <= 0 || config.queue_capacity > 16777216) {
+        throw std::runtime_error("Invalid queue_capacity: must be 1-16777216");
+    }
+
+    config.queue_policy = j.value("queue_policy", "tail_drop");
+    if (!is_valid_queue_policy(config.queue_policy)) {
+        throw std::runtime_error("Invalid queue_policy: " + config.queue_policy);
+    }
+
+    config.codel_target_us = j.value("codel_target_us", 5000);
+    if (config.codel_target_us <= 0) {
+        throw std::runtime_error("Invalid codel_target_us: must be > 0");
+    }
+
+    config.codel_interval_us = j.value("codel_interval_us", 100000);
+    if (config.codel_interval_us < config.codel_target_us) {
+        throw std::runtime_error("Invalid codel_interval_us: must be >= codel_target_us");
+    }
+
+    config.worker_count = j.value("worker_count", 0);
+    if (config.worker_count < 0 || config.worker_count > 1024) {
+        throw std::runtime_error("Invalid worker_count: must be 0-1024");
+    }
+
+    config.worker_batch_size = j.value("worker_batch_size", 32);
+    if (config.worker_batch_size <= 0 || config.worker_batch_size > 1024) {
+        throw std::runtime_error("Invalid worker_batch_size: must be 1-1024");
+    }
+
+    config.session_shards = j.value("session_shards", 64);
+    if (config.session_shards <= 0 || config.session_shards > 65536) {
+        throw std::runtime_error("Invalid session_shards: must be 1-65536");
+    }
+
+    config.session_tick_ms = j.value("session_tick_ms", 1000);
+    if (config.session_tick_ms <= 0 || config.session_tick_ms > 60000) {
+        throw std::runtime_error("Invalid session_tick_ms: must be 1-60000");
+    }
+
+    config.session_timeout_ms = j.value("session_timeout_ms", 0);
+    if (config.session_timeout_ms < 0 || config.session_timeout_ms > 1000000000) {
+        throw std::runtime_error("Invalid session_timeout_ms: must be 0-1000000000");
+    }
+
+    config.elastic_workers = j.value("elastic_workers", false);
+    if (config.elastic_workers && config.dispatch_mode != "worker_pool") {
+        throw std::runtime_error("Invalid elastic_workers: only the worker_pool dispatch mode has an elastic pool");
+    }
+
+    config.elastic_min_workers = j.value("elastic_min_workers", 1);
+    if (config.elastic_min_workers <= 0 || config.elastic_min_workers > 1024) {
+        throw std::runtime_error("Invalid elastic_min_workers: must be 1-1024");
+    }
+
+    config.elastic_max_workers = j.value("elastic_max_workers", 0);
+    if (config.elastic_max_workers < 0 || config.elastic_max_workers > 1024 ||
+        (config.elastic_max_workers > 0 && config.elastic_max_workers < config.elastic_min_workers)) {
+        throw std::runtime_error("Invalid elastic_max_workers: must be 0 or elastic_min_workers-1024");
+    }
+
+    config.elastic_grow_sojourn_us = j.value("elastic_grow_sojourn_us", 1000);
+    if (config.elastic_grow_sojourn_us <= 0) {
+        throw std::runtime_error("Invalid elastic_grow_sojourn_us: must be > 0");
+    }
+
+    config.elastic_shrink_sojourn_us = j.value("elastic_shrink_sojourn_us", 100);
+    if (config.elastic_shrink_sojourn_us < 0 || config.elastic_shrink_sojourn_us >= config.elastic_grow_sojourn_us) {
+        throw std::runtime_error("Invalid elastic_shrink_sojourn_us: must be 0 or more and below elastic_grow_sojourn_us");
+    }
+
+    config.elastic_shrink_after_sec = j.value("elastic_shrink_after_sec", 10);
+    if (config.elastic_shrink_after_sec <= 0) {
+        throw std::runtime_error("Invalid elastic_shrink_after_sec: must be > 0");
+    }
+
+    config.reactor_cpus = load_cpu_list(j, "reactor_cpus");
+    config.worker_cpus = load_cpu_list(j, "worker_cpus");
+    config.cleaner_cpus = load_cpu_list(j, "cleaner_cpus");
+    config.http_cpus = load_cpu_list(j, "http_cpus");
+
     return config;
 }
 
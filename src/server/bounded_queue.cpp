@@ -0,0 +1,63 @@
+#include "../include/server/bounded_queue.hpp"
+#include <cmath>
+
+bool parse_overload_policy(const std::string& name, OverloadPolicy& policy) {
+    if (name == "tail_drop") {
+        policy = OverloadPolicy::TailDrop;
+    } else if (name == "drop_oldest") {
+        policy = OverloadPolicy::DropOldest;
+    } else if (name == "codel") {
+        policy = OverloadPolicy::CoDel;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+CoDel::CoDel(std::chrono::nanoseconds target, std::chrono::nanoseconds interval)
+    : target_(target), interval_(interval) {}
+
+CoDel::Clock::time_point CoDel::control_law(Clock::time_point from) const {
+    auto spacing = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double, std::nano>(interval_.count() / std::sqrt(static_cast<double>(count_))));
+    return from + spacing;
+}
+
+// The queue is only "bad" once the sojourn time stayed above the target for a
+// whole interval; a queue about to go empty never is.
+bool CoDel::above_target(std::chrono::nanoseconds sojourn, Clock::time_point now, bool queue_empty) {
+    if (sojourn < target_ || queue_empty) {
+        first_above_ = Clock::time_point{};
+        return false;
+    }
+    if (first_above_ == Clock::time_point{}) {
+        first_above_ = now + interval_;
+        return false;
+    }
+    return now >= first_above_;
+}
+
+bool CoDel::should_drop(std::chrono::nanoseconds sojourn, Clock::time_point now, bool queue_empty) {
+    bool bad = above_target(sojourn, now, queue_empty);
+
+    if (dropping_) {
+        if (!bad) {
+            dropping_ = false;
+            return false;
+        }
+        if (now < drop_next_) return false;
+        ++count_;
+        drop_next_ = control_law(drop_next_);
+        return true;
+    }
+
+    if (!bad) return false;
+
+    // Re-entering soon after the last dropping state resumes near its drop rate.
+    dropping_ = true;
+    size_t delta = count_ - last_count_;
+    count_ = delta > 1 && now - drop_next_ < 16 * interval_ ? delta : 1;
+    last_count_ = count_;
+    drop_next_ = control_law(now);
+    return true;
+}
@@ -0,0 +1,80 @@
+#include "../include/server/cdr_flusher.hpp"
+#include "../include/server/thread_topology.hpp"
+
+CdrFlusher::CdrFlusher(CdrWriter& writer) : writer_(writer) {}
+
+CdrFlusher::~CdrFlusher() {
+    stop();
+}
+
+void CdrFlusher::start(const std::string& name, const std::vector<int>& cpus) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) return;
+        running_ = true;
+    }
+    thread_ = std::thread([this, name, cpus]() {
+        apply_thread_role(name, cpus);
+        run();
+    });
+}
+
+void CdrFlusher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) return;
+        running_ = false;
+    }
+    work_ready_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+// Returns false, so the coroutine goes on at once, when no flusher thread
+// runs and the records were written right here.
+bool CdrFlusher::hand_over(const Pending& pending) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) {
+            pending_.push_back(pending);
+            // Only the first hand-over since the thread took the last batch has to wake it.
+            if (pending_.size() == 1) work_ready_.notify(1);
+            return true;
+        }
+    }
+    writer_.write(*pending.records);
+    return false;
+}
+
+void CdrFlusher::run() {
+    std::vector<Pending> batch;
+    std::vector<CdrRecord> records;
+    while (true) {
+        uint32_t epoch = work_ready_.prepare_wait();
+        bool running;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            batch.swap(pending_);
+            running = running_;
+        }
+        if (batch.empty()) {
+            if (!running) {
+                work_ready_.finish_wait();
+                break;
+            }
+            work_ready_.wait(epoch);
+            work_ready_.finish_wait();
+            continue;
+        }
+        work_ready_.finish_wait();
+
+        records.clear();
+        for (const Pending& pending : batch) {
+            records.insert(records.end(), pending.records->begin(), pending.records->end());
+        }
+        writer_.write(records);
+        for (const Pending& pending : batch) {
+            pending.executor->post(pending.handle);
+        }
+        batch.clear();
+    }
+}
@@ -9,6 +9,12 @@ CdrWriter::CdrWriter(const std::string& cdr_file, std::ostream& test_stream)
 #endif
 
 void CdrWriter::write(const std::string& imsi, const std::string& action) {
+    write(std::vector<CdrRecord>{{imsi, action}});
+}
+
+void CdrWriter::write(const std::vector<CdrRecord>& records) {
+    if (records.empty()) return;
+
 #ifdef TESTING
     std::ostream* out = test_stream_;
     std::ofstream file;
@@ -31,12 +37,20 @@ void CdrWriter::write(const std::string& imsi, const std::string& action) {
     std::ostringstream oss;
     oss << std::put_time(std::localtime(&time_t_now), "%Y-%m-%d %H:%M:%S");
 
-    *out << oss.str() << ", " << imsi << ", " << action << "\n";
+    for (const auto& record : records) {
+        *out << oss.str() << ", " << record.imsi << ", " << record.action << "\n";
+    }
 
     if (!(*out)) {
-        spdlog::error("Failed to write CDR record for IMSI {} to file {}", imsi, cdr_file_);
-    } else {
-        spdlog::debug("CDR record written: {} | {} | {}", oss.str(), imsi, action);
+        if (records.size() == 1) {
+            spdlog::error("Failed to write CDR record for IMSI {} to file {}", records[0].imsi, cdr_file_);
+        } else {
+            spdlog::error("Failed to write {} CDR records to file {}", records.size(), cdr_file_);
+        }
+        return;
+    }
+    for (const auto& record : records) {
+        spdlog::debug("CDR record written: {} | {} | {}", oss.str(), record.imsi, record.action);
     }
 }
 
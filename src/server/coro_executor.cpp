@@ -0,0 +1,210 @@
+#include "../include/server/coro_executor.hpp"
+#include <spdlog/spdlog.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+
+namespace {
+// epoll_event.data.ptr of the executor's own descriptors; every other event
+// carries the ReadableAwaiter waiting for it.
+char WAKE_TAG;
+char TIMER_TAG;
+char STOP_TAG;
+}
+
+void CoroTask::promise_type::unhandled_exception() {
+    try {
+        throw;
+    } catch (const std::exception& e) {
+        spdlog::error("Coroutine failed: {}", e.what());
+    } catch (...) {
+        spdlog::error("Coroutine failed with an unknown exception");
+    }
+}
+
+CoroExecutor::~CoroExecutor() {
+    if (epoll_fd_ != -1) close(epoll_fd_);
+    if (wake_fd_ != -1) close(wake_fd_);
+    if (timer_fd_ != -1) close(timer_fd_);
+}
+
+bool CoroExecutor::open() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (epoll_fd_ == -1 || wake_fd_ == -1 || timer_fd_ == -1) {
+        spdlog::critical("Coroutine executor setup failed: {}", strerror(errno));
+        return false;
+    }
+
+    epoll_event wake{};
+    wake.events = EPOLLIN;
+    wake.data.ptr = &WAKE_TAG;
+    epoll_event timer{};
+    timer.events = EPOLLIN;
+    timer.data.ptr = &TIMER_TAG;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &wake) == -1 ||
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &timer) == -1) {
+        spdlog::critical("epoll_ctl failed: {}", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void CoroExecutor::spawn(CoroTask task) {
+    std::coroutine_handle<CoroTask::promise_type> handle = std::exchange(task.handle_, {});
+    handle.promise().executor = this;
+    ++tasks_;
+    handle.resume();
+}
+
+void CoroExecutor::post(std::coroutine_handle<> handle) {
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(posted_mutex_);
+        wake = posted_.empty();
+        posted_.push_back(handle);
+    }
+    uint64_t one = 1;
+    if (wake && write(wake_fd_, &one, sizeof(one)) != sizeof(one)) {
+        spdlog::error("Failed to wake the coroutine executor: {}", strerror(errno));
+    }
+}
+
+// Level-triggered one-shot registration: a descriptor that is already
+// readable reports at once, and is re-armed by the next readable(). One
+// coroutine per descriptor may wait at a time.
+bool CoroExecutor::watch(ReadableAwaiter& awaiter) {
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.ptr = &awaiter;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, awaiter.fd_, &ev) == -1 &&
+        (errno != ENOENT || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, awaiter.fd_, &ev) == -1)) {
+        spdlog::error("Cannot wait for descriptor {}: {}", awaiter.fd_, strerror(errno));
+        return false;
+    }
+    waiting_.insert(&awaiter);
+    return true;
+}
+
+void CoroExecutor::add_timer(Clock::time_point deadline, std::coroutine_handle<> handle) {
+    timers_.push({deadline, handle});
+    if (deadline < armed_) arm_timer();
+}
+
+// The timerfd always holds the earliest deadline, so epoll_wait sleeps with
+// nanosecond rather than millisecond precision.
+void CoroExecutor::arm_timer() {
+    armed_ = timers_.empty() ? Clock::time_point::max() : timers_.top().deadline;
+    itimerspec spec{};
+    if (!timers_.empty()) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(armed_.time_since_epoch()).count();
+        // A zero value would disarm the timer.
+        if (ns <= 0) ns = 1;
+        spec.it_value.tv_sec = ns / 1000000000;
+        spec.it_value.tv_nsec = ns % 1000000000;
+    }
+    timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void CoroExecutor::fire_timers() {
+    uint64_t expirations;
+    while (read(timer_fd_, &expirations, sizeof(expirations)) > 0) {
+    }
+    auto now = Clock::now();
+    while (!timers_.empty() && timers_.top().deadline <= now) {
+        std::coroutine_handle<> handle = timers_.top().handle;
+        timers_.pop();
+        handle.resume();
+    }
+    arm_timer();
+}
+
+void CoroExecutor::resume_posted() {
+    uint64_t count;
+    while (read(wake_fd_, &count, sizeof(count)) > 0) {
+    }
+    {
+        std::lock_guard<std::mutex> lock(posted_mutex_);
+        resuming_.swap(posted_);
+    }
+    for (std::coroutine_handle<> handle : resuming_) {
+        handle.resume();
+    }
+    resuming_.clear();
+}
+
+// Every coroutine waiting for a descriptor gets false from its readable().
+void CoroExecutor::cancel_waits() {
+    std::unordered_set<ReadableAwaiter*> waiting;
+    waiting.swap(waiting_);
+    for (ReadableAwaiter* awaiter : waiting) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, awaiter->fd_, nullptr);
+        awaiter->ready_ = false;
+        awaiter->handle_.resume();
+    }
+}
+
+void CoroExecutor::stop() {
+    stopped_ = true;
+    stopping_ = true;
+}
+
+bool CoroExecutor::run(int stop_fd) {
+    if (stop_fd != -1 && !stopping_) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = &STOP_TAG;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, stop_fd, &ev) == -1) {
+            spdlog::error("epoll_ctl failed: {}", strerror(errno));
+            return false;
+        }
+        stop_fd_ = stop_fd;
+    }
+
+    const int MAX_EVENTS = 64;
+    epoll_event events[MAX_EVENTS];
+    bool failed = false;
+    while (true) {
+        if (stopping_) {
+            // Left unread for the other reactors, so it would report forever.
+            if (stop_fd_ != -1) {
+                epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, stop_fd_, nullptr);
+                stop_fd_ = -1;
+            }
+            cancel_waits();
+            if (tasks_ == 0) break;
+        }
+
+        int nfds = epoll_wait(epoll_fd_, events, MAX_EVENTS, -1);
+        if (nfds == -1) {
+            if (errno == EINTR) continue;
+            spdlog::error("epoll_wait failed: {}", strerror(errno));
+            // Tasks still suspended are abandoned; their frames are leaked, not resumed.
+            failed = true;
+            break;
+        }
+
+        for (int i = 0; i < nfds; ++i) {
+            void* tag = events[i].data.ptr;
+            if (tag == &STOP_TAG) {
+                stopping_ = true;
+            } else if (tag == &WAKE_TAG) {
+                resume_posted();
+            } else if (tag == &TIMER_TAG) {
+                fire_timers();
+            } else {
+                auto* awaiter = static_cast<ReadableAwaiter*>(tag);
+                // Stale unless the awaiter is still registered.
+                if (waiting_.erase(awaiter) == 0) continue;
+                awaiter->ready_ = true;
+                awaiter->handle_.resume();
+            }
+        }
+    }
+    return !failed && !stopped_;
+}
@@ -0,0 +1,93 @@
+#include "../include/server/cpu_budget.hpp"
+#include "../include/config_loader.hpp"
+#include <sched.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace {
+// The cgroup v2 path of the process: the "0::<path>" line of /proc/self/cgroup.
+// Empty on a cgroup v1 only host.
+std::string read_cgroup_path(const std::string& proc_self_cgroup) {
+    std::ifstream file(proc_self_cgroup);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.rfind("0::", 0) == 0) return line.substr(3);
+    }
+    return "";
+}
+
+// cpu.max holds "<quota> <period>" in microseconds, or "max <period>" without a quota.
+double read_quota(const std::string& dir) {
+    std::ifstream file(dir + "/cpu.max");
+    std::string quota;
+    double period = 0;
+    if (!(file >> quota >> period) || quota == "max" || period <= 0) return 0;
+    try {
+        return std::stod(quota) / period;
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+unsigned read_cpuset(const std::string& dir) {
+    std::ifstream file(dir + "/cpuset.cpus.effective");
+    std::string list;
+    std::vector<int> cpus;
+    if (!std::getline(file, list) || !parse_cpu_list(list, cpus)) return 0;
+    return static_cast<unsigned>(cpus.size());
+}
+
+unsigned affinity_cpus() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return 0;
+    return static_cast<unsigned>(CPU_COUNT(&set));
+}
+}
+
+unsigned CpuBudget::cpus() const {
+    unsigned cpus = hardware;
+    auto limit = [&cpus](unsigned value) {
+        if (value > 0 && (cpus == 0 || value < cpus)) cpus = value;
+    };
+    limit(affinity);
+    limit(cpuset);
+    if (quota > 0) limit(static_cast<unsigned>(std::ceil(quota)));
+    return std::max(cpus, 1u);
+}
+
+std::string CpuBudget::describe() const {
+    auto value = [](unsigned count) { return count > 0 ? std::to_string(count) : std::string("-"); };
+    std::ostringstream text;
+    text << "cpu.max ";
+    if (quota > 0) {
+        text << quota;
+    } else {
+        text << "-";
+    }
+    text << ", cpuset " << value(cpuset) << ", affinity " << value(affinity) << ", hardware " << value(hardware);
+    return text.str();
+}
+
+// A quota on any ancestor caps the cgroup as well, so the walk goes up to the mount root.
+CpuBudget detect_cpu_budget(const std::string& cgroup_mount, const std::string& proc_self_cgroup) {
+    CpuBudget budget;
+    budget.hardware = std::thread::hardware_concurrency();
+    budget.affinity = affinity_cpus();
+
+    std::string path = read_cgroup_path(proc_self_cgroup);
+    if (path.empty() || path[0] != '/') return budget;
+
+    budget.cpuset = read_cpuset(cgroup_mount + path);
+    while (true) {
+        double quota = read_quota(cgroup_mount + path);
+        if (quota > 0 && (budget.quota == 0 || quota < budget.quota)) budget.quota = quota;
+        if (path == "/") break;
+        size_t parent = path.find_last_of('/');
+        path = parent == 0 ? "/" : path.substr(0, parent);
+    }
+    return budget;
+}
@@ -1,11 +1,91 @@
 #include "../include/server/decode_utils.hpp"
 
+namespace {
+// FNV-1a over the IMSI characters.
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+uint64_t hash_char(uint64_t hash, char c) {
+    return (hash ^ static_cast<uint8_t>(c)) * FNV_PRIME;
+}
+
+// Appends one digit to a key under construction; a 16th digit makes it 0.
+ImsiKey push_digit(ImsiKey key, uint8_t digit) {
+    size_t count = imsi_digits(key);
+    if (count == MAX_IMSI_DIGITS) return 0;
+    uint64_t value = key & ((1ULL << 56) - 1);
+    return (static_cast<uint64_t>(count + 1) << 56) | (value * 10 + digit);
+}
+}
+
+ImsiKey pack_imsi(const std::string& digits) {
+    if (digits.empty() || digits.size() > MAX_IMSI_DIGITS) return 0;
+    ImsiKey key = 0;
+    for (char c : digits) {
+        if (c < '0' || c > '9') return 0;
+        key = push_digit(key, c - '0');
+    }
+    return key;
+}
+
+std::string unpack_imsi(ImsiKey key) {
+    std::string digits(imsi_digits(key), '0');
+    uint64_t value = key & ((1ULL << 56) - 1);
+    for (size_t i = digits.size(); i > 0; --i) {
+        digits[i - 1] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return digits;
+}
+
 std::string BcdDecoder::decode(const std::vector<uint8_t>& bcd) const {
+    return decode(bcd.data(), bcd.size());
+}
+
+std::string BcdDecoder::decode(const uint8_t* bcd, size_t len) const {
     std::string imsi;
-    for (auto byte : bcd) {
-        uint8_t low = byte & 0x0F;
-        uint8_t high = (byte >> 4) & 0x0F;
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t low = bcd[i] & 0x0F;
+        uint8_t high = (bcd[i] >> 4) & 0x0F;
         if (low < 10) imsi += ('0' + low);
         if (high < 10) imsi += ('0' + high);
     }
     return imsi;}
+
+uint64_t BcdDecoder::hash(const uint8_t* bcd, size_t len) const {
+    uint64_t result = FNV_OFFSET;
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t low = bcd[i] & 0x0F;
+        uint8_t high = (bcd[i] >> 4) & 0x0F;
+        if (low < 10) result = hash_char(result, '0' + low);
+        if (high < 10) result = hash_char(result, '0' + high);
+    }
+    return result;
+}
+
+uint64_t BcdDecoder::hash(const std::string& imsi) const {
+    uint64_t result = FNV_OFFSET;
+    for (char c : imsi) {
+        result = hash_char(result, c);
+    }
+    return result;
+}
+
+ImsiKey BcdDecoder::pack(const uint8_t* bcd, size_t len) const {
+    ImsiKey key = 0;
+    size_t digits = 0;
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t low = bcd[i] & 0x0F;
+        uint8_t high = (bcd[i] >> 4) & 0x0F;
+        if (low < 10) {
+            key = push_digit(key, low);
+            ++digits;
+        }
+        if (high < 10) {
+            key = push_digit(key, high);
+            ++digits;
+        }
+        if (digits > MAX_IMSI_DIGITS) return 0;
+    }
+    return key;
+}
@@ -0,0 +1,25 @@
+#include "../include/server/elastic_policy.hpp"
+#include <algorithm>
+
+ElasticPolicy::ElasticPolicy(const ElasticLimits& limits, size_t workers) : limits_(limits) {
+    limits_.min_workers = std::max<size_t>(limits_.min_workers, 1);
+    limits_.max_workers = std::max(limits_.max_workers, limits_.min_workers);
+    workers_ = std::clamp(workers, limits_.min_workers, limits_.max_workers);
+}
+
+size_t ElasticPolicy::update(size_t depth, std::chrono::nanoseconds peak_sojourn) {
+    bool hot = peak_sojourn > limits_.grow_sojourn || depth > workers_ * limits_.grow_depth;
+    bool calm = peak_sojourn <= limits_.shrink_sojourn && depth < workers_;
+
+    if (hot) {
+        calm_samples_ = 0;
+        workers_ = std::min(limits_.max_workers, workers_ + std::max<size_t>(workers_ / 2, 1));
+    } else if (!calm) {
+        calm_samples_ = 0;
+    } else if (++calm_samples_ >= limits_.shrink_after) {
+        // The streak starts over, so the pool sheds at most one worker per `shrink_after` samples.
+        calm_samples_ = 0;
+        workers_ = std::max(limits_.min_workers, workers_ - 1);
+    }
+    return workers_;
+}
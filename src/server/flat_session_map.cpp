@@ -0,0 +1,145 @@
+#include "../include/server/flat_session_map.hpp"
+#include <algorithm>
+
+// The wheel starts at the current tick, whatever the epoch: sessions started
+// before it wait aside until their first expire().
+FlatSessionMap::FlatSessionMap(Clock::time_point epoch, std::chrono::milliseconds tick)
+    : epoch_(epoch), tick_(std::max<Clock::duration>(tick, std::chrono::milliseconds(1))),
+      keys_(MIN_CAPACITY, 0), started_(MIN_CAPACITY, 0), phase_(MIN_CAPACITY, 0), bits_(4), wheel_(stamp(Clock::now())) {}
+
+// Fibonacci hashing: one multiplication, and the top bits pick the slot, so
+// neighbouring IMSIs land far apart.
+size_t FlatSessionMap::slot_of(ImsiKey imsi) const {
+    return static_cast<size_t>((imsi * 0x9e3779b97f4a7c15ULL) >> (64 - bits_));
+}
+
+size_t FlatSessionMap::find(ImsiKey imsi) const {
+    size_t mask = keys_.size() - 1;
+    size_t slot = slot_of(imsi);
+    while (keys_[slot] != 0 && keys_[slot] != imsi) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Rounded down, also before the epoch, so two times a whole number of
+// ticks apart get stamps exactly that far apart.
+uint32_t FlatSessionMap::stamp(Clock::time_point time) const {
+    Clock::duration since = time - epoch_;
+    int64_t ticks = since / tick_;
+    if (since % tick_ < Clock::duration::zero()) --ticks;
+    return static_cast<uint32_t>(ticks);
+}
+
+uint16_t FlatSessionMap::phase(Clock::time_point time) const {
+    Clock::duration into = (time - epoch_) % tick_;
+    if (into < Clock::duration::zero()) into += tick_;
+    return static_cast<uint16_t>(into * 65536 / tick_);
+}
+
+bool FlatSessionMap::open(ImsiKey imsi, Clock::time_point now) {
+    if (imsi == 0) return false;
+    // At most three quarters full, so a probe run stays a few slots long.
+    if ((size_ + 1) * 4 > keys_.size() * 3) grow();
+    size_t slot = find(imsi);
+    if (keys_[slot] == imsi) return false;
+    keys_[slot] = imsi;
+    started_[slot] = stamp(now);
+    phase_[slot] = phase(now);
+    wheel_.schedule(static_cast<uint32_t>(slot), started_[slot]);
+    ++size_;
+    return true;
+}
+
+// The wheel entry for the old start stays behind and is dropped when reached.
+void FlatSessionMap::insert(ImsiKey imsi, Clock::time_point started) {
+    if (open(imsi, started) || imsi == 0) return;
+    size_t slot = find(imsi);
+    uint32_t tick = stamp(started);
+    phase_[slot] = phase(started);
+    if (started_[slot] == tick) return;
+    started_[slot] = tick;
+    wheel_.schedule(static_cast<uint32_t>(slot), tick);
+}
+
+bool FlatSessionMap::contains(ImsiKey imsi) const {
+    return imsi != 0 && keys_[find(imsi)] == imsi;
+}
+
+void FlatSessionMap::expire(Clock::time_point now, std::chrono::milliseconds timeout, std::vector<ImsiKey>& expired) {
+    int64_t timeout_ticks = (timeout + tick_ - Clock::duration(1)) / tick_;
+    // A session is due once it is timeout_ticks + 1 ticks old. Those that
+    // started before tick `last` are; those that started in it only if they
+    // started no later in it than `now` is in its own tick.
+    uint32_t last = stamp(now) - static_cast<uint32_t>(timeout_ticks + 1);
+    uint16_t now_phase = phase(now);
+    due_.clear();
+    wheel_.advance(last, started_, due_);
+    // The keys are taken first, as each removal may shift due sessions to
+    // other slots. A slot can come out of the wheel twice, or hold a session
+    // that is not due after all, when its entry was left behind. A session
+    // of tick `last` not due yet goes back, to wait aside for the next sweep.
+    size_t first = expired.size();
+    for (uint32_t slot : due_) {
+        if (keys_[slot] == 0) continue;
+        int32_t behind = static_cast<int32_t>(started_[slot] - last);
+        if (behind < 0 || (behind == 0 && phase_[slot] <= now_phase)) {
+            expired.push_back(keys_[slot]);
+        } else if (behind == 0) {
+            wheel_.schedule(slot, started_[slot]);
+        }
+    }
+    size_t kept = first;
+    for (size_t i = first; i < expired.size(); ++i) {
+        size_t slot = find(expired[i]);
+        if (keys_[slot] != expired[i]) continue;
+        erase_at(slot);
+        expired[kept++] = expired[i];
+    }
+    expired.resize(kept);
+}
+
+size_t FlatSessionMap::place(ImsiKey imsi, uint32_t started, uint16_t phase) {
+    size_t mask = keys_.size() - 1;
+    size_t slot = slot_of(imsi);
+    while (keys_[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    keys_[slot] = imsi;
+    started_[slot] = started;
+    phase_[slot] = phase;
+    return slot;
+}
+
+void FlatSessionMap::grow() {
+    std::vector<ImsiKey> keys(keys_.size() * 2, 0);
+    std::vector<uint32_t> started(started_.size() * 2, 0);
+    std::vector<uint16_t> phases(phase_.size() * 2, 0);
+    keys.swap(keys_);
+    started.swap(started_);
+    phases.swap(phase_);
+    ++bits_;
+    wheel_.clear();
+    for (size_t slot = 0; slot < keys.size(); ++slot) {
+        if (keys[slot] != 0) wheel_.schedule(static_cast<uint32_t>(place(keys[slot], started[slot], phases[slot])), started[slot]);
+    }
+}
+
+// Every session after the hole that may live there, because its home slot
+// is not past the hole, moves back into it, until an empty slot ends the run.
+void FlatSessionMap::erase_at(size_t slot) {
+    size_t mask = keys_.size() - 1;
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & mask; keys_[next] != 0; next = (next + 1) & mask) {
+        size_t home = slot_of(keys_[next]);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            keys_[hole] = keys_[next];
+            started_[hole] = started_[next];
+            phase_[hole] = phase_[next];
+            wheel_.schedule(static_cast<uint32_t>(hole), started_[hole]);
+            hole = next;
+        }
+    }
+    keys_[hole] = 0;
+    --size_;
+}
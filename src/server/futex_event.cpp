@@ -0,0 +1,38 @@
+#include "../include/server/futex_event.hpp"
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+
+namespace {
+long futex(std::atomic<uint32_t>* word, int op, uint32_t value) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, value, nullptr, nullptr, 0);
+}
+}
+
+// The fence pairs with the one in notify(): either the producer sees this
+// waiter, or the consumer's re-check sees the producer's item.
+uint32_t FutexEvent::prepare_wait() {
+    waiters_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return epoch_.load(std::memory_order_acquire);
+}
+
+void FutexEvent::wait(uint32_t epoch) {
+    futex(&epoch_, FUTEX_WAIT_PRIVATE, epoch);
+}
+
+void FutexEvent::finish_wait() {
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void FutexEvent::notify(int count) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) == 0) return;
+    epoch_.fetch_add(1, std::memory_order_release);
+    futex(&epoch_, FUTEX_WAKE_PRIVATE, static_cast<uint32_t>(count));
+}
+
+void FutexEvent::notify_all() {
+    notify(INT_MAX);
+}
@@ -1,16 +1,18 @@
 #include "../include/server/http_api.hpp"
+#include "../include/server/thread_topology.hpp"
 #include <httplib.h>
 #include <spdlog/spdlog.h>
 
 HttpServer::HttpServer(const ServerConfig& config,
                        std::atomic<bool>& running,
-                       std::unordered_map<std::string, std::chrono::steady_clock::time_point>& sessions,
-                       std::mutex& session_mutex,
-                       int event_fd)
-    : config_(config), running_(running), sessions_(sessions), session_mutex_(session_mutex), event_fd_(event_fd) {}
+                       SessionStore& sessions,
+                       int event_fd,
+                       const ServerStats* stats)
+    : config_(config), running_(running), sessions_(sessions), event_fd_(event_fd), stats_(stats) {}
 
 void HttpServer::run() {
     server_thread_ = std::thread([this]() {
+        apply_thread_role("pgw-http", config_.http_cpus);
         svr_.Get("/check_subscriber", [this](const httplib::Request& req, httplib::Response& res) {
             if (!req.has_param("imsi")) {
                 res.status = 400;
@@ -20,18 +22,18 @@ void HttpServer::run() {
             
             auto imsi = req.get_param_value("imsi");
 
-            std::string status = "not active";
-            {
-                std::lock_guard<std::mutex> lock(session_mutex_);
-                if (sessions_.count(imsi)) {
-                    status = "active";
-                }
-            }
+            std::string status = sessions_.active(imsi) ? "active" : "not active";
 
             res.set_content(status + '\n', "text/plain");
             spdlog::info("/check_subscriber imsi={} → {}", imsi, status);
         });
 
+        if (stats_) {
+            svr_.Get("/stats", [this](const httplib::Request&, httplib::Response& res) {
+                res.set_content(stats_->render(), "text/plain");
+            });
+        }
+
         svr_.Post("/stop", [this](const httplib::Request&, httplib::Response& res) {
             running_ = false;
 
@@ -0,0 +1,201 @@
+#include "../include/server/ingress_backend.hpp"
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace {
+// struct epoll_params and EPIOCSPARAMS from <linux/eventpoll.h>, Linux 6.9+.
+struct EpollBusyPollParams {
+    uint32_t busy_poll_usecs;
+    uint16_t busy_poll_budget;
+    uint8_t prefer_busy_poll;
+    uint8_t pad;
+};
+constexpr unsigned long EPOLL_SET_PARAMS = _IOW(0x8A, 0x01, EpollBusyPollParams);
+// Packets per busy poll; the kernel refuses more than NAPI_POLL_WEIGHT without CAP_NET_ADMIN.
+constexpr uint16_t BUSY_POLL_BUDGET = 64;
+}
+
+std::unique_ptr<UdpSendBatch> IngressBackend::make_send_batch(size_t capacity) const {
+    return std::make_unique<UdpSendBatch>(capacity);
+}
+
+EpollBackend::EpollBackend(size_t batch_size, int busy_poll_us)
+    : batch_size_(batch_size), busy_poll_us_(busy_poll_us), rx_batch_(batch_size > 1 ? batch_size : 0) {
+    datagrams_.reserve(batch_size);
+}
+
+EpollBackend::~EpollBackend() {
+    if (epoll_fd_ != -1) close(epoll_fd_);
+}
+
+bool EpollBackend::open(int sockfd, int event_fd) {
+    epoll_fd_ = epoll_create1(0);
+    if (epoll_fd_ == -1) {
+        spdlog::critical("epoll_create1 failed: {}", strerror(errno));
+        return false;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = sockfd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, sockfd, &ev) == -1) {
+        spdlog::critical("epoll_ctl failed: {}", strerror(errno));
+        close(epoll_fd_);
+        epoll_fd_ = -1;
+        return false;
+    }
+
+    if (event_fd != -1) {
+        epoll_event ev_event{};
+        ev_event.events = EPOLLIN;
+        ev_event.data.fd = event_fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd, &ev_event);
+    }
+    sockfd_ = sockfd;
+    event_fd_ = event_fd;
+    if (busy_poll_us_ > 0) enable_busy_poll();
+    return true;
+}
+
+// Older kernels only busy poll epoll through net.core.busy_poll, so a failure is not fatal.
+void EpollBackend::enable_busy_poll() {
+    EpollBusyPollParams params{};
+    params.busy_poll_usecs = static_cast<uint32_t>(busy_poll_us_);
+    params.busy_poll_budget = BUSY_POLL_BUDGET;
+    if (ioctl(epoll_fd_, EPOLL_SET_PARAMS, &params) == -1) {
+        spdlog::warn("epoll busy polling unavailable ({}), set net.core.busy_poll instead", strerror(errno));
+    }
+}
+
+bool EpollBackend::serve(IngressSink& sink) {
+    const int MAX_EVENTS = 16;
+    epoll_event events[MAX_EVENTS];
+
+    while (true) {
+        int nfds = epoll_wait(epoll_fd_, events, MAX_EVENTS, -1);
+        if (nfds == -1) {
+            if (errno == EINTR) continue;
+            spdlog::error("epoll_wait failed: {}", strerror(errno));
+            return false;
+        }
+
+        for (int i = 0; i < nfds; ++i) {
+            // The eventfd is left unread so that it stays readable for every reactor.
+            if (events[i].data.fd == event_fd_) return true;
+            if (events[i].data.fd == sockfd_ && !drain(sink)) return false;
+        }
+    }
+}
+
+bool EpollBackend::drain(IngressSink& sink) {
+    if (batch_size_ <= 1) {
+        uint8_t buffer[UdpRecvBatch::MAX_DATAGRAM_SIZE];
+        uint64_t control[RXQ_OVFL_CONTROL_SIZE / sizeof(uint64_t)];
+        Datagram datagram{buffer, 0, {}};
+        iovec iov{buffer, sizeof(buffer)};
+        msghdr msg{};
+        msg.msg_name = &datagram.source;
+        msg.msg_namelen = sizeof(datagram.source);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t n = recvmsg(sockfd_, &msg, 0);
+        if (n > 0) {
+            uint32_t drops = 0;
+            if (read_rxq_ovfl(msg, drops)) kernel_drops_.store(drops, std::memory_order_relaxed);
+            datagram.length = n;
+            sink.deliver(&datagram, 1, 1);
+        }
+        return true;
+    }
+
+    while (true) {
+        int n = rx_batch_.receive(sockfd_);
+        if (n < 0) return false;
+        if (n == 0) return true;
+
+        // Empty datagrams are skipped, as on the single-recvmsg path.
+        datagrams_.clear();
+        for (int i = 0; i < n; ++i) {
+            if (rx_batch_.length(i) == 0) continue;
+            datagrams_.push_back({rx_batch_.data(i), rx_batch_.length(i), rx_batch_.address(i)});
+        }
+        if (!datagrams_.empty()) sink.deliver(datagrams_.data(), datagrams_.size(), rx_batch_.capacity());
+
+        // A short batch means recvmmsg already hit EAGAIN: the socket is drained.
+        if (static_cast<size_t>(n) < rx_batch_.capacity()) return true;
+    }
+}
+
+uint64_t EpollBackend::kernel_drops() {
+    return batch_size_ <= 1 ? kernel_drops_.load(std::memory_order_relaxed) : rx_batch_.kernel_drops();
+}
+
+IoUringBackend::IoUringBackend(size_t batch_size) : receiver_(batch_size) {
+    datagrams_.reserve(batch_size);
+}
+
+bool IoUringBackend::open(int sockfd, int event_fd) {
+    return receiver_.init(sockfd, event_fd);
+}
+
+bool IoUringBackend::serve(IngressSink& sink) {
+    while (true) {
+        int n = receiver_.wait();
+        if (n < 0) return false;
+        if (n > 0) {
+            datagrams_.clear();
+            for (int i = 0; i < n; ++i) {
+                datagrams_.push_back({receiver_.data(i), receiver_.length(i), receiver_.address(i)});
+            }
+            sink.deliver(datagrams_.data(), n, receiver_.capacity());
+        }
+        if (receiver_.shutdown_requested()) return true;
+    }
+}
+
+std::unique_ptr<UdpSendBatch> IoUringBackend::make_send_batch(size_t capacity) const {
+    return std::make_unique<IoUringSendBatch>(capacity);
+}
+
+PacketRingBackend::PacketRingBackend(const std::string& interface, const std::string& ip, uint16_t port)
+    : interface_(interface), ip_(ip), port_(port) {
+    datagrams_.reserve(PacketRing::BLOCK_BYTES / 64);
+}
+
+bool PacketRingBackend::open(int /*sockfd*/, int event_fd) {
+    event_fd_ = event_fd;
+    return ring_.open(interface_, ip_, port_);
+}
+
+bool PacketRingBackend::serve(IngressSink& sink) {
+    pollfd fds[2] = {{ring_.fd(), POLLIN, 0}, {event_fd_, POLLIN, 0}};
+
+    while (true) {
+        while (ring_.next_block()) {
+            if (ring_.size() > 0) {
+                datagrams_.clear();
+                for (size_t i = 0; i < ring_.size(); ++i) {
+                    datagrams_.push_back({ring_.data(i), ring_.length(i), ring_.address(i)});
+                }
+                sink.deliver(datagrams_.data(), datagrams_.size(), datagrams_.size());
+            }
+            ring_.release_block();
+        }
+
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR) continue;
+            spdlog::error("poll failed: {}", strerror(errno));
+            return false;
+        }
+        if (fds[1].revents & POLLIN) return true;
+    }
+}
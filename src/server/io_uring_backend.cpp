@@ -0,0 +1,358 @@
+#include "../include/server/io_uring_backend.hpp"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace {
+constexpr uint64_t RECV_TAG = 1;
+constexpr uint64_t SHUTDOWN_TAG = 2;
+constexpr uint64_t CANCEL_TAG = 3;
+constexpr uint16_t BUFFER_GROUP = 0;
+
+void* map_ring(size_t size, int ring_fd, off_t offset) {
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+template <typename T>
+T* ring_field(void* base, uint32_t offset) {
+    return reinterpret_cast<T*>(static_cast<uint8_t*>(base) + offset);
+}
+}
+
+IoUring::~IoUring() {
+    reset();
+}
+
+bool IoUring::init(unsigned sq_entries, unsigned cq_entries) {
+    io_uring_params params{};
+    if (cq_entries > 0) {
+        params.flags |= IORING_SETUP_CQSIZE;
+        params.cq_entries = cq_entries;
+    }
+
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, sq_entries, &params));
+    if (fd < 0) return false;
+    ring_fd_ = fd;
+
+    sq_map_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_map_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_map_size_ = cq_map_size_ = std::max(sq_map_size_, cq_map_size_);
+    }
+
+    sq_ptr_ = map_ring(sq_map_size_, ring_fd_, IORING_OFF_SQ_RING);
+    cq_ptr_ = single_mmap ? sq_ptr_ : map_ring(cq_map_size_, ring_fd_, IORING_OFF_CQ_RING);
+    sqes_map_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(map_ring(sqes_map_size_, ring_fd_, IORING_OFF_SQES));
+    if (!sq_ptr_ || !cq_ptr_ || !sqes_) {
+        int err = errno;
+        reset();
+        errno = err;
+        return false;
+    }
+
+    sq_head_ = ring_field<unsigned>(sq_ptr_, params.sq_off.head);
+    sq_tail_ = ring_field<unsigned>(sq_ptr_, params.sq_off.tail);
+    sq_mask_ = *ring_field<unsigned>(sq_ptr_, params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    sqe_tail_ = submitted_tail_ = *sq_tail_;
+
+    // SQE slots are handed out in ring order, so the indirection array is the identity.
+    unsigned* sq_array = ring_field<unsigned>(sq_ptr_, params.sq_off.array);
+    for (unsigned i = 0; i < sq_entries_; ++i) {
+        sq_array[i] = i;
+    }
+
+    cq_head_ = ring_field<unsigned>(cq_ptr_, params.cq_off.head);
+    cq_tail_ = ring_field<unsigned>(cq_ptr_, params.cq_off.tail);
+    cq_mask_ = *ring_field<unsigned>(cq_ptr_, params.cq_off.ring_mask);
+    cqes_ = ring_field<io_uring_cqe>(cq_ptr_, params.cq_off.cqes);
+    return true;
+}
+
+void IoUring::reset() {
+    if (sqes_) munmap(sqes_, sqes_map_size_);
+    if (cq_ptr_ && cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_map_size_);
+    if (sq_ptr_) munmap(sq_ptr_, sq_map_size_);
+    if (ring_fd_ != -1) close(ring_fd_);
+    sqes_ = nullptr;
+    cq_ptr_ = nullptr;
+    sq_ptr_ = nullptr;
+    ring_fd_ = -1;
+}
+
+io_uring_sqe* IoUring::get_sqe() {
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (sqe_tail_ - head >= sq_entries_) return nullptr;
+
+    io_uring_sqe* sqe = &sqes_[sqe_tail_ & sq_mask_];
+    ++sqe_tail_;
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+int IoUring::submit_and_wait(unsigned wait_nr) {
+    unsigned pending = sqe_tail_ - submitted_tail_;
+    if (pending == 0 && wait_nr == 0) return 0;
+    __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+
+    unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    while (true) {
+        int ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, pending, wait_nr, flags, nullptr, 0));
+        if (ret >= 0) {
+            submitted_tail_ += ret;
+            return ret;
+        }
+        if (errno != EINTR) return -1;
+    }
+}
+
+io_uring_cqe* IoUring::peek_cqe() {
+    unsigned head = *cq_head_;
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) return nullptr;
+    return &cqes_[head & cq_mask_];
+}
+
+void IoUring::cqe_seen() {
+    __atomic_store_n(cq_head_, *cq_head_ + 1, __ATOMIC_RELEASE);
+}
+
+IoUringReceiver::IoUringReceiver(size_t capacity)
+    : buffers_(BUFFER_COUNT * BUFFER_SIZE), capacity_(std::min<size_t>(capacity, BUFFER_COUNT)) {
+    entries_.reserve(capacity_);
+    recv_msg_.msg_namelen = sizeof(sockaddr_in);
+    recv_msg_.msg_controllen = RXQ_OVFL_CONTROL_SIZE;
+}
+
+IoUringReceiver::~IoUringReceiver() {
+    cancel_requests();
+    // Closing the ring cancels the multishot request before its buffers go away.
+    ring_.reset();
+    if (buf_ring_) munmap(buf_ring_, buf_ring_size_);
+}
+
+bool IoUringReceiver::init(int sockfd, int event_fd) {
+    sockfd_ = sockfd;
+    event_fd_ = event_fd;
+
+    // Every completion owns a buffer, so the CQ never needs more room than the buffer ring.
+    if (!ring_.init(8, BUFFER_COUNT * 2)) {
+        spdlog::warn("io_uring_setup failed: {}", strerror(errno));
+        return false;
+    }
+
+    buf_ring_size_ = BUFFER_COUNT * sizeof(io_uring_buf);
+    void* ptr = mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        spdlog::warn("Buffer ring allocation failed: {}", strerror(errno));
+        return false;
+    }
+    buf_ring_ = static_cast<io_uring_buf_ring*>(ptr);
+
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+    reg.ring_entries = BUFFER_COUNT;
+    reg.bgid = BUFFER_GROUP;
+    if (syscall(__NR_io_uring_register, ring_.fd(), IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        spdlog::warn("IORING_REGISTER_PBUF_RING failed: {}", strerror(errno));
+        return false;
+    }
+
+    for (unsigned bid = 0; bid < BUFFER_COUNT; ++bid) {
+        provide_buffer(static_cast<uint16_t>(bid));
+    }
+    __atomic_store_n(&buf_ring_->tail, buf_tail_, __ATOMIC_RELEASE);
+
+    if (!arm_receive() || !arm_shutdown_poll() || ring_.submit_and_wait(0) < 0) {
+        spdlog::warn("io_uring submission failed: {}", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool IoUringReceiver::arm_receive() {
+    io_uring_sqe* sqe = ring_.get_sqe();
+    if (!sqe) return false;
+
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = sockfd_;
+    sqe->addr = reinterpret_cast<uint64_t>(&recv_msg_);
+    sqe->len = 1;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->user_data = RECV_TAG;
+    return true;
+}
+
+bool IoUringReceiver::arm_shutdown_poll() {
+    // A poll, not a read: the eventfd must stay readable for the other reactors.
+    io_uring_sqe* sqe = ring_.get_sqe();
+    if (!sqe) return false;
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = event_fd_;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = SHUTDOWN_TAG;
+    return true;
+}
+
+// The ring is torn down asynchronously after close(), and an armed request
+// keeps its socket open until then, so the port would stay bound for a
+// while. Cancelling first releases the socket right away.
+void IoUringReceiver::cancel_requests() {
+    if (!ring_.ready()) return;
+    io_uring_sqe* sqe = ring_.get_sqe();
+    if (!sqe) return;
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+    sqe->user_data = CANCEL_TAG;
+    if (ring_.submit_and_wait(1) < 0) return;
+
+    while (io_uring_cqe* cqe = ring_.peek_cqe()) {
+        bool done = cqe->user_data == CANCEL_TAG;
+        ring_.cqe_seen();
+        if (done) break;
+    }
+}
+
+void IoUringReceiver::provide_buffer(uint16_t bid) {
+    // Index the ring as a plain io_uring_buf array: in C++ the header's flexible
+    // array member sits behind an empty struct and does not start at offset 0.
+    io_uring_buf* buf = reinterpret_cast<io_uring_buf*>(buf_ring_) + (buf_tail_ & (BUFFER_COUNT - 1));
+    buf->addr = reinterpret_cast<uint64_t>(&buffers_[bid * BUFFER_SIZE]);
+    buf->len = BUFFER_SIZE;
+    buf->bid = bid;
+    ++buf_tail_;
+}
+
+void IoUringReceiver::recycle_buffers() {
+    if (entries_.empty()) return;
+    for (const auto& entry : entries_) {
+        provide_buffer(entry.bid);
+    }
+    entries_.clear();
+    __atomic_store_n(&buf_ring_->tail, buf_tail_, __ATOMIC_RELEASE);
+}
+
+void IoUringReceiver::take_datagram(const io_uring_cqe* cqe) {
+    uint16_t bid = static_cast<uint16_t>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    const uint8_t* base = &buffers_[bid * BUFFER_SIZE];
+    const auto* out = reinterpret_cast<const io_uring_recvmsg_out*>(base);
+    if (static_cast<size_t>(cqe->res) < sizeof(*out)) {
+        provide_buffer(bid);
+        __atomic_store_n(&buf_ring_->tail, buf_tail_, __ATOMIC_RELEASE);
+        return;
+    }
+
+    // Buffer layout: io_uring_recvmsg_out, msg_namelen bytes of address,
+    // msg_controllen bytes of control data, payload.
+    Entry entry{};
+    entry.bid = bid;
+    const uint8_t* name = base + sizeof(*out);
+    std::memcpy(&entry.addr, name, std::min<size_t>(out->namelen, sizeof(sockaddr_in)));
+
+    msghdr control{};
+    control.msg_control = const_cast<uint8_t*>(name + recv_msg_.msg_namelen);
+    control.msg_controllen = out->controllen;
+    uint32_t drops = 0;
+    if (read_rxq_ovfl(control, drops)) kernel_drops_.store(drops, std::memory_order_relaxed);
+
+    entry.data = name + recv_msg_.msg_namelen + recv_msg_.msg_controllen;
+    entry.length = std::min<size_t>(out->payloadlen, UdpRecvBatch::MAX_DATAGRAM_SIZE);
+    entries_.push_back(entry);
+}
+
+int IoUringReceiver::wait() {
+    recycle_buffers();
+
+    while (entries_.empty() && !shutdown_) {
+        // The multishot request ends on ENOBUFS or errors and has to be re-armed.
+        if (rearm_) {
+            if (!arm_receive()) return -1;
+            rearm_ = false;
+        }
+
+        if (!ring_.peek_cqe() && ring_.submit_and_wait(1) < 0) {
+            spdlog::error("io_uring_enter failed: {}", strerror(errno));
+            return -1;
+        }
+
+        io_uring_cqe* cqe;
+        while (entries_.size() < capacity_ && (cqe = ring_.peek_cqe())) {
+            if (cqe->user_data == SHUTDOWN_TAG) {
+                shutdown_ = true;
+            } else if (cqe->res >= 0 && (cqe->flags & IORING_CQE_F_BUFFER)) {
+                take_datagram(cqe);
+            } else if (cqe->res < 0 && cqe->res != -ENOBUFS) {
+                errno = -cqe->res;
+                spdlog::error("io_uring recvmsg failed: {}", strerror(errno));
+                ring_.cqe_seen();
+                return -1;
+            }
+            if (cqe->user_data == RECV_TAG && !(cqe->flags & IORING_CQE_F_MORE)) {
+                rearm_ = true;
+            }
+            ring_.cqe_seen();
+        }
+    }
+    return static_cast<int>(entries_.size());
+}
+
+IoUringSendBatch::IoUringSendBatch(size_t capacity) : UdpSendBatch(capacity) {
+    if (!ring_.init(static_cast<unsigned>(capacity))) {
+        spdlog::warn("io_uring_setup failed: {}, responses use sendmmsg", strerror(errno));
+    }
+}
+
+int IoUringSendBatch::flush() {
+    if (!ring_.ready()) return UdpSendBatch::flush();
+
+    for (size_t i = 0; i < count_; ++i) {
+        io_uring_sqe* sqe = ring_.get_sqe();
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = sockfd_;
+        sqe->addr = reinterpret_cast<uint64_t>(&msgs_[i].msg_hdr);
+        sqe->len = 1;
+        sqe->user_data = i;
+    }
+
+    // Nothing was submitted if the first enter fails, so sendmmsg can take the whole batch.
+    if (ring_.submit_and_wait(count_) < 0) {
+        spdlog::warn("io_uring_enter failed: {}, falling back to sendmmsg", strerror(errno));
+        ring_.reset();
+        return UdpSendBatch::flush();
+    }
+
+    size_t completed = 0;
+    int delivered = 0;
+    while (completed < count_) {
+        io_uring_cqe* cqe;
+        while ((cqe = ring_.peek_cqe())) {
+            if (cqe->res >= 0) {
+                ++delivered;
+            } else {
+                spdlog::warn("io_uring sendmsg failed: {}", strerror(-cqe->res));
+            }
+            ++completed;
+            ring_.cqe_seen();
+        }
+        if (completed < count_ && ring_.submit_and_wait(1) < 0) {
+            spdlog::error("io_uring_enter failed: {}, dropping {} responses", strerror(errno), count_ - completed);
+            ring_.reset();
+            break;
+        }
+    }
+
+    count_ = 0;
+    return delivered;
+}
@@ -0,0 +1,232 @@
+#include "../include/server/packet_ring.hpp"
+#include "../include/server/socket_filters.hpp"
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace {
+uint16_t load_be16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint32_t add_be16_words(const uint8_t* p, size_t len, uint32_t sum) {
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        sum += load_be16(p + i);
+    }
+    if (len & 1) {
+        sum += static_cast<uint32_t>(p[len - 1]) << 8;
+    }
+    return sum;
+}
+}
+
+bool parse_udp_packet(const uint8_t* packet, size_t len, in_addr_t dst_ip, uint16_t port, PacketView& view) {
+    if (len < sizeof(iphdr)) return false;
+
+    const auto* ip = reinterpret_cast<const iphdr*>(packet);
+    size_t ip_header_len = ip->ihl * 4u;
+    if (ip->version != 4 || ip_header_len < sizeof(iphdr) || ip->protocol != IPPROTO_UDP) return false;
+    if (ntohs(ip->frag_off) & (IP_MF | IP_OFFMASK)) return false;
+
+    size_t ip_total_len = ntohs(ip->tot_len);
+    if (ip_total_len < ip_header_len + sizeof(udphdr) || ip_total_len > len) return false;
+    if (dst_ip != INADDR_ANY && ip->daddr != dst_ip) return false;
+
+    const auto* udp = reinterpret_cast<const udphdr*>(packet + ip_header_len);
+    size_t udp_len = ntohs(udp->len);
+    if (ntohs(udp->dest) != port) return false;
+    if (udp_len < sizeof(udphdr) || udp_len > ip_total_len - ip_header_len) return false;
+
+    view.payload = packet + ip_header_len + sizeof(udphdr);
+    view.length = udp_len - sizeof(udphdr);
+    view.source = {};
+    view.source.sin_family = AF_INET;
+    view.source.sin_addr.s_addr = ip->saddr;
+    view.source.sin_port = udp->source;
+    return true;
+}
+
+bool udp_checksum_valid(const uint8_t* packet, size_t len) {
+    const auto* ip = reinterpret_cast<const iphdr*>(packet);
+    size_t ip_header_len = ip->ihl * 4u;
+    const uint8_t* udp = packet + ip_header_len;
+    size_t udp_len = load_be16(udp + 4);
+    if (ip_header_len + udp_len > len) return false;
+    if (load_be16(udp + 6) == 0) return true;
+
+    // Pseudo header: source and destination address, protocol, UDP length.
+    uint32_t sum = add_be16_words(packet + 12, 8, 0);
+    sum += IPPROTO_UDP + udp_len;
+    sum = add_be16_words(udp, udp_len, sum);
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return sum == 0xFFFF;
+}
+
+PacketRing::~PacketRing() {
+    close();
+}
+
+bool PacketRing::open(const std::string& interface, const std::string& ip, uint16_t port) {
+    if (inet_pton(AF_INET, ip.c_str(), &ip_) <= 0) {
+        spdlog::error("Invalid IP address: {}", ip);
+        return false;
+    }
+    port_ = port;
+
+    unsigned ifindex = 0;
+    if (!interface.empty()) {
+        ifindex = if_nametoindex(interface.c_str());
+        if (ifindex == 0) {
+            spdlog::error("Unknown packet_interface {}: {}", interface, strerror(errno));
+            return false;
+        }
+    }
+
+    // Protocol 0 receives nothing until bind(), so no packet skips the filter.
+    fd_ = socket(AF_PACKET, SOCK_DGRAM, 0);
+    if (fd_ < 0) {
+        spdlog::error("AF_PACKET socket creation failed: {}", strerror(errno));
+        return false;
+    }
+
+    std::vector<sock_filter> program = build_udp_port_program(port);
+    sock_fprog fprog{};
+    fprog.len = static_cast<unsigned short>(program.size());
+    fprog.filter = program.data();
+    if (setsockopt(fd_, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) < 0) {
+        spdlog::error("setsockopt(SO_ATTACH_FILTER) failed: {}", strerror(errno));
+        close();
+        return false;
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(fd_, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        spdlog::error("setsockopt(PACKET_VERSION) failed: {}", strerror(errno));
+        close();
+        return false;
+    }
+
+    tpacket_req3 req{};
+    req.tp_block_size = BLOCK_BYTES;
+    req.tp_block_nr = BLOCK_COUNT;
+    req.tp_frame_size = FRAME_SIZE;
+    req.tp_frame_nr = BLOCK_BYTES / FRAME_SIZE * BLOCK_COUNT;
+    req.tp_retire_blk_tov = BLOCK_TIMEOUT_MS;
+    if (setsockopt(fd_, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+        spdlog::error("setsockopt(PACKET_RX_RING) failed: {}", strerror(errno));
+        close();
+        return false;
+    }
+
+    map_size_ = static_cast<size_t>(BLOCK_BYTES) * BLOCK_COUNT;
+    void* map = mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, 0);
+    if (map == MAP_FAILED) {
+        spdlog::error("Packet ring mmap failed: {}", strerror(errno));
+        close();
+        return false;
+    }
+    map_ = static_cast<uint8_t*>(map);
+
+    sockaddr_ll addr{};
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_IP);
+    addr.sll_ifindex = static_cast<int>(ifindex);
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        spdlog::error("AF_PACKET bind failed: {}", strerror(errno));
+        close();
+        return false;
+    }
+
+    // A packet takes at least 64 bytes of a block (tpacket3_hdr, sockaddr_ll, IP and UDP headers).
+    views_.reserve(BLOCK_BYTES / 64);
+    return true;
+}
+
+void PacketRing::close() {
+    if (map_) munmap(map_, map_size_);
+    if (fd_ != -1) ::close(fd_);
+    map_ = nullptr;
+    fd_ = -1;
+    current_ = 0;
+    holding_ = false;
+    views_.clear();
+}
+
+bool PacketRing::join_fanout(uint16_t& group) {
+    int arg = group | (PACKET_FANOUT_HASH << 16);
+    if (group == 0) {
+        arg |= PACKET_FANOUT_FLAG_UNIQUEID << 16;
+    }
+    if (setsockopt(fd_, SOL_PACKET, PACKET_FANOUT, &arg, sizeof(arg)) < 0) {
+        spdlog::error("setsockopt(PACKET_FANOUT) failed: {}", strerror(errno));
+        return false;
+    }
+
+    if (group == 0) {
+        socklen_t len = sizeof(arg);
+        if (getsockopt(fd_, SOL_PACKET, PACKET_FANOUT, &arg, &len) < 0) {
+            spdlog::error("getsockopt(PACKET_FANOUT) failed: {}", strerror(errno));
+            return false;
+        }
+        group = static_cast<uint16_t>(arg & 0xFFFF);
+    }
+    return true;
+}
+
+bool PacketRing::next_block() {
+    if (holding_) return true;
+
+    auto* block = reinterpret_cast<tpacket_block_desc*>(map_ + static_cast<size_t>(current_) * BLOCK_BYTES);
+    if (!(__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER)) return false;
+    holding_ = true;
+
+    const uint8_t* frame = reinterpret_cast<const uint8_t*>(block) + block->hdr.bh1.offset_to_first_pkt;
+    for (uint32_t i = 0; i < block->hdr.bh1.num_pkts; ++i) {
+        const auto* hdr = reinterpret_cast<const tpacket3_hdr*>(frame);
+        const auto* ll = reinterpret_cast<const sockaddr_ll*>(frame + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+        const uint8_t* packet = frame + hdr->tp_net;
+
+        // Loopback shows every packet twice: once leaving and once arriving.
+        PacketView view;
+        if (ll->sll_pkttype != PACKET_OUTGOING &&
+            parse_udp_packet(packet, hdr->tp_snaplen, ip_, port_, view) &&
+            ((hdr->tp_status & (TP_STATUS_CSUM_VALID | TP_STATUS_CSUMNOTREADY)) ||
+             udp_checksum_valid(packet, hdr->tp_snaplen))) {
+            views_.push_back(view);
+        }
+        frame += hdr->tp_next_offset;
+    }
+    return true;
+}
+
+void PacketRing::release_block() {
+    if (!holding_) return;
+
+    auto* block = reinterpret_cast<tpacket_block_desc*>(map_ + static_cast<size_t>(current_) * BLOCK_BYTES);
+    __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    current_ = (current_ + 1) % BLOCK_COUNT;
+    holding_ = false;
+    views_.clear();
+}
+
+uint64_t PacketRing::dropped() {
+    // The kernel resets the counters on every read.
+    tpacket_stats_v3 stats{};
+    socklen_t len = sizeof(stats);
+    if (fd_ != -1 && getsockopt(fd_, SOL_PACKET, PACKET_STATISTICS, &stats, &len) == 0) {
+        dropped_ += stats.tp_drops;
+    }
+    return dropped_;
+}
@@ -1,20 +1,46 @@
 #include "../include/server/pgw_server.hpp"
 
+namespace {
+// Responses are sent straight from these buffers, nothing is built per packet.
+constexpr char RESPONSE_CREATED[] = "created";
+constexpr char RESPONSE_REJECTED[] = "rejected";
+
+const char* response_text(bool rejected) {
+    return rejected ? RESPONSE_REJECTED : RESPONSE_CREATED;
+}
+
+size_t response_length(bool rejected) {
+    return rejected ? sizeof(RESPONSE_REJECTED) - 1 : sizeof(RESPONSE_CREATED) - 1;
+}
+
+// How long /check_subscriber waits for the worker owning the IMSI.
+constexpr auto SESSION_QUERY_TIMEOUT = std::chrono::seconds(1);
+
+// The blacklist is checked against packed IMSIs; an entry pack_imsi refuses
+// could never match a valid IMSI and is dropped.
+std::unordered_set<ImsiKey> pack_blacklist(const std::vector<std::string>& imsis) {
+    std::unordered_set<ImsiKey> keys;
+    for (const std::string& imsi : imsis) {
+        ImsiKey key = pack_imsi(imsi);
+        if (key != 0) keys.insert(key);
+    }
+    return keys;
+}
+}
+
 PgwServer::PgwServer(const ServerConfig& config)
     : config_(config),
       cdr_writer_(config.cdr_file),
+      cdr_flusher_(cdr_writer_),
+      session_table_(config.session_shards, std::chrono::milliseconds(config.session_tick_ms)),
       running_(true),
       pool_running_(true),
-      blacklist_(config.blacklist.begin(), config.blacklist.end()) {}
+      blacklist_(pack_blacklist(config.blacklist)),
+      rate_limiter_(config) {}
 
 PgwServer::~PgwServer() {
-    pool_running_ = false;
-    queue_cond_.notify_all();
-    for (auto& thread : thread_pool_) {
-        if (thread.joinable()) {
-            thread.join();
-        }
-    }
+    stop_thread_pool();
+    close_reactors();
 }
 
 int PgwServer::setup_socket() {
@@ -29,6 +55,30 @@ int PgwServer::setup_socket() {
         return -1;
     }
 
+    if (config_.reactor_count > 1) {
+        int enable = 1;
+        if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) < 0) {
+            spdlog::error("setsockopt(SO_REUSEPORT) failed: {}", strerror(errno));
+            close(sockfd);
+            return -1;
+        }
+    }
+
+    set_socket_buffer(sockfd, SO_RCVBUF, SO_RCVBUFFORCE, config_.socket_rcvbuf);
+    set_socket_buffer(sockfd, SO_SNDBUF, SO_SNDBUFFORCE, config_.socket_sndbuf);
+
+    // Blocking reads and epoll on this socket poll the NIC queue before they sleep.
+    if (config_.busy_poll_us > 0 &&
+        setsockopt(sockfd, SOL_SOCKET, SO_BUSY_POLL, &config_.busy_poll_us, sizeof(config_.busy_poll_us)) < 0) {
+        spdlog::warn("setsockopt(SO_BUSY_POLL) failed: {}", strerror(errno));
+    }
+
+    // Every received datagram then carries the socket's kernel drop count.
+    int enable_ovfl = 1;
+    if (setsockopt(sockfd, SOL_SOCKET, SO_RXQ_OVFL, &enable_ovfl, sizeof(enable_ovfl)) < 0) {
+        spdlog::warn("setsockopt(SO_RXQ_OVFL) failed, kernel drops are not reported: {}", strerror(errno));
+    }
+
     sockaddr_in server_addr{};
     server_addr.sin_family = AF_INET;
     server_addr.sin_port = htons(config_.udp_port);
@@ -47,181 +97,996 @@ int PgwServer::setup_socket() {
     return sockfd;
 }
 
-int PgwServer::setup_epoll(int sockfd) {
-    int epoll_fd = epoll_create1(0);
-    if (epoll_fd == -1) {
-        spdlog::critical("epoll_create1 failed: {}", strerror(errno));
-        return -1;
+// The kernel caps SO_RCVBUF/SO_SNDBUF at net.core.rmem_max/wmem_max; the
+// *FORCE variants lift the cap when the process has CAP_NET_ADMIN.
+void PgwServer::set_socket_buffer(int sockfd, int option, int force_option, int bytes) {
+    if (bytes <= 0) return;
+
+    const char* name = option == SO_RCVBUF ? "SO_RCVBUF" : "SO_SNDBUF";
+    if (setsockopt(sockfd, SOL_SOCKET, force_option, &bytes, sizeof(bytes)) < 0 &&
+        setsockopt(sockfd, SOL_SOCKET, option, &bytes, sizeof(bytes)) < 0) {
+        spdlog::warn("setsockopt({}) failed: {}", name, strerror(errno));
+        return;
     }
 
-    epoll_event ev{};
-    ev.events = EPOLLIN;
-    ev.data.fd = sockfd;
-    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sockfd, &ev) == -1) {
-        spdlog::critical("epoll_ctl failed: {}", strerror(errno));
-        close(epoll_fd);
-        return -1;
+    // The kernel doubles the value for its own bookkeeping.
+    int actual = 0;
+    socklen_t len = sizeof(actual);
+    if (getsockopt(sockfd, SOL_SOCKET, option, &actual, &len) == 0 && actual / 2 < bytes) {
+        spdlog::warn("{} capped at {} bytes (requested {}), raise net.core.{} to get more",
+                     name, actual / 2, bytes, option == SO_RCVBUF ? "rmem_max" : "wmem_max");
+    }
+}
+
+QueueLimits PgwServer::queue_limits() const {
+    QueueLimits limits;
+    limits.capacity = config_.queue_capacity;
+    parse_overload_policy(config_.queue_policy, limits.policy);
+    limits.codel_target = std::chrono::microseconds(config_.codel_target_us);
+    limits.codel_interval = std::chrono::microseconds(config_.codel_interval_us);
+    return limits;
+}
+
+bool PgwServer::open_reactors(int event_fd) {
+    QueueLimits limits = queue_limits();
+    for (int i = 0; i < config_.reactor_count; ++i) {
+        auto reactor = std::make_unique<Reactor>(limits);
+        reactor->index = i;
+
+        reactor->sockfd = setup_socket();
+        if (reactor->sockfd == -1) {
+            close_reactors();
+            return false;
+        }
+
+        if (config_.socket_filter) {
+            if (attach_imsi_validation(reactor->sockfd)) {
+                stats_.set_socket_filter(true);
+            } else {
+                spdlog::warn("Socket filter unavailable on reactor {}, malformed datagrams reach the workers", i);
+            }
+        }
+
+        reactors_.push_back(std::move(reactor));
+    }
+
+    if (config_.io_backend == "packet_mmap" && !open_packet_rings(event_fd)) {
+        spdlog::warn("Packet ring unavailable, falling back to epoll");
+    }
+    for (auto& reactor : reactors_) {
+        if (!reactor->ingress && !open_ingress(*reactor, event_fd)) {
+            close_reactors();
+            return false;
+        }
+    }
+    // Coroutine mode waits for the sockets in the executors and reads them through the epoll backend.
+    if (config_.dispatch_mode == "coroutine") {
+        for (auto& reactor : reactors_) {
+            reactor->executor = std::make_unique<CoroExecutor>();
+            if (!reactor->executor->open()) {
+                close_reactors();
+                return false;
+            }
+        }
+    }
+
+    // The program belongs to the whole reuseport group, attaching it to one socket is enough.
+    if (config_.reactor_steering == "imsi" && reactors_.size() > 1) {
+        if (attach_imsi_steering(reactors_[0]->sockfd, reactors_.size())) {
+            spdlog::info("IMSI-affinity steering attached to {} reactors", reactors_.size());
+        } else {
+            spdlog::warn("IMSI-affinity steering unavailable, falling back to flow hashing");
+        }
+    }
+    return true;
+}
+
+// Falls back to epoll when io_uring is unavailable; fails only when epoll does.
+bool PgwServer::open_ingress(Reactor& reactor, int event_fd) {
+    if (config_.io_backend == "io_uring") {
+        reactor.ingress = std::make_unique<IoUringBackend>(config_.recv_batch_size);
+        if (reactor.ingress->open(reactor.sockfd, event_fd)) return true;
+        spdlog::warn("io_uring unavailable on reactor {}, falling back to epoll", reactor.index);
+    }
+    reactor.ingress = std::make_unique<EpollBackend>(config_.recv_batch_size, config_.busy_poll_us);
+    return reactor.ingress->open(reactor.sockfd, event_fd);
+}
+
+bool PgwServer::open_packet_rings(int event_fd) {
+    uint16_t fanout_group = 0;
+    for (auto& reactor : reactors_) {
+        auto ring = std::make_unique<PacketRingBackend>(config_.packet_interface, config_.udp_ip, config_.udp_port);
+        if (!ring->open(reactor->sockfd, event_fd) ||
+            (reactors_.size() > 1 && !ring->join_fanout(fanout_group))) {
+            for (auto& opened : reactors_) {
+                opened->ingress.reset();
+            }
+            return false;
+        }
+        reactor->ingress = std::move(ring);
+    }
+
+    // The UDP sockets stay bound for sending; their own copies of the datagrams are dropped.
+    for (auto& reactor : reactors_) {
+        if (!attach_drop_all(reactor->sockfd)) {
+            spdlog::warn("Reactor {} socket keeps queueing datagrams that are read from the ring", reactor->index);
+        }
+    }
+    if (config_.socket_filter) {
+        spdlog::warn("socket_filter does not apply to packet_mmap, the ring parser checks the headers instead");
+    }
+    spdlog::info("Packet rings opened on {} for {} reactor(s)",
+                 config_.packet_interface.empty() ? "all interfaces" : config_.packet_interface, reactors_.size());
+    return true;
+}
+
+void PgwServer::close_reactors() {
+    for (auto& reactor : reactors_) {
+        reactor->executor.reset();
+        reactor->fell_back = false;
+        reactor->fallback.reset();
+        reactor->ingress.reset();
+        if (reactor->sockfd != -1) close(reactor->sockfd);
+        reactor->sockfd = -1;
+    }
+}
+
+// Once a second from the session cleaner, and once more at shutdown: reading
+// the packet ring's drops is a syscall, too costly for every received batch.
+void PgwServer::sample_kernel_counters() {
+    for (auto& reactor : reactors_) {
+        if (IngressBackend* backend = reactor->receiving()) {
+            stats_.set_reactor_kernel_drops(reactor->index, backend->kernel_drops());
+        }
+    }
+
+    uint64_t dropped = 0;
+    for (auto& reactor : reactors_) {
+        // A ring-fed reactor drops everything on its UDP socket by design.
+        IngressBackend* backend = reactor->receiving();
+        if (reactor->sockfd != -1 && (!backend || backend->reads_socket())) dropped += socket_drop_count(reactor->sockfd);
     }
-    return epoll_fd;
+    stats_.set_socket_drops(dropped);
+}
+
+void PgwServer::sample_rate_limiter() {
+    if (!rate_limiter_.enabled()) return;
+
+    uint64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    const TokenBucketTable* by_ip = rate_limiter_.by_ip();
+    const TokenBucketTable* by_imsi = rate_limiter_.by_imsi();
+    stats_.set_rate_limit_buckets(by_ip ? by_ip->active(now_ns) : 0, by_imsi ? by_imsi->active(now_ns) : 0);
 }
 
 void PgwServer::start_session_cleaner() {
     cleaner_thread_ = std::thread([&]() {
+        apply_thread_role("pgw-cleaner", config_.cleaner_cpus);
+        // Sessions are expired every tick, the rest still runs once a second.
+        // The thread wakes at least once a second whatever the tick, so
+        // shutdown never waits longer than that for it.
+        auto tick = std::chrono::milliseconds(config_.session_tick_ms);
+        auto now = std::chrono::steady_clock::now();
+        auto next_sample = now + std::chrono::seconds(1);
+        auto next_sweep = now + tick;
         while (running_) {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-            auto now = std::chrono::steady_clock::now();
-            std::lock_guard<std::mutex> lock(session_mutex_);
-            for (auto it = session_table_.begin(); it != session_table_.end(); ) {
-                if (std::chrono::duration_cast<std::chrono::seconds>(now - it->second).count() > config_.session_timeout_sec) {
-                    cdr_writer_.write(it->first, "timeout");
-                    spdlog::info("Session expired for IMSI {}", it->first);
-                    it = session_table_.erase(it);
-                } else {
-                    ++it;
+            std::this_thread::sleep_until(std::min(next_sample, next_sweep));
+            now = std::chrono::steady_clock::now();
+            if (now >= next_sample) {
+                next_sample = now + std::chrono::seconds(1);
+                sample_kernel_counters();
+                sample_rate_limiter();
+                scale_workers();
+            }
+            if (now < next_sweep) continue;
+            next_sweep = now + tick;
+            // Partitioned sessions are swept by the workers that own them.
+            if (!partitions_.empty()) {
+                for (auto& partition : partitions_) {
+                    partition->expire_due = true;
+                    partition->work_ready.notify(1);
                 }
+                continue;
             }
+            expire_sessions(now);
         }
     });
 }
 
-void PgwServer::start_thread_pool(size_t num_threads) {
-    for (size_t i = 0; i < num_threads; ++i) {
-        thread_pool_.emplace_back(&PgwServer::worker_thread, this);
+// session_timeout_ms, when set, overrides session_timeout_sec.
+std::chrono::milliseconds PgwServer::session_timeout() const {
+    if (config_.session_timeout_ms > 0) return std::chrono::milliseconds(config_.session_timeout_ms);
+    return std::chrono::seconds(config_.session_timeout_sec);
+}
+
+// The table is swept one shard at a time, each only for its due sessions,
+// and the CDRs are written once every shard lock has been released.
+void PgwServer::expire_sessions(std::chrono::steady_clock::time_point now) {
+    std::vector<ImsiKey> expired;
+    session_table_.expire(now, session_timeout(), expired);
+    write_timeouts(expired);
+}
+
+void PgwServer::expire_sessions(FlatSessionMap& sessions, std::chrono::steady_clock::time_point now) {
+    std::vector<ImsiKey> expired;
+    sessions.expire(now, session_timeout(), expired);
+    write_timeouts(expired);
+}
+
+// The IMSIs become digits again only here, for the log and the CDRs.
+void PgwServer::write_timeouts(const std::vector<ImsiKey>& expired) {
+    if (expired.empty()) return;
+
+    std::vector<CdrRecord> records;
+    records.reserve(expired.size());
+    for (ImsiKey key : expired) {
+        std::string imsi = unpack_imsi(key);
+        spdlog::info("Session expired for IMSI {}", imsi);
+        records.push_back({std::move(imsi), "timeout"});
     }
-    spdlog::info("Started thread pool with {} threads", num_threads);
+    cdr_writer_.write(records);
 }
 
-void PgwServer::worker_thread() {
-    while (pool_running_) {
-        ClientTask task;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            queue_cond_.wait(lock, [this] { return !task_queue_.empty() || !pool_running_; });
-            if (!pool_running_ && task_queue_.empty()) {
-                return;
-            }
-            task = std::move(task_queue_.front());
-            task_queue_.pop();
-        }
-        handle_client(task.sockfd, task.client_addr, task.buffer);
+void PgwServer::open_partitions(size_t count) {
+    QueueLimits limits = queue_limits();
+    for (size_t i = 0; i < count; ++i) {
+        auto partition = std::make_unique<SessionPartition>(limits, std::chrono::milliseconds(config_.session_tick_ms));
+        partition->index = i;
+        partitions_.push_back(std::move(partition));
     }
+    stats_.set_partitions(count);
 }
 
-void PgwServer::handle_client(int sockfd, const sockaddr_in& client_addr, const std::vector<uint8_t>& buffer) {
-    std::string imsi = decoder_.decode(buffer);
-    spdlog::info("Received IMSI: {}", imsi);
+PgwServer::SessionPartition& PgwServer::owner_of(uint64_t imsi_hash) {
+    return *partitions_[imsi_hash % partitions_.size()];
+}
 
-    if (imsi.length() != 15 || imsi.find_first_not_of("0123456789") != std::string::npos) {
-        spdlog::warn("Received invalid IMSI '{}', ignoring", imsi);
+// A worker that does not answer in time (stopped, or stalled on a long
+// backlog) is taken as having no session for the IMSI.
+bool PgwServer::session_active(const std::string& imsi) {
+    SessionPartition& partition = owner_of(decoder_.hash(imsi));
+    auto query = std::make_shared<SessionQuery>();
+    query->imsi = pack_imsi(imsi);
+    std::future<bool> active = query->active.get_future();
+    if (!partition.queries.try_push(std::move(query))) {
+        spdlog::warn("Too many session queries pending on worker {}, IMSI {} reported not active",
+                     partition.index, imsi);
+        return false;
+    }
+    partition.work_ready.notify(1);
+    if (active.wait_for(SESSION_QUERY_TIMEOUT) != std::future_status::ready) {
+        spdlog::warn("Worker {} did not answer the session query for IMSI {}", partition.index, imsi);
+        return false;
+    }
+    return active.get();
+}
+
+void PgwServer::start_thread_pool(size_t num_threads, size_t min_threads) {
+    if (!partitions_.empty()) {
+        for (auto& partition : partitions_) {
+            thread_pool_.emplace_back(&PgwServer::partition_worker, this, std::ref(*partition));
+        }
+        spdlog::info("Started {} workers, each owning the sessions of its IMSIs", partitions_.size());
         return;
     }
+    // Every reactor gets at least one worker; the rest are dealt out round-robin.
+    // With min_threads the pool is elastic: every reactor gets queues for its
+    // share of num_threads but starts only its share of min_threads.
+    num_threads = std::max(num_threads, reactors_.size());
+    bool elastic = min_threads > 0;
+    min_threads = elastic ? std::clamp(min_threads, reactors_.size(), num_threads) : num_threads;
+    auto share = [this](size_t total, size_t r) {
+        return total / reactors_.size() + (r < total % reactors_.size() ? 1 : 0);
+    };
+
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    for (size_t r = 0; r < reactors_.size(); ++r) {
+        Reactor& reactor = *reactors_[r];
+        size_t workers = share(num_threads, r);
+        size_t active = share(min_threads, r);
+        reactor.task_queues = std::make_unique<WorkerQueues<ClientTask>>(workers, queue_limits());
+        reactor.task_queues->set_active(active);
+        reactor.workers.resize(workers);
+        if (elastic) {
+            ElasticLimits limits;
+            limits.min_workers = active;
+            limits.max_workers = workers;
+            limits.grow_sojourn = std::chrono::microseconds(config_.elastic_grow_sojourn_us);
+            limits.grow_depth = config_.worker_batch_size;
+            limits.shrink_sojourn = std::chrono::microseconds(config_.elastic_shrink_sojourn_us);
+            limits.shrink_after = config_.elastic_shrink_after_sec;
+            reactor.elastic = std::make_unique<ElasticPolicy>(limits, active);
+        }
+        for (size_t worker = 0; worker < active; ++worker) {
+            start_worker(reactor, worker);
+        }
+        stats_.set_active_workers(r, active);
+    }
+    if (elastic) {
+        spdlog::info("Started elastic thread pool with {} of up to {} threads for {} reactor(s)",
+                     min_threads, num_threads, reactors_.size());
+    } else {
+        spdlog::info("Started thread pool with {} threads for {} reactor(s)", num_threads, reactors_.size());
+    }
+}
+
+// Called with pool_mutex_ held. A slot whose previous worker retired is joined first.
+void PgwServer::start_worker(Reactor& reactor, size_t worker) {
+    Reactor::WorkerSlot& slot = reactor.workers[worker];
+    if (slot.running) return;
+    if (slot.thread.joinable()) slot.thread.join();
+    slot.thread = std::thread(&PgwServer::worker_thread, this, std::ref(reactor), worker);
+    slot.running = true;
+}
+
+// A worker past task_queues->active() leaves once it found every queue empty.
+// Tasks that still reach its queue are stolen by the active workers, so none
+// is lost. Returns false when the pool grew back in the meantime.
+bool PgwServer::retire_worker(Reactor& reactor, size_t worker) {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    if (!pool_running_ || worker < reactor.task_queues->active()) return false;
+    reactor.workers[worker].running = false;
+    return true;
+}
+
+// Once a second from the session cleaner: resizes each reactor's elastic pool.
+void PgwServer::scale_workers() {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    if (!pool_running_) return;
+    for (auto& reactor_ptr : reactors_) {
+        Reactor& reactor = *reactor_ptr;
+        if (!reactor.elastic) continue;
+
+        size_t depth = reactor.task_queues->size();
+        std::chrono::nanoseconds peak_sojourn(reactor.peak_sojourn_ns.exchange(0, std::memory_order_relaxed));
+        size_t active = reactor.task_queues->active();
+        size_t target = reactor.elastic->update(depth, peak_sojourn);
+        if (target == active) continue;
+
+        reactor.task_queues->set_active(target);
+        for (size_t worker = active; worker < target; ++worker) {
+            start_worker(reactor, worker);
+        }
+        stats_.set_active_workers(reactor.index, target);
+        spdlog::info("Reactor {} {} its pool to {} workers ({} tasks queued, up to {} us in queue)",
+                     reactor.index, target > active ? "grows" : "shrinks", target, depth,
+                     std::chrono::duration_cast<std::chrono::microseconds>(peak_sojourn).count());
+    }
+}
 
-    std::string response;
+void PgwServer::stop_thread_pool() {
     {
-        std::lock_guard<std::mutex> lock(session_mutex_);
-        if (blacklist_.count(imsi)) {
-            response = "rejected";
-            spdlog::warn("IMSI {} is blacklisted", imsi);
-        } else if (session_table_.count(imsi)) {
-            response = "created";
-            spdlog::info("IMSI {} already has session", imsi);
+        // No worker starts or retires past this point.
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        pool_running_ = false;
+    }
+    for (auto& reactor : reactors_) {
+        if (reactor->task_queues) reactor->task_queues->notify_all();
+    }
+    for (auto& partition : partitions_) {
+        partition->work_ready.notify_all();
+    }
+    for (auto& reactor : reactors_) {
+        for (auto& slot : reactor->workers) {
+            if (slot.thread.joinable()) slot.thread.join();
+        }
+    }
+    for (auto& thread : thread_pool_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+std::unique_ptr<UdpSendBatch> PgwServer::make_worker_batch(const IngressBackend& backend) const {
+    // end_of_batch holds responses until the queue drains, batch_size every send_batch_size responses.
+    size_t capacity = config_.send_flush == "end_of_batch" ? UdpSendBatch::MAX_CAPACITY
+                                                           : static_cast<size_t>(config_.send_batch_size);
+    return backend.make_send_batch(capacity);
+}
+
+// Spins on the queues for the policy's budget, then parks on work_ready.
+// Another worker may take the item that ended the wait, so the caller just
+// tries the queues again.
+template <typename HasWork>
+void PgwServer::wait_for_work(FutexEvent& work_ready, SpinPolicy& spin, HasWork has_work) {
+    auto start = std::chrono::steady_clock::now();
+    auto now = start;
+    if (spin.budget().count() > 0) {
+        auto deadline = start + spin.budget();
+        bool woken = false;
+        while (pool_running_ && now < deadline) {
+            if (has_work()) {
+                woken = true;
+                break;
+            }
+            cpu_relax();
+            now = std::chrono::steady_clock::now();
+        }
+        stats_.record_worker_spin(std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count(), woken);
+        if (woken || !pool_running_) {
+            spin.record_wait(now - start);
+            return;
+        }
+    }
+
+    uint32_t epoch = work_ready.prepare_wait();
+    if (!has_work() && pool_running_) {
+        auto parked = std::chrono::steady_clock::now();
+        work_ready.wait(epoch);
+        now = std::chrono::steady_clock::now();
+        stats_.record_worker_park(std::chrono::duration_cast<std::chrono::nanoseconds>(now - parked).count());
+    } else {
+        now = std::chrono::steady_clock::now();
+    }
+    work_ready.finish_wait();
+    spin.record_wait(now - start);
+}
+
+void PgwServer::worker_thread(Reactor& reactor, size_t worker) {
+    // Numbered in the order start_thread_pool deals the workers out.
+    size_t index = worker * reactors_.size() + reactor.index;
+    apply_thread_role("pgw-worker-" + std::to_string(index), cpu_of(config_.worker_cpus, index));
+    WorkerQueues<ClientTask>& queues = *reactor.task_queues;
+    WorkerScratch scratch(config_.worker_batch_size, make_worker_batch(*reactor.ingress), queue_limits());
+    SpinPolicy spin(std::chrono::microseconds(config_.spin_budget_us));
+    // A task in any sibling's queue counts too: it can be stolen. A retired worker wakes up to leave.
+    auto has_work = [&] { return !queues.empty() || !reactor.cdr_queue.empty() || worker >= queues.active(); };
+    std::vector<CdrRecord> records;
+    records.reserve(scratch.tasks.size());
+
+    // Every queue of the reactor is drained before the worker exits.
+    while (true) {
+        if (serve_tasks(reactor, worker, scratch) > 0) continue;
+
+        CdrRecord record;
+        if (reactor.cdr_queue.try_pop(record)) {
+            records.clear();
+            records.push_back(std::move(record));
+            while (records.size() < scratch.tasks.size() && reactor.cdr_queue.try_pop(record)) {
+                records.push_back(std::move(record));
+            }
+            cdr_writer_.write(records);
+        } else if (pool_running_) {
+            flush_responses(*scratch.tx_batch);
+            // Every queue is empty here, so a retired worker leaves nothing behind.
+            if (worker >= queues.active() && retire_worker(reactor, worker)) return;
+            wait_for_work(queues.work_ready(worker), spin, has_work);
         } else {
-            response = "created";
-            session_table_[imsi] = std::chrono::steady_clock::now();
-            cdr_writer_.write(imsi, "create");
-            spdlog::info("Session created for IMSI {}", imsi);
+            break;
+        }
+    }
+    flush_responses(*scratch.tx_batch);
+}
+
+// Takes up to worker_batch_size tasks from the worker's own queue, or stolen
+// from its siblings', resolves them together and queues their answers.
+// Returns how many it took.
+size_t PgwServer::serve_tasks(Reactor& reactor, size_t worker, WorkerScratch& scratch) {
+    WorkerQueues<ClientTask>& queues = *reactor.task_queues;
+    std::vector<ClientTask>& tasks = scratch.tasks;
+    RequestBatch& batch = scratch.batch;
+    QueueConsumer& consumer = scratch.consumer;
+    size_t count = 0;
+    consumer.dropped = 0;
+    auto now = std::chrono::steady_clock::now();
+    bool stolen = false;
+    std::chrono::nanoseconds peak_sojourn{0};
+    while (count < tasks.size() && queues.pop(worker, tasks[count], now, consumer, stolen)) {
+        if (stolen) stats_.record_worker_steal();
+        peak_sojourn = std::max(peak_sojourn, consumer.last_sojourn);
+        ++count;
+    }
+    if (consumer.dropped > 0) stats_.record_app_drop(ServerStats::DropReason::QueueCoDel, consumer.dropped);
+    if (count == 0) return 0;
+
+    stats_.set_queue_sojourn(reactor.index, consumer.last_sojourn.count());
+    if (reactor.elastic) {
+        int64_t seen = reactor.peak_sojourn_ns.load(std::memory_order_relaxed);
+        while (peak_sojourn.count() > seen &&
+               !reactor.peak_sojourn_ns.compare_exchange_weak(seen, peak_sojourn.count(),
+                                                             std::memory_order_relaxed)) {
         }
     }
-    sendto(sockfd, response.c_str(), response.size(), 0,
+    stats_.set_queue_depth(reactor.index, queues.size());
+    for (size_t i = 0; i < count; ++i) {
+        batch.requests[i].valid = decode_imsi(tasks[i].data(), tasks[i].length, batch.requests[i].imsi);
+    }
+    resolve_requests(batch, count, nullptr);
+    for (size_t i = 0; i < count; ++i) {
+        queue_response(*scratch.tx_batch, tasks[i].sockfd, tasks[i].client_addr, batch.requests[i].code);
+    }
+    return count;
+}
+
+// The only thread that touches partition.sessions: it answers the session
+// queries and runs the expiry sweep between tasks.
+void PgwServer::partition_worker(SessionPartition& partition) {
+    apply_thread_role("pgw-worker-" + std::to_string(partition.index), cpu_of(config_.worker_cpus, partition.index));
+    std::unique_ptr<UdpSendBatch> tx_batch = make_worker_batch(*reactors_[0]->ingress);
+    SpinPolicy spin(std::chrono::microseconds(config_.spin_budget_us));
+    QueueConsumer consumer(queue_limits());
+    auto has_work = [&] {
+        return !partition.task_queue.empty() || !partition.queries.empty() ||
+               partition.expire_due.load(std::memory_order_relaxed);
+    };
+
+    // Tasks and queries are drained before the worker exits.
+    while (true) {
+        if (partition.expire_due.exchange(false)) {
+            expire_sessions(partition.sessions, std::chrono::steady_clock::now());
+        }
+        std::shared_ptr<SessionQuery> query;
+        while (partition.queries.try_pop(query)) {
+            query->active.set_value(partition.sessions.contains(query->imsi));
+        }
+
+        ClientTask task;
+        consumer.dropped = 0;
+        bool has_task = partition.task_queue.pop(task, std::chrono::steady_clock::now(), consumer);
+        if (consumer.dropped > 0) stats_.record_app_drop(ServerStats::DropReason::QueueCoDel, consumer.dropped);
+        // Every reactor feeds the partition, so only its worker sees the whole backlog.
+        stats_.set_partition_depth(partition.index, partition.task_queue.size());
+
+        if (has_task) {
+            queue_response(*tx_batch, task.sockfd, task.client_addr, process_owned(partition, task.data(), task.length));
+        } else if (pool_running_) {
+            flush_responses(*tx_batch);
+            wait_for_work(partition.work_ready, spin, has_work);
+        } else {
+            break;
+        }
+    }
+    flush_responses(*tx_batch);
+}
+
+void PgwServer::queue_response(UdpSendBatch& batch, int sockfd, const sockaddr_in& client_addr, ResponseCode code) {
+    if (code == ResponseCode::None) return;
+
+    bool rejected = code == ResponseCode::Rejected;
+    if (!batch.add(sockfd, client_addr, response_text(rejected), response_length(rejected))) {
+        flush_responses(batch);
+        batch.add(sockfd, client_addr, response_text(rejected), response_length(rejected));
+    }
+    spdlog::debug("Queued response: {}", response_text(rejected));
+
+    if (batch.full()) {
+        flush_responses(batch);
+    }
+}
+
+void PgwServer::flush_responses(UdpSendBatch& batch) {
+    if (batch.empty()) return;
+    stats_.record_tx_batch(batch.flush());
+}
+
+void PgwServer::handle_client(int sockfd, const sockaddr_in& client_addr, const std::vector<uint8_t>& buffer) {
+    ResponseCode code = process_request(buffer);
+    if (code == ResponseCode::None) return;
+
+    bool rejected = code == ResponseCode::Rejected;
+    sendto(sockfd, response_text(rejected), response_length(rejected), 0,
            (sockaddr*)&client_addr, sizeof(client_addr));
-    spdlog::debug("Sent response: {}", response);
+    spdlog::debug("Sent response: {}", response_text(rejected));
 }
 
-void PgwServer::run() {
-    int sockfd = setup_socket();
-    if (sockfd == -1) return;
+PgwServer::ResponseCode PgwServer::process_request(const std::vector<uint8_t>& buffer) {
+    return process_request(buffer.data(), buffer.size());
+}
 
-    int epoll_fd = setup_epoll(sockfd);
-    if (epoll_fd == -1) {
-        close(sockfd);
-        return;
+PgwServer::ResponseCode PgwServer::process_request(const uint8_t* data, size_t len) {
+    RequestBatch batch;
+    batch.requests.resize(1);
+    batch.requests[0].valid = decode_imsi(data, len, batch.requests[0].imsi);
+    resolve_requests(batch, 1, nullptr);
+    return batch.requests[0].code;
+}
+
+void PgwServer::resolve_requests(RequestBatch& batch, size_t count, Reactor* cdr_reactor) {
+    open_sessions(batch, count);
+    write_cdrs(cdr_reactor, batch.cdrs);
+}
+
+// The blacklist is never modified, so only opening a session takes a lock,
+// that of the IMSI's shard. The CDRs are left in batch.cdrs for the caller to
+// write.
+void PgwServer::open_sessions(RequestBatch& batch, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        SessionRequest& request = batch.requests[i];
+        if (!request.valid) {
+            request.code = ResponseCode::None;
+        } else if (blacklist_.count(request.imsi)) {
+            spdlog::warn("IMSI {} is blacklisted", unpack_imsi(request.imsi));
+            request.code = ResponseCode::Rejected;
+        } else {
+            request.code = ResponseCode::Created;
+        }
     }
 
-    int event_fd = eventfd(0, EFD_NONBLOCK);
-    if (event_fd == -1) {
-        spdlog::critical("eventfd creation failed: {}", strerror(errno));
-        close(sockfd);
-        close(epoll_fd);
-        return;
+    batch.cdrs.clear();
+    for (size_t i = 0; i < count; ++i) {
+        const SessionRequest& request = batch.requests[i];
+        if (request.code == ResponseCode::Created && open_session(request.imsi)) {
+            batch.cdrs.push_back({unpack_imsi(request.imsi), "create"});
+        }
     }
+}
 
-    epoll_event ev_event{};
-    ev_event.events = EPOLLIN;
-    ev_event.data.fd = event_fd;
-    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, event_fd, &ev_event);
+// Runs on the worker owning the partition: no lock, the blacklist never
+// changes after construction.
+PgwServer::ResponseCode PgwServer::process_owned(SessionPartition& partition, const uint8_t* data, size_t len) {
+    ImsiKey imsi = 0;
+    if (!decode_imsi(data, len, imsi)) return ResponseCode::None;
 
-    HttpServer http(config_, running_, session_table_, session_mutex_, event_fd);
-    http.run();
+    if (blacklist_.count(imsi)) {
+        spdlog::warn("IMSI {} is blacklisted", unpack_imsi(imsi));
+        return ResponseCode::Rejected;
+    }
+    if (open_session(partition.sessions, imsi)) cdr_writer_.write(unpack_imsi(imsi), "create");
+    return ResponseCode::Created;
+}
 
-    start_session_cleaner();
-    start_thread_pool(std::thread::hardware_concurrency());
+// False, counted as an invalid datagram, unless the payload holds a 15-digit
+// IMSI. The digits are packed straight from the BCD; a string is built only
+// for the log.
+bool PgwServer::decode_imsi(const uint8_t* data, size_t len, ImsiKey& imsi) {
+    imsi = decoder_.pack(data, len);
+    if (imsi_digits(imsi) != MAX_IMSI_DIGITS) {
+        std::string digits = decoder_.decode(data, len);
+        spdlog::info("Received IMSI: {}", digits);
+        spdlog::warn("Received invalid IMSI '{}', ignoring", digits);
+        stats_.record_app_drop(ServerStats::DropReason::Invalid);
+        return false;
+    }
+    spdlog::info("Received IMSI: {}", unpack_imsi(imsi));
+    return true;
+}
 
-    spdlog::info("UDP server started with epoll on {}:{}", config_.udp_ip, config_.udp_port);
+// Returns false when the IMSI already has a session, which is left as it is.
+bool PgwServer::open_session(ImsiKey imsi) {
+    return session_opened(imsi, session_table_.open(imsi, std::chrono::steady_clock::now()));
+}
 
-    const int MAX_EVENTS = 1000;
-    epoll_event events[MAX_EVENTS];
-    bool should_exit = false;
+bool PgwServer::open_session(FlatSessionMap& sessions, ImsiKey imsi) {
+    return session_opened(imsi, sessions.open(imsi, std::chrono::steady_clock::now()));
+}
 
-    while (!should_exit) {
-        int nfds = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
-        if (nfds == -1) {
-            if (errno == EINTR) continue;
-            spdlog::error("epoll_wait failed: {}", strerror(errno));
-            break;
+bool PgwServer::session_opened(ImsiKey imsi, bool opened) {
+    if (opened) {
+        spdlog::info("Session created for IMSI {}", unpack_imsi(imsi));
+    } else {
+        spdlog::info("IMSI {} already has session", unpack_imsi(imsi));
+    }
+    return opened;
+}
+
+// Hands the records to the reactor's workers through its cdr_queue, so a
+// reactor answering inline does not block on the file. Records are never
+// dropped: those the full ring refuses, or all of them without a reactor, are
+// written right away in one append.
+void PgwServer::write_cdrs(Reactor* reactor, std::vector<CdrRecord>& records) {
+    if (records.empty()) return;
+
+    if (reactor) {
+        size_t handed = 0;
+        size_t kept = 0;
+        for (size_t i = 0; i < records.size(); ++i) {
+            if (reactor->cdr_queue.try_push(std::move(records[i]))) {
+                ++handed;
+            } else if (kept++ != i) {
+                records[kept - 1] = std::move(records[i]);
+            }
         }
+        records.resize(kept);
+        // One worker drains the whole ring.
+        if (handed > 0) reactor->task_queues->notify_one();
+    }
+    cdr_writer_.write(records);
+}
 
-        for (int i = 0; i < nfds; ++i) {
-            if (events[i].data.fd == event_fd) {
-                uint64_t dummy;
-                ssize_t bytes_read = read(event_fd, &dummy, sizeof(dummy));
-                if (bytes_read != sizeof(dummy)) {
-                    spdlog::error("Failed to read from event_fd (expected {}, got {})", sizeof(dummy), bytes_read);
-                }
-                spdlog::info("Shutdown event received from HTTP thread");
-                should_exit = true;
+PgwServer::ReactorSink::ReactorSink(PgwServer& server, Reactor& reactor)
+    : server_(server), reactor_(reactor) {
+    // imsi_affinity copies even zero-copy payloads: the sessions live with the workers.
+    bool owned_sessions = server.config_.dispatch_mode == "imsi_affinity";
+    if (server.config_.dispatch_mode == "run_to_completion" || reactor.executor ||
+        (reactor.ingress->zero_copy() && !owned_sessions)) {
+        tx_batch_ = reactor.ingress->make_send_batch(UdpSendBatch::MAX_CAPACITY);
+    }
+}
+
+void PgwServer::ReactorSink::deliver(const Datagram* datagrams, size_t count, size_t capacity) {
+    server_.stats_.record_rx_batch(count, capacity);
+    server_.stats_.record_reactor_rx(reactor_.index, count);
+    if (server_.rate_limiter_.enabled()) {
+        count = admit(datagrams, count);
+        if (count == 0) return;
+        datagrams = admitted_.data();
+    }
+    if (reactor_.executor) {
+        server_.spawn_requests(reactor_, *tx_batch_, datagrams, count);
+    } else if (tx_batch_) {
+        server_.process_inline(reactor_, *tx_batch_, requests_, datagrams, count);
+    } else if (!server_.partitions_.empty()) {
+        server_.enqueue_by_imsi(reactor_, datagrams, count);
+    } else {
+        server_.enqueue_batch(reactor_, datagrams, count);
+    }
+}
+
+// Copies the datagrams within the rate limits into admitted_; one clock read per batch.
+size_t PgwServer::ReactorSink::admit(const Datagram* datagrams, size_t count) {
+    uint64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    admitted_.clear();
+    for (size_t i = 0; i < count; ++i) {
+        switch (server_.rate_limiter_.check(datagrams[i], now_ns)) {
+            case RateLimiter::Verdict::Pass:
+                admitted_.push_back(datagrams[i]);
                 break;
-            }
+            case RateLimiter::Verdict::SourceIp:
+                server_.stats_.record_app_drop(ServerStats::DropReason::RateLimitedIp);
+                break;
+            case RateLimiter::Verdict::Imsi:
+                server_.stats_.record_app_drop(ServerStats::DropReason::RateLimitedImsi);
+                break;
+        }
+    }
+    return admitted_.size();
+}
+
+// Deals the batch out to the workers' queues in turn and wakes each worker
+// that got tasks once. Datagrams no queue takes, or that push out the oldest
+// task of a full one, count as queue_full.
+void PgwServer::enqueue_batch(Reactor& reactor, const Datagram* datagrams, size_t count) {
+    WorkerQueues<ClientTask>& queues = *reactor.task_queues;
+    size_t dropped = 0;
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        const Datagram& datagram = datagrams[i];
+        auto result = queues.push(ClientTask(reactor.sockfd, datagram.source, datagram.data, datagram.length), now);
+        if (result != BoundedQueue<ClientTask>::PushResult::Queued) ++dropped;
+    }
+    stats_.set_queue_depth(reactor.index, queues.size());
+    if (dropped > 0) stats_.record_app_drop(ServerStats::DropReason::QueueFull, dropped);
+    queues.notify_dealt();
+}
+
+// Every datagram goes to the worker owning its IMSI, so the requests of one
+// subscriber are processed in order by one thread. Malformed ones land on
+// whichever worker their bytes hash to, which drops them.
+void PgwServer::enqueue_by_imsi(Reactor& reactor, const Datagram* datagrams, size_t count) {
+    size_t dropped = 0;
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        const Datagram& datagram = datagrams[i];
+        SessionPartition& partition = owner_of(decoder_.hash(datagram.data, datagram.length));
+        if (partition.task_queue.rejects_push()) {
+            ++dropped;
+            continue;
+        }
+        auto result = partition.task_queue.push(
+            ClientTask(reactor.sockfd, datagram.source, datagram.data, datagram.length), now);
+        if (result == BoundedQueue<ClientTask>::PushResult::Rejected) {
+            ++dropped;
+            continue;
+        }
+        if (result == BoundedQueue<ClientTask>::PushResult::DroppedOldest) ++dropped;
+        partition.work_ready.notify(1);
+    }
+    if (dropped > 0) stats_.record_app_drop(ServerStats::DropReason::QueueFull, dropped);
+}
 
-            if (events[i].data.fd == sockfd) {
-                std::vector<uint8_t> buffer(16);
-                sockaddr_in client_addr{};
-                socklen_t len = sizeof(client_addr);
+// Run-to-completion: decode, session lookup and answer on the reactor thread,
+// only the CDR writes go to the workers. Zero-copy backends always take this
+// path since their payloads are valid only until the buffer goes back to the kernel.
+void PgwServer::process_inline(Reactor& reactor, UdpSendBatch& tx_batch, RequestBatch& batch,
+                               const Datagram* datagrams, size_t count) {
+    if (batch.requests.size() < count) batch.requests.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        SessionRequest& request = batch.requests[i];
+        request.valid = decode_imsi(datagrams[i].data, datagrams[i].length, request.imsi);
+    }
+    resolve_requests(batch, count, &reactor);
+    for (size_t i = 0; i < count; ++i) {
+        queue_response(tx_batch, reactor.sockfd, datagrams[i].source, batch.requests[i].code);
+    }
+    flush_responses(tx_batch);
+}
 
-                ssize_t n = recvfrom(sockfd, buffer.data(), buffer.size(), 0,
-                                     (sockaddr*)&client_addr, &len);
-                if (n <= 0) continue;
+// Coroutine mode: the batch is copied, since its coroutine may outlive the
+// receive buffer, and processed on the reactor thread right away. Up to
+// queue_capacity datagrams per reactor may wait for their CDRs, the rest
+// count as queue_full.
+void PgwServer::spawn_requests(Reactor& reactor, UdpSendBatch& tx_batch, const Datagram* datagrams, size_t count) {
+    size_t room = config_.queue_capacity - std::min<size_t>(reactor.in_flight, config_.queue_capacity);
+    if (count > room) {
+        stats_.record_app_drop(ServerStats::DropReason::QueueFull, count - room);
+        count = room;
+    }
+    if (count == 0) return;
 
-                buffer.resize(n);
-                {
-                    std::lock_guard<std::mutex> lock(queue_mutex_);
-                    task_queue_.push({sockfd, client_addr, buffer});
-                }
-                queue_cond_.notify_one();
-            }
+    std::vector<ClientTask> tasks;
+    tasks.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        tasks.emplace_back(reactor.sockfd, datagrams[i].source, datagrams[i].data, datagrams[i].length);
+    }
+    reactor.in_flight += count;
+    reactor.executor->spawn(serve_requests(reactor, tx_batch, std::move(tasks)));
+    stats_.set_queue_depth(reactor.index, reactor.in_flight);
+}
+
+// One received batch from decoding to the answers. The coroutine suspends
+// only while the CDR flusher appends the records of the sessions it opened,
+// so, as in worker_pool mode, a client is answered once its CDR is written,
+// but the reactor thread goes on receiving meanwhile.
+CoroTask PgwServer::serve_requests(Reactor& reactor, UdpSendBatch& tx_batch, std::vector<ClientTask> tasks) {
+    RequestBatch batch;
+    batch.requests.resize(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        batch.requests[i].valid = decode_imsi(tasks[i].data(), tasks[i].length, batch.requests[i].imsi);
+    }
+    open_sessions(batch, tasks.size());
+    co_await cdr_flusher_.flush(*reactor.executor, batch.cdrs);
+
+    // Nothing suspends between queueing and flushing, so the reactor's coroutines share one batch.
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        queue_response(tx_batch, tasks[i].sockfd, tasks[i].client_addr, batch.requests[i].code);
+    }
+    flush_responses(tx_batch);
+    reactor.in_flight -= tasks.size();
+}
+
+CoroTask PgwServer::serve_socket(Reactor& reactor, ReactorSink& sink) {
+    auto& backend = static_cast<EpollBackend&>(*reactor.ingress);
+    while (co_await reactor.executor->readable(reactor.sockfd)) {
+        if (!backend.drain(sink)) {
+            reactor.executor->stop();
+            break;
         }
     }
+}
 
-    pool_running_ = false;
-    queue_cond_.notify_all();
-    for (auto& thread : thread_pool_) {
-        if (thread.joinable()) {
-            thread.join();
+// Returns like IngressBackend::serve once the executor has answered every
+// datagram it took in.
+bool PgwServer::serve_coroutines(Reactor& reactor, ReactorSink& sink, int event_fd) {
+    reactor.executor->spawn(serve_socket(reactor, sink));
+    return reactor.executor->run(event_fd);
+}
+
+void PgwServer::reactor_loop(Reactor& reactor, int event_fd) {
+    apply_thread_role("pgw-reactor-" + std::to_string(reactor.index), cpu_of(config_.reactor_cpus, reactor.index));
+    ReactorSink sink(*this, reactor);
+    bool shutdown = reactor.executor ? serve_coroutines(reactor, sink, event_fd) : reactor.ingress->serve(sink);
+
+    // Datagrams left in the socket are not lost: epoll picks them up. The
+    // failed backend stays in `ingress`, workers still make their send batches with it.
+    if (!shutdown && !reactor.executor && reactor.ingress->reads_socket() &&
+        !dynamic_cast<EpollBackend*>(reactor.ingress.get())) {
+        spdlog::warn("{} receive failed on reactor {}, falling back to epoll", reactor.ingress->name(), reactor.index);
+        reactor.fallback = std::make_unique<EpollBackend>(config_.recv_batch_size, config_.busy_poll_us);
+        if (reactor.fallback->open(reactor.sockfd, event_fd)) {
+            reactor.fell_back.store(true, std::memory_order_release);
+            shutdown = reactor.fallback->serve(sink);
         }
     }
+
+    if (shutdown) {
+        spdlog::info("Shutdown event received from HTTP thread (reactor {})", reactor.index);
+        return;
+    }
+    // Wake the other reactors so the whole server shuts down together.
+    uint64_t signal = 1;
+    if (write(event_fd, &signal, sizeof(signal)) != sizeof(signal)) {
+        spdlog::error("Failed to write to event_fd");
+    }
+}
+
+void PgwServer::run() {
+    int event_fd = eventfd(0, EFD_NONBLOCK);
+    if (event_fd == -1) {
+        spdlog::critical("eventfd creation failed: {}", strerror(errno));
+        return;
+    }
+
+    if (!open_reactors(event_fd)) {
+        close(event_fd);
+        return;
+    }
+
+    // Inline reactors leave only the CDR writes to the pool, one worker per reactor is enough.
+    bool run_to_completion = config_.dispatch_mode == "run_to_completion";
+    // Coroutines answer on the reactor threads and hand the CDRs to the flusher: no pool at all.
+    bool coroutines = config_.dispatch_mode == "coroutine";
+    // Without worker_count, one worker per CPU the cgroup quota and cpuset actually allow.
+    size_t worker_count = config_.elastic_workers && config_.elastic_max_workers > 0
+                              ? config_.elastic_max_workers : config_.worker_count;
+    if (worker_count == 0 && !run_to_completion && !coroutines) {
+        CpuBudget budget = detect_cpu_budget();
+        worker_count = budget.cpus();
+        spdlog::info("Sized the worker pool to {} from the CPU budget ({})", worker_count, budget.describe());
+    }
+
+    // One partition per worker, each owned by it.
+    PartitionedSessions partitioned(*this);
+    if (config_.dispatch_mode == "imsi_affinity") {
+        open_partitions(worker_count);
+    }
+
+    HttpServer http(config_, running_,
+                    partitions_.empty() ? static_cast<SessionStore&>(session_table_) : partitioned,
+                    event_fd, &stats_);
+    http.run();
+
+    start_session_cleaner();
+    if (coroutines) {
+        cdr_flusher_.start("pgw-cdr", config_.cleaner_cpus);
+    } else if (run_to_completion) {
+        start_thread_pool(reactors_.size());
+    } else if (config_.elastic_workers) {
+        // worker_count (or the CPU budget) is the ceiling the elastic pool grows to.
+        start_thread_pool(worker_count, std::min<size_t>(config_.elastic_min_workers, worker_count));
+    } else {
+        start_thread_pool(worker_count);
+    }
+
+    spdlog::info("UDP server started with {} ({}) on {}:{} ({} reactor(s), recv batch size {}, send flush {}, send batch size {}, "
+                 "spin budget {} us, busy poll {} us)",
+                 config_.io_backend, config_.dispatch_mode, config_.udp_ip, config_.udp_port, reactors_.size(),
+                 config_.recv_batch_size, config_.send_flush, config_.send_batch_size,
+                 config_.spin_budget_us, config_.busy_poll_us);
+    if (coroutines) {
+        spdlog::info("Up to {} datagrams per reactor may wait for their CDRs", config_.queue_capacity);
+    } else if (!run_to_completion) {
+        spdlog::info("Task queues hold up to {} datagrams per {}, overload policy {}",
+                     config_.queue_capacity, partitions_.empty() ? "reactor" : "worker", config_.queue_policy);
+    }
+    spdlog::info("Thread CPUs: reactors {}, workers {}, session cleaner {}, HTTP {}",
+                 format_cpu_list(config_.reactor_cpus), format_cpu_list(config_.worker_cpus),
+                 format_cpu_list(config_.cleaner_cpus), format_cpu_list(config_.http_cpus));
+    if (rate_limiter_.enabled()) {
+        spdlog::info("Rate limits: {} datagrams/s per source IP (burst {}), {} datagrams/s per IMSI (burst {}); 0 = off",
+                     config_.rate_limit_ip_rate, config_.rate_limit_ip_burst,
+                     config_.rate_limit_imsi_rate, config_.rate_limit_imsi_burst);
+    }
+
+    // Every reactor gets a thread of its own, so the calling thread keeps its name and CPUs.
+    std::vector<std::thread> reactor_threads;
+    for (auto& reactor : reactors_) {
+        reactor_threads.emplace_back(&PgwServer::reactor_loop, this, std::ref(*reactor), event_fd);
+    }
+    for (auto& thread : reactor_threads) {
+        thread.join();
+    }
+
+    running_ = false;
+    stop_thread_pool();
+    // The executors have answered everything, so no coroutine waits for the flusher any more.
+    cdr_flusher_.stop();
     cleaner_thread_.join();
     http.stop();
-    close(epoll_fd);
-    close(sockfd);
+    sample_kernel_counters();
+    close_reactors();
     close(event_fd);
+    if (stats_.tx_batches() > 0) {
+        spdlog::info("Sent {} responses in {} batches (average {:.1f} per batch)",
+                     stats_.tx_datagrams(), stats_.tx_batches(),
+                     static_cast<double>(stats_.tx_datagrams()) / stats_.tx_batches());
+    }
+    // SK_MEMINFO_DROPS does not tell filter rejections from overflows.
+    if (stats_.socket_drops() > 0) {
+        spdlog::info("Kernel dropped {} datagrams on the sockets ({})", stats_.socket_drops(),
+                     config_.socket_filter ? "socket filter rejections and receive-buffer overflows"
+                                           : "receive-buffer overflows");
+    }
+    if (stats_.kernel_rx_dropped() > 0 || stats_.app_dropped() > 0) {
+        spdlog::info("Dropped {} datagrams in the kernel before they were read{} and {} in the server",
+                     stats_.kernel_rx_dropped(),
+                     stats_.socket_filter() ? " (socket filter rejections included)" : "", stats_.app_dropped());
+    }
+    if (stats_.rx_batches() > 0) {
+        spdlog::info("Received {} datagrams in {} batches (average {:.1f} per batch)",
+                     stats_.rx_datagrams(), stats_.rx_batches(),
+                     static_cast<double>(stats_.rx_datagrams()) / stats_.rx_batches());
+    }
     spdlog::info("UDP server stopped");
-}
\ No newline at end of file
+}
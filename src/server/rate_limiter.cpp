@@ -0,0 +1,129 @@
+#include "../include/server/rate_limiter.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// splitmix64 finalizer: spreads neighbouring addresses over the table.
+uint64_t mix(uint64_t key) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key;
+}
+
+size_t round_up_to_power_of_two(size_t value) {
+    size_t result = TokenBucketTable::PROBE_WINDOW;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+// Another reactor may claim the same slot concurrently; after this many lost
+// races the datagram shares whatever bucket it last saw.
+constexpr int CLAIM_ATTEMPTS = 4;
+}
+
+TokenBucketTable::TokenBucketTable(size_t capacity, uint32_t rate, uint32_t burst,
+                                   std::chrono::nanoseconds idle_timeout)
+    : mask_(round_up_to_power_of_two(capacity) - 1),
+      interval_ns_(1000000000ULL / std::max<uint32_t>(rate, 1)),
+      tolerance_ns_(interval_ns_ * (std::max<uint32_t>(burst, 1) - 1)),
+      idle_ns_(static_cast<uint64_t>(idle_timeout.count())) {
+    slots_ = std::make_unique<Slot[]>(mask_ + 1);
+}
+
+bool TokenBucketTable::idle(uint64_t tat, uint64_t now_ns) const {
+    return tat + idle_ns_ < now_ns;
+}
+
+bool TokenBucketTable::consume(uint64_t key, uint64_t now_ns) {
+    size_t start = mix(key) & mask_;
+    Slot* slot = nullptr;
+    for (size_t i = 0; i < PROBE_WINDOW; ++i) {
+        Slot& candidate = slots_[(start + i) & mask_];
+        if (candidate.key.load(std::memory_order_acquire) == key) {
+            slot = &candidate;
+            break;
+        }
+    }
+    if (!slot) slot = &claim(key, start);
+
+    uint64_t tat = slot->tat.load(std::memory_order_relaxed);
+    while (true) {
+        uint64_t base = std::max(tat, now_ns);
+        if (base - now_ns > tolerance_ns_) return false;
+        if (slot->tat.compare_exchange_weak(tat, base + interval_ns_, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+// Takes an empty slot of the window, otherwise the one whose bucket has been
+// full the longest: idle entries age out without a sweep.
+TokenBucketTable::Slot& TokenBucketTable::claim(uint64_t key, size_t start) {
+    Slot* victim = nullptr;
+    for (int attempt = 0; attempt < CLAIM_ATTEMPTS; ++attempt) {
+        victim = nullptr;
+        uint64_t victim_key = 0;
+        uint64_t oldest = UINT64_MAX;
+        for (size_t i = 0; i < PROBE_WINDOW; ++i) {
+            Slot& candidate = slots_[(start + i) & mask_];
+            uint64_t candidate_key = candidate.key.load(std::memory_order_acquire);
+            if (candidate_key == key) return candidate;
+            if (candidate_key == 0) {
+                victim = &candidate;
+                victim_key = 0;
+                break;
+            }
+            uint64_t tat = candidate.tat.load(std::memory_order_relaxed);
+            if (tat < oldest) {
+                oldest = tat;
+                victim = &candidate;
+                victim_key = candidate_key;
+            }
+        }
+        if (victim->key.compare_exchange_strong(victim_key, key, std::memory_order_acq_rel)) {
+            victim->tat.store(0, std::memory_order_relaxed);
+            return *victim;
+        }
+    }
+    return *victim;
+}
+
+size_t TokenBucketTable::active(uint64_t now_ns) const {
+    size_t count = 0;
+    for (size_t i = 0; i <= mask_; ++i) {
+        if (slots_[i].key.load(std::memory_order_relaxed) != 0 &&
+            !idle(slots_[i].tat.load(std::memory_order_relaxed), now_ns)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+RateLimiter::RateLimiter(const ServerConfig& config) {
+    auto idle = std::chrono::seconds(config.rate_limit_idle_sec);
+    if (config.rate_limit_ip_rate > 0) {
+        by_ip_ = std::make_unique<TokenBucketTable>(config.rate_limit_table_size, config.rate_limit_ip_rate,
+                                                    config.rate_limit_ip_burst, idle);
+    }
+    if (config.rate_limit_imsi_rate > 0) {
+        by_imsi_ = std::make_unique<TokenBucketTable>(config.rate_limit_table_size, config.rate_limit_imsi_rate,
+                                                      config.rate_limit_imsi_burst, idle);
+    }
+}
+
+RateLimiter::Verdict RateLimiter::check(const Datagram& datagram, uint64_t now_ns) {
+    // The high bit keeps the key non-zero for 0.0.0.0.
+    if (by_ip_ && !by_ip_->consume((1ULL << 32) | datagram.source.sin_addr.s_addr, now_ns)) {
+        return Verdict::SourceIp;
+    }
+
+    if (by_imsi_ && datagram.length == sizeof(uint64_t)) {
+        uint64_t key = 0;
+        std::memcpy(&key, datagram.data, sizeof(key));
+        if (key != 0 && !by_imsi_->consume(key, now_ns)) return Verdict::Imsi;
+    }
+    return Verdict::Pass;
+}
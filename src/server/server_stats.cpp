@@ -0,0 +1,143 @@
+#include "../include/server/server_stats.hpp"
+#include <algorithm>
+#include <sstream>
+
+void ServerStats::record_rx_batch(size_t received, size_t capacity) {
+    if (received == 0 || capacity == 0) return;
+
+    rx_datagrams_.fetch_add(received, std::memory_order_relaxed);
+    rx_batches_.fetch_add(1, std::memory_order_relaxed);
+
+    size_t bucket = received >= capacity ? FILL_BUCKETS - 1 : received * 10 / capacity;
+    rx_batch_fill_[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void ServerStats::record_tx_batch(size_t sent) {
+    if (sent == 0) return;
+
+    tx_datagrams_.fetch_add(sent, std::memory_order_relaxed);
+    tx_batches_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ServerStats::record_reactor_rx(size_t reactor, size_t received) {
+    if (reactor >= MAX_REACTORS) return;
+    reactor_rx_[reactor].fetch_add(received, std::memory_order_relaxed);
+}
+
+const char* ServerStats::drop_reason_name(DropReason reason) {
+    switch (reason) {
+        case DropReason::Invalid: return "invalid";
+        case DropReason::RateLimitedIp: return "rate_limited_ip";
+        case DropReason::RateLimitedImsi: return "rate_limited_imsi";
+        case DropReason::QueueFull: return "queue_full";
+        case DropReason::QueueCoDel: return "queue_codel";
+        default: return "unknown";
+    }
+}
+
+void ServerStats::record_app_drop(DropReason reason, size_t count) {
+    if (reason >= DropReason::Count) return;
+    app_dropped_[static_cast<size_t>(reason)].fetch_add(count, std::memory_order_relaxed);
+}
+
+void ServerStats::set_reactor_kernel_drops(size_t reactor, uint64_t dropped) {
+    if (reactor >= MAX_REACTORS) return;
+    reactor_kernel_drops_[reactor].store(dropped, std::memory_order_relaxed);
+}
+
+void ServerStats::record_worker_spin(uint64_t ns, bool woken) {
+    worker_spin_ns_.fetch_add(ns, std::memory_order_relaxed);
+    if (woken) worker_spin_wakeups_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ServerStats::record_worker_park(uint64_t ns) {
+    worker_park_ns_.fetch_add(ns, std::memory_order_relaxed);
+    worker_parks_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ServerStats::set_rate_limit_buckets(uint64_t ip, uint64_t imsi) {
+    rate_limit_ip_buckets_.store(ip, std::memory_order_relaxed);
+    rate_limit_imsi_buckets_.store(imsi, std::memory_order_relaxed);
+}
+
+void ServerStats::set_queue_depth(size_t reactor, uint64_t depth) {
+    if (reactor >= MAX_REACTORS) return;
+    queue_depth_[reactor].store(depth, std::memory_order_relaxed);
+}
+
+void ServerStats::set_queue_sojourn(size_t reactor, uint64_t ns) {
+    if (reactor >= MAX_REACTORS) return;
+    queue_sojourn_ns_[reactor].store(ns, std::memory_order_relaxed);
+}
+
+void ServerStats::set_active_workers(size_t reactor, uint64_t workers) {
+    if (reactor >= MAX_REACTORS) return;
+    active_workers_[reactor].store(workers, std::memory_order_relaxed);
+}
+
+void ServerStats::set_partitions(size_t count) {
+    partitions_.store(std::min(count, MAX_PARTITIONS), std::memory_order_relaxed);
+}
+
+void ServerStats::set_partition_depth(size_t partition, uint64_t depth) {
+    if (partition >= MAX_PARTITIONS) return;
+    partition_depth_[partition].store(depth, std::memory_order_relaxed);
+}
+
+uint64_t ServerStats::app_dropped() const {
+    uint64_t total = 0;
+    for (const auto& counter : app_dropped_) {
+        total += counter.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t ServerStats::kernel_rx_dropped() const {
+    uint64_t total = 0;
+    for (const auto& counter : reactor_kernel_drops_) {
+        total += counter.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::string ServerStats::render() const {
+    std::ostringstream oss;
+    oss << "rx_datagrams " << rx_datagrams() << "\n";
+    oss << "rx_batches " << rx_batches() << "\n";
+    for (size_t i = 0; i < FILL_BUCKETS; ++i) {
+        oss << "rx_batch_fill{pct=\"" << i * 10 << "\"} " << rx_batch_fill(i) << "\n";
+    }
+    oss << "socket_drops " << socket_drops() << "\n";
+    // Lost before the server read them vs. discarded by the server afterwards.
+    // SO_RXQ_OVFL reports sk_drops, which a socket filter's rejections also raise.
+    if (socket_filter()) oss << "# kernel_rx_dropped includes socket filter rejections\n";
+    oss << "kernel_rx_dropped " << kernel_rx_dropped() << "\n";
+    for (size_t i = 0; i < DROP_REASONS; ++i) {
+        oss << "app_dropped{reason=\"" << drop_reason_name(static_cast<DropReason>(i)) << "\"} "
+            << app_dropped(static_cast<DropReason>(i)) << "\n";
+    }
+    oss << "rate_limit_buckets{table=\"ip\"} " << rate_limit_ip_buckets() << "\n";
+    oss << "rate_limit_buckets{table=\"imsi\"} " << rate_limit_imsi_buckets() << "\n";
+    oss << "tx_datagrams " << tx_datagrams() << "\n";
+    oss << "tx_batches " << tx_batches() << "\n";
+    // Spinning costs CPU, parking costs a wake-up per arrival.
+    oss << "worker_spin_ns " << worker_spin_ns() << "\n";
+    oss << "worker_spin_wakeups " << worker_spin_wakeups() << "\n";
+    oss << "worker_park_ns " << worker_park_ns() << "\n";
+    oss << "worker_parks " << worker_parks() << "\n";
+    oss << "worker_steals " << worker_steals() << "\n";
+    // Reactors that never received anything are left out.
+    for (size_t i = 0; i < MAX_REACTORS; ++i) {
+        if (reactor_rx(i) > 0) {
+            oss << "reactor_rx{reactor=\"" << i << "\"} " << reactor_rx(i) << "\n";
+            oss << "task_queue_depth{reactor=\"" << i << "\"} " << queue_depth(i) << "\n";
+            oss << "task_queue_sojourn_ns{reactor=\"" << i << "\"} " << queue_sojourn_ns(i) << "\n";
+            oss << "active_workers{reactor=\"" << i << "\"} " << active_workers(i) << "\n";
+        }
+    }
+    // In imsi_affinity mode the tasks queue per partition, not per reactor.
+    for (size_t i = 0; i < partitions(); ++i) {
+        oss << "partition_queue_depth{worker=\"" << i << "\"} " << partition_depth(i) << "\n";
+    }
+    return oss.str();
+}
@@ -0,0 +1,55 @@
+#include "../include/server/session_store.hpp"
+#include <algorithm>
+
+ShardedSessionTable::ShardedSessionTable(size_t shards, std::chrono::milliseconds tick)
+    : shard_count_(std::max<size_t>(shards, 1)), shards_(new Shard[shard_count_]) {
+    auto epoch = Clock::now();
+    for (size_t i = 0; i < shard_count_; ++i) {
+        shards_[i].sessions = FlatSessionMap(epoch, tick);
+    }
+}
+
+// The low decimal digits pick the shard; the maps hash the whole key.
+ShardedSessionTable::Shard& ShardedSessionTable::shard_of(ImsiKey imsi) {
+    return shards_[imsi % shard_count_];
+}
+
+bool ShardedSessionTable::active(const std::string& imsi) {
+    return active(pack_imsi(imsi));
+}
+
+bool ShardedSessionTable::active(ImsiKey imsi) {
+    Shard& shard = shard_of(imsi);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.sessions.contains(imsi);
+}
+
+bool ShardedSessionTable::open(ImsiKey imsi, Clock::time_point now) {
+    Shard& shard = shard_of(imsi);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.sessions.open(imsi, now);
+}
+
+void ShardedSessionTable::insert(ImsiKey imsi, Clock::time_point started) {
+    Shard& shard = shard_of(imsi);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.sessions.insert(imsi, started);
+}
+
+void ShardedSessionTable::expire(Clock::time_point now, std::chrono::milliseconds timeout,
+                                 std::vector<ImsiKey>& expired) {
+    for (size_t i = 0; i < shard_count_; ++i) {
+        Shard& shard = shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.sessions.expire(now, timeout, expired);
+    }
+}
+
+size_t ShardedSessionTable::size() {
+    size_t count = 0;
+    for (size_t i = 0; i < shard_count_; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        count += shards_[i].sessions.size();
+    }
+    return count;
+}
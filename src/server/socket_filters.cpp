@@ -0,0 +1,152 @@
+#include "../include/server/socket_filters.hpp"
+#include <sys/socket.h>
+#include <linux/sock_diag.h>
+#include <linux/udp.h>
+#include <netinet/in.h>
+#include <cerrno>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace {
+constexpr uint32_t STEERING_MULTIPLIER = 0x9E3779B1;
+constexpr uint32_t UDP_HEADER_LEN = sizeof(udphdr);
+constexpr uint32_t IMSI_PAYLOAD_LEN = 8;
+constexpr uint32_t ACCEPT_PACKET = 0xFFFFFFFF;
+
+uint32_t load_be32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+}
+
+std::vector<sock_filter> build_imsi_steering_program(uint32_t groups) {
+    return {
+        BPF_STMT(BPF_LD | BPF_W | BPF_LEN, 0),
+        BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, IMSI_STEERING_BYTES, 0, 8),
+        // hash = ((word0 ^ word1) * golden ratio) >> 16
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 0),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 4),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+        BPF_STMT(BPF_ALU | BPF_MUL | BPF_K, STEERING_MULTIPLIER),
+        BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 16),
+        BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, groups),
+        BPF_STMT(BPF_RET | BPF_A, 0),
+        BPF_STMT(BPF_RET | BPF_K, groups),
+    };
+}
+
+uint32_t imsi_steering_index(const uint8_t* payload, size_t len, uint32_t groups) {
+    if (len < IMSI_STEERING_BYTES) return groups;
+
+    uint32_t hash = (load_be32(payload) ^ load_be32(payload + 4)) * STEERING_MULTIPLIER;
+    return (hash >> 16) % groups;
+}
+
+bool attach_imsi_steering(int sockfd, uint32_t groups) {
+    if (groups == 0) return false;
+
+    std::vector<sock_filter> program = build_imsi_steering_program(groups);
+    sock_fprog fprog{};
+    fprog.len = static_cast<unsigned short>(program.size());
+    fprog.filter = program.data();
+
+    if (setsockopt(sockfd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &fprog, sizeof(fprog)) < 0) {
+        spdlog::error("setsockopt(SO_ATTACH_REUSEPORT_CBPF) failed: {}", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+std::vector<sock_filter> build_imsi_validation_program() {
+    std::vector<sock_filter> program;
+    std::vector<size_t> jumps_to_drop;
+
+    auto reject_if = [&](uint16_t jump, uint32_t k) {
+        jumps_to_drop.push_back(program.size());
+        program.push_back(BPF_JUMP(BPF_JMP | jump | BPF_K, k, 0, 0));
+    };
+
+    program.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_LEN, 0));
+    jumps_to_drop.push_back(program.size());
+    program.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, UDP_HEADER_LEN + IMSI_PAYLOAD_LEN, 0, 0));
+
+    for (uint32_t i = 0; i < IMSI_PAYLOAD_LEN; ++i) {
+        program.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_ABS, UDP_HEADER_LEN + i));
+        program.push_back(BPF_STMT(BPF_ALU | BPF_AND | BPF_K, 0x0F));
+        reject_if(BPF_JGE, 10);
+
+        program.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_ABS, UDP_HEADER_LEN + i));
+        program.push_back(BPF_STMT(BPF_ALU | BPF_AND | BPF_K, 0xF0));
+        if (i + 1 < IMSI_PAYLOAD_LEN) {
+            reject_if(BPF_JGE, 0xA0);
+        } else {
+            reject_if(BPF_JEQ, 0xF0);
+        }
+    }
+
+    program.push_back(BPF_STMT(BPF_RET | BPF_K, ACCEPT_PACKET));
+    size_t drop = program.size();
+    program.push_back(BPF_STMT(BPF_RET | BPF_K, 0));
+
+    // Point every check at the final "drop": JGE rejects on true, JEQ on false.
+    for (size_t index : jumps_to_drop) {
+        uint8_t offset = static_cast<uint8_t>(drop - index - 1);
+        if (BPF_OP(program[index].code) == BPF_JGE) {
+            program[index].jt = offset;
+        } else {
+            program[index].jf = offset;
+        }
+    }
+    return program;
+}
+
+bool attach_imsi_validation(int sockfd) {
+    std::vector<sock_filter> program = build_imsi_validation_program();
+    sock_fprog fprog{};
+    fprog.len = static_cast<unsigned short>(program.size());
+    fprog.filter = program.data();
+
+    if (setsockopt(sockfd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) < 0) {
+        spdlog::error("setsockopt(SO_ATTACH_FILTER) failed: {}", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+uint64_t socket_drop_count(int sockfd) {
+    uint32_t meminfo[SK_MEMINFO_VARS] = {};
+    socklen_t len = sizeof(meminfo);
+    if (getsockopt(sockfd, SOL_SOCKET, SO_MEMINFO, meminfo, &len) < 0 || len <= SK_MEMINFO_DROPS * sizeof(uint32_t)) {
+        return 0;
+    }
+    return meminfo[SK_MEMINFO_DROPS];
+}
+
+std::vector<sock_filter> build_udp_port_program(uint16_t port) {
+    return {
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 6),
+        // Fragments carry no UDP header past the first one: MF flag or offset set.
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6),
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x3FFF, 4, 0),
+        // X = IPv4 header length, then the UDP destination port.
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, port, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, ACCEPT_PACKET),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+}
+
+bool attach_drop_all(int sockfd) {
+    sock_filter drop = BPF_STMT(BPF_RET | BPF_K, 0);
+    sock_fprog fprog{};
+    fprog.len = 1;
+    fprog.filter = &drop;
+
+    if (setsockopt(sockfd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) < 0) {
+        spdlog::error("setsockopt(SO_ATTACH_FILTER) failed: {}", strerror(errno));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,30 @@
+#include "../include/server/spin_policy.hpp"
+#include <algorithm>
+
+namespace {
+// Weight of a new sample in the moving average of the gaps: 1/8.
+constexpr int GAP_SMOOTHING = 8;
+// Shortest spin worth doing once spinning pays off at all.
+constexpr std::chrono::nanoseconds MIN_BUDGET{1000};
+}
+
+// Starts at the maximum: the first waits tell whether spinning pays off.
+SpinPolicy::SpinPolicy(std::chrono::nanoseconds max_budget)
+    : max_budget_(std::max(max_budget, std::chrono::nanoseconds::zero())),
+      average_gap_(max_budget_ / 2),
+      budget_(max_budget_) {}
+
+void SpinPolicy::record_wait(std::chrono::nanoseconds waited) {
+    if (max_budget_ == std::chrono::nanoseconds::zero()) return;
+
+    // An idle period of seconds would otherwise take hundreds of short gaps to
+    // average out once traffic resumes.
+    waited = std::min(waited, 4 * max_budget_);
+    average_gap_ += (waited - average_gap_) / GAP_SMOOTHING;
+
+    if (average_gap_ > max_budget_) {
+        budget_ = std::chrono::nanoseconds::zero();
+    } else {
+        budget_ = std::clamp(2 * average_gap_, std::min(MIN_BUDGET, max_budget_), max_budget_);
+    }
+}
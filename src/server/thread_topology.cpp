@@ -0,0 +1,63 @@
+#include "../include/server/thread_topology.hpp"
+#include <pthread.h>
+#include <sched.h>
+#include <cerrno>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace {
+// pthread_setname_np accepts 15 characters and the terminating zero.
+constexpr size_t MAX_THREAD_NAME = 15;
+}
+
+void set_thread_name(const std::string& name) {
+    pthread_setname_np(pthread_self(), name.substr(0, MAX_THREAD_NAME).c_str());
+}
+
+bool pin_thread(const std::vector<int>& cpus) {
+    if (cpus.empty()) return true;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < 0 || cpu >= CPU_SETSIZE) {
+            errno = EINVAL;
+            return false;
+        }
+        CPU_SET(cpu, &set);
+    }
+    // Returns the error instead of setting errno.
+    int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (error != 0) {
+        errno = error;
+        return false;
+    }
+    return true;
+}
+
+std::vector<int> cpu_of(const std::vector<int>& cpus, size_t index) {
+    if (cpus.empty()) return {};
+    return {cpus[index % cpus.size()]};
+}
+
+void apply_thread_role(const std::string& name, const std::vector<int>& cpus) {
+    set_thread_name(name);
+    if (!pin_thread(cpus)) {
+        spdlog::warn("Failed to pin thread {} to CPUs {}: {}", name, format_cpu_list(cpus), strerror(errno));
+    }
+}
+
+std::string format_cpu_list(const std::vector<int>& cpus) {
+    if (cpus.empty()) return "any";
+
+    std::string text;
+    for (size_t i = 0; i < cpus.size(); ) {
+        size_t last = i;
+        while (last + 1 < cpus.size() && cpus[last + 1] == cpus[last] + 1) ++last;
+        if (!text.empty()) text += ',';
+        text += std::to_string(cpus[i]);
+        if (last > i) text += '-' + std::to_string(cpus[last]);
+        i = last + 1;
+    }
+    return text;
+}
@@ -0,0 +1,223 @@
+#include "../include/server/timing_wheel.hpp"
+#include <algorithm>
+
+namespace {
+// Whether tick `a` is not after tick `b`, across the wrap.
+bool not_after(uint32_t a, uint32_t b) {
+    return static_cast<int32_t>(a - b) <= 0;
+}
+}
+
+TimingWheel::TimingWheel(uint32_t now) : now_(now) {
+    for (auto& level : heads_) {
+        for (uint32_t& head : level) {
+            head = NONE;
+        }
+    }
+}
+
+// The top level has only as many units as 32-bit ticks hold.
+size_t TimingWheel::slot_of(int level, uint32_t unit) {
+    uint64_t units = uint64_t{1} << (32 - UNIT_BITS * level);
+    return unit & (std::min<uint64_t>(SLOTS, units) - 1);
+}
+
+void TimingWheel::schedule(uint32_t id, uint32_t tick) {
+    if (static_cast<int32_t>(tick - now_) < 0) {
+        push(overdue_, id);
+        ++overdue_count_;
+        return;
+    }
+    place(id, tick);
+}
+
+// The lowest level whose window, the current unit of the level above and
+// the next, holds the tick.
+void TimingWheel::place(uint32_t id, uint32_t tick) {
+    uint32_t delta = tick - now_;
+    int level = LEVELS - 1;
+    for (int l = 0; l < LEVELS - 1; ++l) {
+        int shift = UNIT_BITS * (l + 1);
+        uint64_t offset = now_ & ((uint64_t{1} << shift) - 1);
+        if (((offset + delta) >> shift) <= 1) {
+            level = l;
+            break;
+        }
+    }
+    size_t slot = slot_of(level, tick >> (UNIT_BITS * level));
+    push(heads_[level][slot], id);
+    ++slot_counts_[level][slot];
+    ++counts_[level];
+}
+
+void TimingWheel::push(uint32_t& head, uint32_t id) {
+    if (head == NONE || blocks_[head].count == BLOCK_ENTRIES) {
+        uint32_t block = allocate();
+        blocks_[block].next = head;
+        head = block;
+    }
+    Block& block = blocks_[head];
+    block.ids[block.count++] = id;
+}
+
+uint32_t TimingWheel::allocate() {
+    uint32_t block;
+    if (free_ != NONE) {
+        block = free_;
+        free_ = blocks_[block].next;
+    } else {
+        block = static_cast<uint32_t>(blocks_.size());
+        blocks_.emplace_back();
+    }
+    blocks_[block].count = 0;
+    blocks_[block].next = NONE;
+    return block;
+}
+
+void TimingWheel::release(uint32_t chain) {
+    while (chain != NONE) {
+        uint32_t next = blocks_[chain].next;
+        blocks_[chain].next = free_;
+        free_ = chain;
+        chain = next;
+    }
+}
+
+// The unit is the current or the next one of `level`, so place() puts the
+// entries on a lower level and never back into this slot. An entry whose id
+// has moved out of the unit, or to a tick already passed, was left behind.
+void TimingWheel::move_down(int level, size_t slot, uint32_t first, size_t count, const std::vector<uint32_t>& ticks) {
+    int shift = UNIT_BITS * level;
+    uint32_t& head = heads_[level][slot];
+    while (count > 0 && head != NONE) {
+        uint32_t block = head;
+        while (count > 0 && blocks_[block].count > 0) {
+            uint32_t id = blocks_[block].ids[--blocks_[block].count];
+            --slot_counts_[level][slot];
+            --counts_[level];
+            --count;
+            uint32_t tick = ticks[id];
+            if ((tick >> shift) == (first >> shift) && static_cast<int32_t>(tick - now_) >= 0) place(id, tick);
+        }
+        if (blocks_[block].count == 0) {
+            head = blocks_[block].next;
+            blocks_[block].next = free_;
+            free_ = block;
+        }
+    }
+}
+
+void TimingWheel::step(const std::vector<uint32_t>& ticks, std::vector<uint32_t>& due) {
+    for (int level = LEVELS - 1; level > 0; --level) {
+        int shift = UNIT_BITS * level;
+        uint32_t unit = now_ >> shift;
+        uint32_t first = unit << shift;
+        // Left over only when advance() jumped: it all moves now.
+        size_t current = slot_of(level, unit);
+        if (slot_counts_[level][current] > 0) move_down(level, current, first, slot_counts_[level][current], ticks);
+
+        // The next unit is moved down in even shares, and must be down by
+        // the last unit of the level below, where that level's own moves begin.
+        size_t next = slot_of(level, unit + 1);
+        if (slot_counts_[level][next] > 0) {
+            uint32_t next_first = first + (1u << shift);
+            uint32_t deadline = next_first - (1u << (shift - UNIT_BITS));
+            int64_t ticks_left = std::max<int64_t>(static_cast<int32_t>(deadline - now_) + int64_t{1}, 1);
+            size_t remaining = slot_counts_[level][next];
+            move_down(level, next, next_first, (remaining + ticks_left - 1) / ticks_left, ticks);
+        }
+    }
+
+    size_t slot = now_ & (SLOTS - 1);
+    uint32_t chain = heads_[0][slot];
+    heads_[0][slot] = NONE;
+    for (uint32_t block = chain; block != NONE; block = blocks_[block].next) {
+        for (uint32_t i = 0; i < blocks_[block].count; ++i) {
+            uint32_t id = blocks_[block].ids[i];
+            if (ticks[id] == now_) due.push_back(id);
+        }
+    }
+    counts_[0] -= slot_counts_[0][slot];
+    slot_counts_[0][slot] = 0;
+    release(chain);
+    ++now_;
+}
+
+// With nothing on level 0 and no slot to move down, the next thing to happen
+// is the start of the next unit of the lowest level holding entries.
+uint32_t TimingWheel::next_event() const {
+    if (counts_[0] > 0) return now_;
+    int lowest = 0;
+    for (int level = LEVELS - 1; level > 0; --level) {
+        uint32_t unit = now_ >> (UNIT_BITS * level);
+        if (slot_counts_[level][slot_of(level, unit)] > 0 || slot_counts_[level][slot_of(level, unit + 1)] > 0) {
+            return now_;
+        }
+        if (counts_[level] > 0) lowest = level;
+    }
+    return ((now_ >> (UNIT_BITS * lowest)) + 1) << (UNIT_BITS * lowest);
+}
+
+void TimingWheel::advance(uint32_t to, const std::vector<uint32_t>& ticks, std::vector<uint32_t>& due) {
+    if (overdue_ != NONE) {
+        uint32_t chain = overdue_;
+        overdue_ = NONE;
+        size_t taken = 0;
+        for (uint32_t block = chain; block != NONE; block = blocks_[block].next) {
+            for (uint32_t i = 0; i < blocks_[block].count; ++i) {
+                uint32_t id = blocks_[block].ids[i];
+                if (not_after(ticks[id], to)) {
+                    due.push_back(id);
+                    ++taken;
+                } else {
+                    push(overdue_, id);
+                }
+            }
+        }
+        release(chain);
+        overdue_count_ -= taken;
+    }
+
+    while (not_after(now_, to)) {
+        if (size() == overdue_count_) {
+            now_ = to + 1;
+            break;
+        }
+        uint32_t next = next_event();
+        if (next != now_) {
+            if (!not_after(next, to)) {
+                now_ = to + 1;
+                break;
+            }
+            now_ = next;
+            continue;
+        }
+        step(ticks, due);
+    }
+}
+
+void TimingWheel::clear() {
+    for (int level = 0; level < LEVELS; ++level) {
+        for (size_t slot = 0; slot < SLOTS; ++slot) {
+            release(heads_[level][slot]);
+            heads_[level][slot] = NONE;
+            slot_counts_[level][slot] = 0;
+        }
+        counts_[level] = 0;
+    }
+    release(overdue_);
+    overdue_ = NONE;
+    overdue_count_ = 0;
+}
+
+size_t TimingWheel::size() const {
+    size_t count = overdue_count_;
+    for (size_t level : counts_) {
+        count += level;
+    }
+    return count;
+}
+
+size_t TimingWheel::memory() const {
+    return blocks_.size() * sizeof(Block) + sizeof(heads_) + sizeof(slot_counts_);
+}
@@ -0,0 +1,95 @@
+#include "../include/server/udp_batch.hpp"
+#include <cerrno>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+bool read_rxq_ovfl(const msghdr& msg, uint32_t& drops) {
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&msg), cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+            std::memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+            return true;
+        }
+    }
+    return false;
+}
+
+// Control buffers are uint64_t slots so every cmsghdr is suitably aligned.
+UdpRecvBatch::UdpRecvBatch(size_t capacity)
+    : msgs_(capacity), iovecs_(capacity), addrs_(capacity), buffers_(capacity * MAX_DATAGRAM_SIZE),
+      controls_(capacity * (RXQ_OVFL_CONTROL_SIZE / sizeof(uint64_t))) {
+    for (size_t i = 0; i < capacity; ++i) {
+        iovecs_[i].iov_base = &buffers_[i * MAX_DATAGRAM_SIZE];
+        iovecs_[i].iov_len = MAX_DATAGRAM_SIZE;
+
+        msgs_[i].msg_hdr = {};
+        msgs_[i].msg_hdr.msg_iov = &iovecs_[i];
+        msgs_[i].msg_hdr.msg_iovlen = 1;
+        msgs_[i].msg_hdr.msg_name = &addrs_[i];
+        msgs_[i].msg_hdr.msg_control = &controls_[i * (RXQ_OVFL_CONTROL_SIZE / sizeof(uint64_t))];
+    }
+}
+
+int UdpRecvBatch::receive(int sockfd) {
+    for (auto& msg : msgs_) {
+        msg.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        msg.msg_hdr.msg_controllen = RXQ_OVFL_CONTROL_SIZE;
+        msg.msg_len = 0;
+    }
+
+    while (true) {
+        int n = recvmmsg(sockfd, msgs_.data(), msgs_.size(), 0, nullptr);
+        if (n > 0) {
+            // The counter only grows, the last datagram carries the newest value.
+            uint32_t drops = 0;
+            if (read_rxq_ovfl(msgs_[n - 1].msg_hdr, drops)) kernel_drops_.store(drops, std::memory_order_relaxed);
+        }
+        if (n >= 0) return n;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+        spdlog::error("recvmmsg failed: {}", strerror(errno));
+        return -1;
+    }
+}
+
+UdpSendBatch::UdpSendBatch(size_t capacity)
+    : msgs_(capacity), iovecs_(capacity), addrs_(capacity) {
+    for (size_t i = 0; i < capacity; ++i) {
+        msgs_[i].msg_hdr = {};
+        msgs_[i].msg_hdr.msg_iov = &iovecs_[i];
+        msgs_[i].msg_hdr.msg_iovlen = 1;
+        msgs_[i].msg_hdr.msg_name = &addrs_[i];
+        msgs_[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    }
+}
+
+bool UdpSendBatch::add(int sockfd, const sockaddr_in& addr, const char* data, size_t len) {
+    if (full() || (count_ > 0 && sockfd != sockfd_)) return false;
+
+    sockfd_ = sockfd;
+    addrs_[count_] = addr;
+    iovecs_[count_].iov_base = const_cast<char*>(data);
+    iovecs_[count_].iov_len = len;
+    ++count_;
+    return true;
+}
+
+int UdpSendBatch::flush() {
+    size_t sent = 0;
+    int delivered = 0;
+    while (sent < count_) {
+        int n = sendmmsg(sockfd_, &msgs_[sent], count_ - sent, 0);
+        if (n > 0) {
+            sent += n;
+            delivered += n;
+            continue;
+        }
+        if (n == -1 && errno == EINTR) continue;
+
+        // The first pending datagram could not be sent: drop it and keep going.
+        spdlog::warn("sendmmsg failed: {}", strerror(errno));
+        ++sent;
+    }
+
+    count_ = 0;
+    return delivered;
+}
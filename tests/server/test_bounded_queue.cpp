@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include "server/bounded_queue.hpp"
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+namespace {
+QueueLimits make_limits(size_t capacity, OverloadPolicy policy) {
+    QueueLimits limits;
+    limits.capacity = capacity;
+    limits.policy = policy;
+    limits.codel_target = milliseconds(5);
+    limits.codel_interval = milliseconds(100);
+    return limits;
+}
+}
+
+TEST(BoundedQueueTest, ParsesPolicyNames) {
+    OverloadPolicy policy = OverloadPolicy::TailDrop;
+    EXPECT_TRUE(parse_overload_policy("drop_oldest", policy));
+    EXPECT_EQ(policy, OverloadPolicy::DropOldest);
+    EXPECT_TRUE(parse_overload_policy("codel", policy));
+    EXPECT_EQ(policy, OverloadPolicy::CoDel);
+    EXPECT_TRUE(parse_overload_policy("tail_drop", policy));
+    EXPECT_EQ(policy, OverloadPolicy::TailDrop);
+    EXPECT_FALSE(parse_overload_policy("red", policy));
+}
+
+TEST(BoundedQueueTest, TailDropRejectsWhenFull) {
+    QueueLimits limits = make_limits(2, OverloadPolicy::TailDrop);
+    BoundedQueue<int> queue(limits);
+    QueueConsumer consumer(limits);
+    auto now = Clock::now();
+    EXPECT_EQ(queue.push(1, now), BoundedQueue<int>::PushResult::Queued);
+    EXPECT_FALSE(queue.rejects_push());
+    EXPECT_EQ(queue.push(2, now), BoundedQueue<int>::PushResult::Queued);
+    EXPECT_TRUE(queue.rejects_push());
+    EXPECT_EQ(queue.push(3, now), BoundedQueue<int>::PushResult::Rejected);
+    EXPECT_EQ(queue.size(), 2u);
+
+    int item = 0;
+    ASSERT_TRUE(queue.pop(item, now, consumer));
+    EXPECT_EQ(item, 1);
+    EXPECT_EQ(consumer.dropped, 0u);
+}
+
+TEST(BoundedQueueTest, CapacityIsExactNotRoundedToRingSize) {
+    QueueLimits limits = make_limits(3, OverloadPolicy::TailDrop);
+    BoundedQueue<int> queue(limits);
+    auto now = Clock::now();
+    EXPECT_EQ(queue.capacity(), 3u);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(queue.push(int{i}, now), BoundedQueue<int>::PushResult::Queued);
+    }
+    EXPECT_TRUE(queue.full());
+    EXPECT_EQ(queue.push(3, now), BoundedQueue<int>::PushResult::Rejected);
+
+    // A zero share refuses every item, whatever the policy.
+    BoundedQueue<int> none(make_limits(0, OverloadPolicy::DropOldest));
+    EXPECT_TRUE(none.rejects_push());
+    EXPECT_EQ(none.push(1, now), BoundedQueue<int>::PushResult::Rejected);
+    EXPECT_TRUE(none.empty());
+}
+
+TEST(BoundedQueueTest, DropOldestReplacesHead) {
+    QueueLimits limits = make_limits(2, OverloadPolicy::DropOldest);
+    BoundedQueue<int> queue(limits);
+    QueueConsumer consumer(limits);
+    auto now = Clock::now();
+    queue.push(1, now);
+    queue.push(2, now);
+    EXPECT_FALSE(queue.rejects_push());
+    EXPECT_EQ(queue.push(3, now), BoundedQueue<int>::PushResult::DroppedOldest);
+    EXPECT_EQ(queue.size(), 2u);
+
+    int item = 0;
+    queue.pop(item, now, consumer);
+    EXPECT_EQ(item, 2);
+    queue.pop(item, now, consumer);
+    EXPECT_EQ(item, 3);
+    EXPECT_FALSE(queue.pop(item, now, consumer));
+}
+
+TEST(BoundedQueueTest, PopReportsSojournTime) {
+    QueueLimits limits = make_limits(8, OverloadPolicy::TailDrop);
+    BoundedQueue<int> queue(limits);
+    QueueConsumer consumer(limits);
+    auto now = Clock::now();
+    queue.push(1, now);
+
+    int item = 0;
+    ASSERT_TRUE(queue.pop(item, now + milliseconds(7), consumer));
+    EXPECT_EQ(consumer.last_sojourn, milliseconds(7));
+}
+
+TEST(BoundedQueueTest, CoDelDropsOnlyAfterAnIntervalAboveTarget) {
+    QueueLimits limits = make_limits(1024, OverloadPolicy::CoDel);
+    BoundedQueue<int> queue(limits);
+    QueueConsumer consumer(limits);
+    auto start = Clock::now();
+    for (int i = 0; i < 100; ++i) {
+        queue.push(int{i}, start);
+    }
+
+    // Every task waited 50 ms: the first one starts the interval, nothing is dropped yet.
+    int item = 0;
+    ASSERT_TRUE(queue.pop(item, start + milliseconds(50), consumer));
+    EXPECT_EQ(consumer.dropped, 0u);
+
+    // Still above target a full interval later: CoDel drops one and delivers the next.
+    ASSERT_TRUE(queue.pop(item, start + milliseconds(151), consumer));
+    EXPECT_EQ(consumer.dropped, 1u);
+    EXPECT_EQ(item, 2);
+
+    // The second drop comes an interval later, the third interval / sqrt(2) after that.
+    ASSERT_TRUE(queue.pop(item, start + milliseconds(240), consumer));
+    EXPECT_EQ(consumer.dropped, 1u);
+    ASSERT_TRUE(queue.pop(item, start + milliseconds(252), consumer));
+    EXPECT_EQ(consumer.dropped, 2u);
+    ASSERT_TRUE(queue.pop(item, start + milliseconds(320), consumer));
+    EXPECT_EQ(consumer.dropped, 2u);
+    ASSERT_TRUE(queue.pop(item, start + milliseconds(323), consumer));
+    EXPECT_EQ(consumer.dropped, 3u);
+}
+
+TEST(BoundedQueueTest, CoDelLeavesShortQueuesAlone) {
+    QueueLimits limits = make_limits(1024, OverloadPolicy::CoDel);
+    BoundedQueue<int> queue(limits);
+    QueueConsumer consumer(limits);
+    auto start = Clock::now();
+    int item = 0;
+    for (int i = 0; i < 50; ++i) {
+        auto now = start + milliseconds(300 * i);
+        queue.push(int{i}, now);
+        queue.push(int{i}, now);
+        // Below the target, and the last task of a queue is never dropped.
+        ASSERT_TRUE(queue.pop(item, now + milliseconds(1), consumer));
+        ASSERT_TRUE(queue.pop(item, now + milliseconds(200), consumer));
+    }
+    EXPECT_EQ(consumer.dropped, 0u);
+}
@@ -109,3 +109,26 @@ TEST(CdrWriterTest, WriteFailureAfterOpen) {
     chmod(filename.c_str(), 0644);  
     std::remove(filename.c_str());
 }
+
+TEST(CdrWriterTest, WriteBatchAppendsEveryRecordInOrder) {
+    std::string filename = "test_cdr_batch.log";
+    std::remove(filename.c_str());
+
+    CdrWriter writer(filename);
+    writer.write("IMSI0", "create");
+    writer.write(std::vector<CdrRecord>{{"IMSI1", "create"}, {"IMSI2", "create"}, {"IMSI3", "timeout"}});
+    writer.write(std::vector<CdrRecord>{});
+
+    std::ifstream file(filename);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) lines.push_back(line);
+    ASSERT_EQ(lines.size(), 4u);
+    EXPECT_NE(lines[1].find(", IMSI1, create"), std::string::npos);
+    EXPECT_NE(lines[2].find(", IMSI2, create"), std::string::npos);
+    EXPECT_NE(lines[3].find(", IMSI3, timeout"), std::string::npos);
+    // One timestamp for the whole batch.
+    EXPECT_EQ(lines[1].substr(0, 19), lines[3].substr(0, 19));
+
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include "server/client_task.hpp"
+#include "server/bounded_queue.hpp"
+#include "server/pgw_server.hpp"
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+#include <arpa/inet.h>
+#include <sys/eventfd.h>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// Counts the heap allocations made by the current thread while `counting` is set.
+namespace {
+thread_local bool counting = false;
+thread_local size_t allocations = 0;
+}
+
+void* operator new(std::size_t size) {
+    if (counting) ++allocations;
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+// Kept out of line: inlined into a delete expression, the free() would look
+// like it releases memory from `new` and trip -Wmismatched-new-delete.
+[[gnu::noinline]] void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+sockaddr_in make_addr(uint16_t port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+// 001010123456789 in BCD, the last byte padded with a filler nibble.
+const uint8_t IMSI[] = {0x00, 0x01, 0x01, 0x21, 0x43, 0x65, 0x87, 0xF9};
+}
+
+TEST(ClientTaskTest, KeepsPayloadAndAddressInline) {
+    ClientTask task(7, make_addr(9000), IMSI, sizeof(IMSI));
+    EXPECT_EQ(task.sockfd, 7);
+    EXPECT_EQ(ntohs(task.client_addr.sin_port), 9000);
+    ASSERT_EQ(task.length, sizeof(IMSI));
+    EXPECT_EQ(std::memcmp(task.data(), IMSI, sizeof(IMSI)), 0);
+}
+
+TEST(ClientTaskTest, CutsOffPayloadPastMaxPayload) {
+    uint8_t oversized[ClientTask::MAX_PAYLOAD + 4];
+    for (size_t i = 0; i < sizeof(oversized); ++i) oversized[i] = static_cast<uint8_t>(i);
+    ClientTask task(7, make_addr(9000), oversized, sizeof(oversized));
+    ASSERT_EQ(task.length, ClientTask::MAX_PAYLOAD);
+    EXPECT_EQ(std::memcmp(task.data(), oversized, ClientTask::MAX_PAYLOAD), 0);
+}
+
+// A worker's steady state for subscribers that already have sessions: the
+// reactor deals a batch to two workers' queues, and one worker takes its own
+// tasks, steals the other's, decodes them, finds the sessions and queues the
+// answers, sending them whenever its batch fills. The log lines are still
+// formatted, into a sink that discards them.
+TEST(ClientTaskTest, SteadyStatePacketPathDoesNotAllocate) {
+    ServerConfig config;
+    config.udp_ip = "127.0.0.1";
+    config.udp_port = 9896;
+    config.cdr_file = "test_client_task_cdr.log";
+    PgwServer server(config);
+    int event_fd = eventfd(0, EFD_NONBLOCK);
+    ASSERT_GE(event_fd, 0);
+    ASSERT_TRUE(server.test_open_worker_queues(event_fd, 2));
+    auto scratch = server.test_worker_scratch();
+
+    int client_fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    ASSERT_GE(client_fd, 0);
+    sockaddr_in client_addr = make_addr(0);
+    socklen_t addr_len = sizeof(client_addr);
+    ASSERT_EQ(bind(client_fd, (sockaddr*)&client_addr, sizeof(client_addr)), 0);
+    getsockname(client_fd, (sockaddr*)&client_addr, &addr_len);
+
+    // Eight subscribers, each sending four times per batch.
+    std::vector<std::array<uint8_t, sizeof(IMSI)>> payloads(8);
+    std::vector<Datagram> datagrams;
+    for (size_t i = 0; i < payloads.size(); ++i) {
+        std::memcpy(payloads[i].data(), IMSI, sizeof(IMSI));
+        payloads[i].back() = static_cast<uint8_t>(0xF0 | i);
+    }
+    for (int repeat = 0; repeat < 4; ++repeat) {
+        for (const auto& payload : payloads) {
+            datagrams.push_back({payload.data(), payload.size(), client_addr});
+        }
+    }
+
+    auto previous = spdlog::default_logger();
+    auto discard = std::make_shared<spdlog::logger>("discard", std::make_shared<spdlog::sinks::null_sink_mt>());
+    discard->set_level(spdlog::level::info);
+    spdlog::set_default_logger(discard);
+
+    // The first batch opens the sessions and writes their CDRs.
+    server.test_enqueue(datagrams.data(), datagrams.size());
+    while (server.test_serve_tasks(0, *scratch) > 0) {
+    }
+
+    size_t answered = 0;
+    counting = true;
+    for (int round = 0; round < 1000; ++round) {
+        server.test_enqueue(datagrams.data(), datagrams.size());
+        while (size_t served = server.test_serve_tasks(0, *scratch)) {
+            answered += served;
+        }
+    }
+    counting = false;
+    spdlog::set_default_logger(previous);
+
+    EXPECT_EQ(answered, 32000u);
+    EXPECT_GT(server.test_stats().worker_steals(), 0u);
+    EXPECT_GT(server.test_stats().tx_datagrams(), 0u);
+    EXPECT_EQ(allocations, 0u);
+
+    close(client_fd);
+    close(event_fd);
+    std::remove(config.cdr_file.c_str());
+}
+
+TEST(ClientTaskTest, DropOldestOnAFullQueueDoesNotAllocate) {
+    QueueLimits limits;
+    limits.capacity = 4;
+    limits.policy = OverloadPolicy::DropOldest;
+    BoundedQueue<ClientTask> queue(limits);
+    sockaddr_in addr = make_addr(9000);
+    auto now = std::chrono::steady_clock::now();
+
+    counting = true;
+    for (int i = 0; i < 1000; ++i) {
+        queue.push(ClientTask(3, addr, IMSI, sizeof(IMSI)), now);
+    }
+    counting = false;
+
+    EXPECT_EQ(queue.size(), 4u);
+    EXPECT_EQ(allocations, 0u);
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include "server/coro_executor.hpp"
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+// Suspends and hands its handle out, so a test decides when it resumes.
+struct Park {
+    std::coroutine_handle<>* out;
+    bool await_ready() const { return false; }
+    void await_suspend(std::coroutine_handle<> handle) { *out = handle; }
+    void await_resume() const {}
+};
+
+CoroTask record_steps(std::vector<int>& steps, std::coroutine_handle<>& parked) {
+    steps.push_back(1);
+    co_await Park{&parked};
+    steps.push_back(2);
+}
+
+CoroTask wait_readable(CoroExecutor& executor, int fd, std::vector<bool>& results) {
+    while (true) {
+        bool ready = co_await executor.readable(fd);
+        results.push_back(ready);
+        if (!ready) break;
+        uint64_t value;
+        if (read(fd, &value, sizeof(value)) < 0) break;
+    }
+}
+
+CoroTask sleep_then_stop(CoroExecutor& executor, std::chrono::nanoseconds duration, bool& woke) {
+    co_await executor.sleep_for(duration);
+    woke = true;
+    executor.stop();
+}
+
+CoroTask throw_after_start() {
+    throw std::runtime_error("boom");
+    co_return;
+}
+
+void signal(int fd) {
+    uint64_t one = 1;
+    ASSERT_EQ(write(fd, &one, sizeof(one)), static_cast<ssize_t>(sizeof(one)));
+}
+}
+
+TEST(CoroExecutorTest, SpawnRunsUntilTheFirstSuspension) {
+    CoroExecutor executor;
+    ASSERT_TRUE(executor.open());
+    std::vector<int> steps;
+    std::coroutine_handle<> parked;
+    executor.spawn(record_steps(steps, parked));
+    EXPECT_EQ(steps, std::vector<int>{1});
+    EXPECT_EQ(executor.tasks(), 1u);
+
+    parked.resume();
+    EXPECT_EQ(steps, (std::vector<int>{1, 2}));
+    EXPECT_EQ(executor.tasks(), 0u);
+}
+
+TEST(CoroExecutorTest, PostResumesOnTheExecutorThread) {
+    CoroExecutor executor;
+    ASSERT_TRUE(executor.open());
+    std::vector<int> steps;
+    std::coroutine_handle<> parked;
+    executor.spawn(record_steps(steps, parked));
+
+    std::thread other([&executor, &parked]() {
+        std::this_thread::sleep_for(10ms);
+        executor.post(parked);
+    });
+    int stop_fd = eventfd(0, EFD_NONBLOCK);
+    // run() goes on until stop_fd fires, by then the posted task has finished.
+    std::thread stopper([stop_fd]() {
+        std::this_thread::sleep_for(50ms);
+        signal(stop_fd);
+    });
+    EXPECT_TRUE(executor.run(stop_fd));
+    other.join();
+    stopper.join();
+    close(stop_fd);
+    EXPECT_EQ(steps, (std::vector<int>{1, 2}));
+}
+
+TEST(CoroExecutorTest, ReadableResumesOnEveryEventAndFalseOnStop) {
+    CoroExecutor executor;
+    ASSERT_TRUE(executor.open());
+    int fd = eventfd(0, EFD_NONBLOCK);
+    int stop_fd = eventfd(0, EFD_NONBLOCK);
+    std::vector<bool> results;
+    executor.spawn(wait_readable(executor, fd, results));
+    EXPECT_TRUE(results.empty());
+
+    std::thread other([fd, stop_fd]() {
+        signal(fd);
+        std::this_thread::sleep_for(20ms);
+        signal(fd);
+        std::this_thread::sleep_for(20ms);
+        signal(stop_fd);
+    });
+    EXPECT_TRUE(executor.run(stop_fd));
+    other.join();
+    EXPECT_EQ(results, (std::vector<bool>{true, true, false}));
+    EXPECT_EQ(executor.tasks(), 0u);
+
+    // The stop eventfd is left unread for other executors.
+    uint64_t value = 0;
+    EXPECT_EQ(read(stop_fd, &value, sizeof(value)), static_cast<ssize_t>(sizeof(value)));
+    close(fd);
+    close(stop_fd);
+}
+
+TEST(CoroExecutorTest, SleepForResumesAfterTheDeadline) {
+    CoroExecutor executor;
+    ASSERT_TRUE(executor.open());
+    bool woke = false;
+    auto start = std::chrono::steady_clock::now();
+    executor.spawn(sleep_then_stop(executor, 20ms, woke));
+    EXPECT_FALSE(woke);
+    EXPECT_FALSE(executor.run());
+    EXPECT_TRUE(woke);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+}
+
+TEST(CoroExecutorTest, StopWaitsForSleepingTasks) {
+    CoroExecutor executor;
+    ASSERT_TRUE(executor.open());
+    int stop_fd = eventfd(0, EFD_NONBLOCK);
+    signal(stop_fd);
+    bool woke = false;
+    executor.spawn(sleep_then_stop(executor, 10ms, woke));
+    EXPECT_FALSE(executor.run(stop_fd));
+    EXPECT_TRUE(woke);
+    close(stop_fd);
+}
+
+TEST(CoroExecutorTest, ExceptionEndsOnlyItsTask) {
+    CoroExecutor executor;
+    ASSERT_TRUE(executor.open());
+    executor.spawn(throw_after_start());
+    EXPECT_EQ(executor.tasks(), 0u);
+}
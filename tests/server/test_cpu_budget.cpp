@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include "server/cpu_budget.hpp"
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+// A mocked cgroup v2 mount with the process in /pods/pgw.
+class CpuBudgetTest : public ::testing::Test {
+protected:
+    const fs::path root = "cpu_budget_cgroup";
+    const fs::path proc_file = "cpu_budget_proc_cgroup";
+
+    void SetUp() override {
+        fs::remove_all(root);
+        fs::create_directories(root / "pods" / "pgw");
+        write(proc_file, "0::/pods/pgw\n");
+    }
+
+    void TearDown() override {
+        fs::remove_all(root);
+        fs::remove(proc_file);
+    }
+
+    static void write(const fs::path& path, const std::string& content) {
+        std::ofstream(path) << content;
+    }
+
+    CpuBudget detect() const {
+        return detect_cpu_budget(root.string(), proc_file.string());
+    }
+};
+
+TEST_F(CpuBudgetTest, WithoutLimitsFollowsTheAffinityMask) {
+    CpuBudget budget = detect();
+    EXPECT_EQ(budget.hardware, std::thread::hardware_concurrency());
+    EXPECT_GT(budget.affinity, 0u);
+    EXPECT_EQ(budget.cpuset, 0u);
+    EXPECT_EQ(budget.quota, 0);
+    EXPECT_EQ(budget.cpus(), std::min(budget.hardware, budget.affinity));
+}
+
+TEST_F(CpuBudgetTest, ReadsQuotaAndCpuset) {
+    write(root / "pods" / "pgw" / "cpu.max", "250000 100000\n");
+    write(root / "pods" / "pgw" / "cpuset.cpus.effective", "0-5\n");
+    CpuBudget budget = detect();
+    EXPECT_DOUBLE_EQ(budget.quota, 2.5);
+    EXPECT_EQ(budget.cpuset, 6u);
+}
+
+TEST_F(CpuBudgetTest, TightestQuotaOnThePathToTheRootWins) {
+    write(root / "pods" / "pgw" / "cpu.max", "max 100000\n");
+    write(root / "pods" / "cpu.max", "150000 100000\n");
+    write(root / "cpu.max", "400000 100000\n");
+    EXPECT_DOUBLE_EQ(detect().quota, 1.5);
+}
+
+TEST_F(CpuBudgetTest, IgnoresMalformedFilesAndCgroupV1) {
+    write(root / "pods" / "pgw" / "cpu.max", "lots\n");
+    write(root / "pods" / "pgw" / "cpuset.cpus.effective", "0-\n");
+    CpuBudget budget = detect();
+    EXPECT_EQ(budget.quota, 0);
+    EXPECT_EQ(budget.cpuset, 0u);
+
+    write(proc_file, "12:cpu,cpuacct:/pods/pgw\n");
+    write(root / "pods" / "pgw" / "cpu.max", "100000 100000\n");
+    EXPECT_EQ(detect().quota, 0);
+}
+
+TEST(CpuBudgetCpusTest, SmallestLimitWithQuotaRoundedUp) {
+    CpuBudget budget;
+    budget.hardware = 64;
+    budget.affinity = 64;
+    budget.cpuset = 8;
+    budget.quota = 2.5;
+    EXPECT_EQ(budget.cpus(), 3u);
+    budget.quota = 0;
+    EXPECT_EQ(budget.cpus(), 8u);
+    budget.cpuset = 0;
+    EXPECT_EQ(budget.cpus(), 64u);
+    budget.quota = 0.2;
+    EXPECT_EQ(budget.cpus(), 1u);
+    EXPECT_EQ(CpuBudget{}.cpus(), 1u);
+}
+
+TEST(CpuBudgetCpusTest, DescribesEveryLimit) {
+    CpuBudget budget;
+    budget.hardware = 64;
+    budget.affinity = 8;
+    budget.quota = 2.5;
+    EXPECT_EQ(budget.describe(), "cpu.max 2.5, cpuset -, affinity 8, hardware 64");
+}
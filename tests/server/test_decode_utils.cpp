@@ -60,3 +60,47 @@ TEST(BcdDecoderTest, LongIMSI) {
     std::vector<uint8_t> bcd = {0x12, 0x34, 0x56, 0x78, 0x90, 0x12, 0x34, 0x56}; 
     EXPECT_EQ(decoder.decode(bcd), "2143658709214365");
 }
+
+TEST(BcdDecoderTest, RawBufferMatchesVector) {
+    BcdDecoder decoder;
+    std::vector<uint8_t> bcd = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF5};
+    EXPECT_EQ(decoder.decode(bcd.data(), bcd.size()), decoder.decode(bcd));
+    EXPECT_EQ(decoder.decode(bcd.data(), 2), "1234");
+}
+
+TEST(BcdDecoderTest, HashMatchesDecodedString) {
+    BcdDecoder decoder;
+    std::vector<uint8_t> bcd = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF5};
+    EXPECT_EQ(decoder.hash(bcd.data(), bcd.size()), decoder.hash("123456789012345"));
+    // Filler nibbles are not part of the IMSI.
+    std::vector<uint8_t> padded = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF5, 0xFF};
+    EXPECT_EQ(decoder.hash(padded.data(), padded.size()), decoder.hash(bcd.data(), bcd.size()));
+}
+
+TEST(BcdDecoderTest, HashDiffersBetweenImsis) {
+    BcdDecoder decoder;
+    EXPECT_NE(decoder.hash("123456789012345"), decoder.hash("123456789012346"));
+    EXPECT_NE(decoder.hash("123456789012345"), decoder.hash("12345678901234"));
+}
+
+TEST(BcdDecoderTest, PackMatchesDecodedString) {
+    BcdDecoder decoder;
+    std::vector<uint8_t> bcd = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF5};
+    ImsiKey key = decoder.pack(bcd.data(), bcd.size());
+    EXPECT_EQ(key, pack_imsi("123456789012345"));
+    EXPECT_EQ(imsi_digits(key), 15u);
+    EXPECT_EQ(unpack_imsi(key), "123456789012345");
+    // A 16th digit makes the payload no IMSI at all.
+    std::vector<uint8_t> overlong = {0x12, 0x34, 0x56, 0x78, 0x90, 0x12, 0x34, 0x56};
+    EXPECT_EQ(decoder.pack(overlong.data(), overlong.size()), 0u);
+}
+
+TEST(BcdDecoderTest, PackKeepsLeadingZerosAndRejectsNonDigits) {
+    EXPECT_NE(pack_imsi("001010000000001"), pack_imsi("1010000000001"));
+    EXPECT_EQ(unpack_imsi(pack_imsi("001010000000001")), "001010000000001");
+    EXPECT_EQ(unpack_imsi(pack_imsi("0")), "0");
+    EXPECT_EQ(pack_imsi(""), 0u);
+    EXPECT_EQ(pack_imsi("12345a"), 0u);
+    EXPECT_EQ(pack_imsi("1234567890123456"), 0u);
+    EXPECT_EQ(unpack_imsi(0), "");
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include "server/elastic_policy.hpp"
+
+using namespace std::chrono_literals;
+
+namespace {
+ElasticLimits make_limits(size_t min_workers, size_t max_workers) {
+    ElasticLimits limits;
+    limits.min_workers = min_workers;
+    limits.max_workers = max_workers;
+    limits.grow_sojourn = 1ms;
+    limits.grow_depth = 4;
+    limits.shrink_sojourn = 100us;
+    limits.shrink_after = 3;
+    return limits;
+}
+}
+
+TEST(ElasticPolicyTest, ClampsTheStartingSizeToTheLimits) {
+    EXPECT_EQ(ElasticPolicy(make_limits(2, 8), 1).workers(), 2u);
+    EXPECT_EQ(ElasticPolicy(make_limits(2, 8), 20).workers(), 8u);
+    // A maximum below the minimum is raised to it.
+    EXPECT_EQ(ElasticPolicy(make_limits(3, 1), 1).workers(), 3u);
+    EXPECT_EQ(ElasticPolicy(make_limits(0, 0), 0).workers(), 1u);
+}
+
+TEST(ElasticPolicyTest, IdleSamplesAreCalm) {
+    ElasticLimits limits = make_limits(1, 4);
+    limits.shrink_sojourn = 0us;
+    limits.shrink_after = 1;
+    ElasticPolicy policy(limits, 4);
+    EXPECT_EQ(policy.update(0, 0us), 3u);
+    EXPECT_EQ(policy.update(0, 1us), 3u);
+}
+
+TEST(ElasticPolicyTest, GrowsByHalfOnQueueDelayOrDepth) {
+    ElasticPolicy policy(make_limits(1, 8), 1);
+    EXPECT_EQ(policy.update(0, 2ms), 2u);
+    EXPECT_EQ(policy.update(0, 2ms), 3u);
+    EXPECT_EQ(policy.update(0, 2ms), 4u);
+    // 4 workers * grow_depth 4: 17 queued tasks are too many.
+    EXPECT_EQ(policy.update(16, 500us), 4u);
+    EXPECT_EQ(policy.update(17, 500us), 6u);
+    EXPECT_EQ(policy.update(100, 10ms), 8u);
+    EXPECT_EQ(policy.update(100, 10ms), 8u);
+}
+
+TEST(ElasticPolicyTest, ShrinksByOneAfterACalmStreak) {
+    ElasticPolicy policy(make_limits(1, 8), 4);
+    EXPECT_EQ(policy.update(0, 10us), 4u);
+    EXPECT_EQ(policy.update(0, 10us), 4u);
+    EXPECT_EQ(policy.update(0, 10us), 3u);
+    // The streak starts over after each step down.
+    EXPECT_EQ(policy.update(0, 10us), 3u);
+    EXPECT_EQ(policy.update(0, 10us), 3u);
+    EXPECT_EQ(policy.update(0, 10us), 2u);
+    for (int i = 0; i < 10; ++i) {
+        policy.update(0, 0us);
+    }
+    EXPECT_EQ(policy.workers(), 1u);
+}
+
+TEST(ElasticPolicyTest, LoadBetweenTheThresholdsHoldsTheSize) {
+    ElasticPolicy policy(make_limits(1, 8), 4);
+    // Neither hot nor calm: a task waited 500 us, or as many tasks as workers are queued.
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(policy.update(0, 500us), 4u);
+        EXPECT_EQ(policy.update(4, 10us), 4u);
+    }
+    // Such a sample breaks a calm streak as well.
+    policy.update(0, 10us);
+    policy.update(0, 10us);
+    policy.update(0, 500us);
+    policy.update(0, 10us);
+    EXPECT_EQ(policy.update(0, 10us), 4u);
+    EXPECT_EQ(policy.update(0, 10us), 3u);
+}
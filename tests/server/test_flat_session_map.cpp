@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include "server/flat_session_map.hpp"
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+ImsiKey imsi_of(int n) {
+    std::string digits = std::to_string(n);
+    return pack_imsi("00101" + std::string(10 - digits.size(), '0') + digits);
+}
+}
+
+TEST(FlatSessionMapTest, OpensEachImsiOnce) {
+    FlatSessionMap sessions;
+    auto now = std::chrono::steady_clock::now();
+    EXPECT_TRUE(sessions.open(imsi_of(1), now));
+    EXPECT_FALSE(sessions.open(imsi_of(1), now + 5s));
+    EXPECT_TRUE(sessions.contains(imsi_of(1)));
+    EXPECT_FALSE(sessions.contains(imsi_of(2)));
+    EXPECT_EQ(sessions.size(), 1u);
+
+    EXPECT_FALSE(sessions.open(0, now));
+    EXPECT_FALSE(sessions.contains(0));
+    EXPECT_EQ(sessions.size(), 1u);
+}
+
+TEST(FlatSessionMapTest, GrowsAndKeepsEverySession) {
+    FlatSessionMap sessions;
+    auto now = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10000; ++i) {
+        ASSERT_TRUE(sessions.open(imsi_of(i), now));
+    }
+    EXPECT_EQ(sessions.size(), 10000u);
+    // A power of two, at most three quarters full.
+    EXPECT_EQ(sessions.capacity() & (sessions.capacity() - 1), 0u);
+    EXPECT_LE(sessions.size() * 4, sessions.capacity() * 3);
+    // 14 bytes a slot, and 4 for each session's entry in the timing wheel.
+    EXPECT_GE(sessions.memory(), sessions.capacity() * 14 + sessions.size() * 4);
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_TRUE(sessions.contains(imsi_of(i))) << i;
+    }
+    EXPECT_FALSE(sessions.contains(imsi_of(10000)));
+}
+
+TEST(FlatSessionMapTest, ExpireLeavesTheRestFindable) {
+    FlatSessionMap sessions;
+    auto now = std::chrono::steady_clock::now();
+    for (int i = 0; i < 5000; ++i) {
+        sessions.insert(imsi_of(i), i % 3 ? now : now - 10s);
+    }
+
+    std::vector<ImsiKey> expired;
+    sessions.expire(now, 1s, expired);
+    EXPECT_EQ(expired.size(), 1667u);
+    EXPECT_EQ(sessions.size(), 5000u - 1667u);
+    // Removals shift the probe runs back; every other session must still be found.
+    for (int i = 0; i < 5000; ++i) {
+        EXPECT_EQ(sessions.contains(imsi_of(i)), i % 3 != 0) << i;
+    }
+    // And a freed slot takes a new session.
+    EXPECT_TRUE(sessions.open(imsi_of(0), now));
+}
+
+TEST(FlatSessionMapTest, ExpireCountsWholeTicks) {
+    auto epoch = std::chrono::steady_clock::now();
+    FlatSessionMap sessions(epoch, 100ms);
+    sessions.insert(imsi_of(1), epoch);
+    sessions.insert(imsi_of(2), epoch + 150ms);
+
+    // 250 ms rounds up to 3 ticks: a session goes once it is 4 ticks old.
+    std::vector<ImsiKey> expired;
+    sessions.expire(epoch + 399ms, 250ms, expired);
+    EXPECT_TRUE(expired.empty());
+    sessions.expire(epoch + 400ms, 250ms, expired);
+    EXPECT_EQ(expired, std::vector<ImsiKey>{imsi_of(1)});
+    sessions.expire(epoch + 549ms, 250ms, expired);
+    EXPECT_EQ(expired, std::vector<ImsiKey>{imsi_of(1)});
+    sessions.expire(epoch + 550ms, 250ms, expired);
+    EXPECT_EQ(expired, (std::vector<ImsiKey>{imsi_of(1), imsi_of(2)}));
+}
+
+TEST(FlatSessionMapTest, ExpireAsSecondsWithTheDefaultTick) {
+    auto epoch = std::chrono::steady_clock::now();
+    FlatSessionMap sessions(epoch);
+    sessions.insert(imsi_of(1), epoch);
+
+    // Like duration_cast<seconds>(age) > 1s.
+    std::vector<ImsiKey> expired;
+    sessions.expire(epoch + 1999ms, 1s, expired);
+    EXPECT_TRUE(expired.empty());
+    sessions.expire(epoch + 2000ms, 1s, expired);
+    EXPECT_EQ(expired, std::vector<ImsiKey>{imsi_of(1)});
+}
+
+TEST(FlatSessionMapTest, ExpireAsSecondsFromAnUnalignedStart) {
+    auto epoch = std::chrono::steady_clock::now();
+    FlatSessionMap sessions(epoch);
+    sessions.insert(imsi_of(1), epoch + 900ms);
+    sessions.insert(imsi_of(2), epoch + 900ms + 10s);
+
+    // Ages are not rounded to ticks: 1.1 s old is still 1 whole second.
+    std::vector<ImsiKey> expired;
+    sessions.expire(epoch + 2000ms, 1s, expired);
+    EXPECT_TRUE(expired.empty());
+    sessions.expire(epoch + 2899ms, 1s, expired);
+    EXPECT_TRUE(expired.empty());
+    sessions.expire(epoch + 2900ms, 1s, expired);
+    EXPECT_EQ(expired, std::vector<ImsiKey>{imsi_of(1)});
+
+    // The same with a 10 s timeout.
+    expired.clear();
+    sessions.expire(epoch + 21000ms, 10s, expired);
+    EXPECT_TRUE(expired.empty());
+    sessions.expire(epoch + 21900ms, 10s, expired);
+    EXPECT_EQ(expired, std::vector<ImsiKey>{imsi_of(2)});
+}
+
+TEST(FlatSessionMapTest, InsertMovesTheStart) {
+    FlatSessionMap sessions;
+    auto now = std::chrono::steady_clock::now();
+    sessions.insert(imsi_of(1), now - 10s);
+    sessions.insert(imsi_of(1), now);
+    EXPECT_EQ(sessions.size(), 1u);
+
+    // The entry for the old start is passed over, the new one is honoured.
+    std::vector<ImsiKey> expired;
+    sessions.expire(now, 1s, expired);
+    EXPECT_TRUE(expired.empty());
+    EXPECT_TRUE(sessions.contains(imsi_of(1)));
+    sessions.expire(now + 5s, 1s, expired);
+    EXPECT_EQ(expired, std::vector<ImsiKey>{imsi_of(1)});
+}
+
+TEST(FlatSessionMapTest, AgesSurviveStampWraparound) {
+    // 32-bit ticks of 1 ms wrap after about 49.7 days.
+    auto now = std::chrono::steady_clock::now();
+    FlatSessionMap sessions(now - std::chrono::hours(24 * 60), 1ms);
+    sessions.insert(imsi_of(1), now - 5s);
+    sessions.insert(imsi_of(2), now);
+    sessions.insert(imsi_of(3), now + 1s);
+
+    std::vector<ImsiKey> expired;
+    sessions.expire(now, 1s, expired);
+    EXPECT_EQ(expired, std::vector<ImsiKey>{imsi_of(1)});
+    EXPECT_EQ(sessions.size(), 2u);
+    sessions.expire(now + 2000ms, 1s, expired);
+    EXPECT_EQ(expired, (std::vector<ImsiKey>{imsi_of(1), imsi_of(2)}));
+}
+
+TEST(FlatSessionMapTest, ExpireTakesSessionsInStartOrder) {
+    auto epoch = std::chrono::steady_clock::now();
+    FlatSessionMap sessions(epoch, 10ms);
+    // One session per tick over 10 seconds.
+    for (int i = 0; i < 1000; ++i) {
+        sessions.insert(imsi_of(i), epoch + i * 10ms);
+    }
+    std::vector<ImsiKey> expired;
+    for (int step = 1; step <= 10; ++step) {
+        sessions.expire(epoch + step * 1s + 1s, 1s, expired);
+        EXPECT_EQ(expired.size(), static_cast<size_t>(step * 100)) << step;
+    }
+    EXPECT_EQ(sessions.size(), 0u);
+    // In the order they were started.
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(expired[i], imsi_of(i)) << i;
+    }
+}
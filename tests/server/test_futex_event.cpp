@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include "server/futex_event.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+TEST(FutexEventTest, NotifyWithoutWaitersDoesNotChangeEpoch) {
+    FutexEvent event;
+    uint32_t before = event.prepare_wait();
+    event.finish_wait();
+    event.notify(1);
+    EXPECT_EQ(event.prepare_wait(), before);
+    event.finish_wait();
+}
+
+TEST(FutexEventTest, NotifyAfterPrepareMakesWaitReturn) {
+    FutexEvent event;
+    uint32_t epoch = event.prepare_wait();
+    event.notify(1);
+    // The epoch moved on, so this returns at once instead of sleeping.
+    event.wait(epoch);
+    event.finish_wait();
+    SUCCEED();
+}
+
+TEST(FutexEventTest, WakesSleepingConsumer) {
+    FutexEvent event;
+    std::atomic<bool> ready{false};
+    std::atomic<bool> woke{false};
+    std::thread consumer([&] {
+        while (!ready.load()) {
+            uint32_t epoch = event.prepare_wait();
+            if (!ready.load()) event.wait(epoch);
+            event.finish_wait();
+        }
+        woke = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(woke.load());
+    ready = true;
+    event.notify_all();
+    consumer.join();
+    EXPECT_TRUE(woke.load());
+}
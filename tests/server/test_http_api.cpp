@@ -3,9 +3,8 @@
 #include <httplib.h>
 #include <thread>
 #include <atomic>
-#include <unordered_map>
-#include <mutex>
 #include <chrono>
+#include <vector>
 #include <fcntl.h>
 #include <sys/eventfd.h>
 #include <unistd.h>
@@ -14,8 +13,7 @@ class HttpServerTest : public ::testing::Test {
 protected:
     ServerConfig config_;
     std::atomic<bool> running_;
-    std::unordered_map<std::string, std::chrono::steady_clock::time_point> sessions_;
-    std::mutex session_mutex_;
+    ShardedSessionTable sessions_;
     int event_fd_ = -1;
     std::unique_ptr<HttpServer> server_;
 
@@ -23,7 +21,7 @@ protected:
         config_.http_port = 8081;
         running_ = true;
         event_fd_ = eventfd(0, EFD_NONBLOCK);
-        server_ = std::make_unique<HttpServer>(config_, running_, sessions_, session_mutex_, event_fd_);
+        server_ = std::make_unique<HttpServer>(config_, running_, sessions_, event_fd_);
         server_->run();
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
@@ -54,10 +52,8 @@ TEST_F(HttpServerTest, CheckSubscriberWithEmptyIMSI) {
 }
 
 TEST_F(HttpServerTest, CheckSubscriberCaseSensitiveIMSI) {
-    {
-        std::lock_guard<std::mutex> lock(session_mutex_);
-        sessions_["ABC123"] = std::chrono::steady_clock::now();
-    }
+    // Only digits are packed into keys, so letters never get a session.
+    EXPECT_FALSE(sessions_.open(pack_imsi("ABC123"), std::chrono::steady_clock::now()));
 
     httplib::Client cli("localhost", config_.http_port);
     auto res = cli.Get("/check_subscriber?imsi=abc123");
@@ -67,10 +63,7 @@ TEST_F(HttpServerTest, CheckSubscriberCaseSensitiveIMSI) {
 }
 
 TEST_F(HttpServerTest, CheckSubscriberKnownIMSI) {
-    {
-        std::lock_guard<std::mutex> lock(session_mutex_);
-        sessions_["99999"] = std::chrono::steady_clock::now();
-    }
+    sessions_.insert(pack_imsi("99999"), std::chrono::steady_clock::now());
 
     httplib::Client cli("localhost", config_.http_port);
     auto res = cli.Get("/check_subscriber?imsi=99999");
@@ -98,3 +91,68 @@ TEST_F(HttpServerTest, CheckSubscriberMissingParam) {
     ASSERT_TRUE(res != nullptr);
     EXPECT_EQ(res->status, 400);
 }
+
+TEST_F(HttpServerTest, StatsEndpointNotRegisteredWithoutStats) {
+    httplib::Client cli("localhost", config_.http_port);
+    auto res = cli.Get("/stats");
+    ASSERT_TRUE(res != nullptr);
+    EXPECT_EQ(res->status, 404);
+}
+
+TEST(HttpServerStatsTest, StatsEndpointRendersCounters) {
+    ServerConfig config;
+    config.http_port = 8082;
+    std::atomic<bool> running{true};
+    ShardedSessionTable sessions;
+    int event_fd = eventfd(0, EFD_NONBLOCK);
+
+    ServerStats stats;
+    stats.record_rx_batch(3, 4);
+
+    HttpServer server(config, running, sessions, event_fd, &stats);
+    server.run();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    httplib::Client cli("localhost", config.http_port);
+    auto res = cli.Get("/stats");
+    ASSERT_TRUE(res != nullptr);
+    EXPECT_EQ(res->status, 200);
+    EXPECT_NE(res->body.find("rx_datagrams 3\n"), std::string::npos);
+
+    server.stop();
+    close(event_fd);
+}
+
+// Stands for the sessions owned by the imsi_affinity workers.
+class RecordingSessionStore : public SessionStore {
+public:
+    bool active(const std::string& imsi) override {
+        asked.push_back(imsi);
+        return imsi == "111111111111111";
+    }
+
+    std::vector<std::string> asked;
+};
+
+TEST(HttpServerStoreTest, CheckSubscriberAsksTheGivenStore) {
+    ServerConfig config;
+    config.http_port = 8083;
+    std::atomic<bool> running{true};
+    int event_fd = eventfd(0, EFD_NONBLOCK);
+
+    RecordingSessionStore sessions;
+    HttpServer server(config, running, sessions, event_fd);
+    server.run();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    httplib::Client cli("localhost", config.http_port);
+    auto active = cli.Get("/check_subscriber?imsi=111111111111111");
+    auto inactive = cli.Get("/check_subscriber?imsi=222222222222222");
+    ASSERT_TRUE(active != nullptr && inactive != nullptr);
+    EXPECT_EQ(active->body, "active\n");
+    EXPECT_EQ(inactive->body, "not active\n");
+    EXPECT_EQ(sessions.asked.size(), 2u);
+
+    server.stop();
+    close(event_fd);
+}
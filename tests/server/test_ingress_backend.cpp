@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include "server/ingress_backend.hpp"
+#include <arpa/inet.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <future>
+#include <vector>
+
+namespace {
+// Copies every delivered datagram and fires the shutdown eventfd once
+// `expected` datagrams arrived, which ends serve().
+class RecordingSink : public IngressSink {
+public:
+    RecordingSink(int event_fd, size_t expected) : event_fd_(event_fd), expected_(expected) {}
+
+    void deliver(const Datagram* datagrams, size_t count, size_t capacity) override {
+        for (size_t i = 0; i < count; ++i) {
+            payloads.emplace_back(datagrams[i].data, datagrams[i].data + datagrams[i].length);
+            sources.push_back(datagrams[i].source);
+        }
+        batches.push_back(count);
+        capacities.push_back(capacity);
+        if (payloads.size() >= expected_) {
+            uint64_t signal = 1;
+            write(event_fd_, &signal, sizeof(signal));
+        }
+    }
+
+    std::vector<std::vector<uint8_t>> payloads;
+    std::vector<sockaddr_in> sources;
+    std::vector<size_t> batches;
+    std::vector<size_t> capacities;
+
+private:
+    int event_fd_;
+    size_t expected_;
+};
+}
+
+class IngressBackendTest : public ::testing::Test {
+protected:
+    static constexpr uint16_t PORT = 9897;
+    int server_fd = -1;
+    int client_fd = -1;
+    int event_fd = -1;
+    sockaddr_in server_addr{};
+
+    void SetUp() override {
+        server_fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+        ASSERT_GE(server_fd, 0);
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_port = htons(PORT);
+        server_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+        ASSERT_EQ(bind(server_fd, (sockaddr*)&server_addr, sizeof(server_addr)), 0);
+
+        client_fd = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_GE(client_fd, 0);
+        event_fd = eventfd(0, EFD_NONBLOCK);
+        ASSERT_GE(event_fd, 0);
+    }
+
+    void TearDown() override {
+        if (server_fd >= 0) close(server_fd);
+        if (client_fd >= 0) close(client_fd);
+        if (event_fd >= 0) close(event_fd);
+    }
+
+    void send_datagrams(size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            uint8_t payload[2] = {0x21, static_cast<uint8_t>(i)};
+            sendto(client_fd, payload, sizeof(payload), 0, (sockaddr*)&server_addr, sizeof(server_addr));
+        }
+    }
+
+    // Runs serve() and fires the shutdown event if it has not returned in time.
+    bool serve_with_deadline(IngressBackend& backend, IngressSink& sink) {
+        auto result = std::async(std::launch::async, [&] { return backend.serve(sink); });
+        if (result.wait_for(std::chrono::seconds(2)) != std::future_status::ready) {
+            uint64_t signal = 1;
+            write(event_fd, &signal, sizeof(signal));
+        }
+        return result.get();
+    }
+};
+
+TEST_F(IngressBackendTest, EpollDeliversOneDatagramPerCallWithoutBatching) {
+    EpollBackend backend(1);
+    ASSERT_TRUE(backend.open(server_fd, event_fd));
+    send_datagrams(3);
+
+    RecordingSink sink(event_fd, 3);
+    EXPECT_TRUE(serve_with_deadline(backend, sink));
+    ASSERT_EQ(sink.payloads.size(), 3u);
+    EXPECT_EQ(sink.payloads[2], (std::vector<uint8_t>{0x21, 2}));
+    EXPECT_EQ(sink.batches, (std::vector<size_t>{1, 1, 1}));
+    EXPECT_EQ(sink.capacities, (std::vector<size_t>{1, 1, 1}));
+}
+
+TEST_F(IngressBackendTest, EpollBatchesWithRecvmmsg) {
+    EpollBackend backend(4);
+    ASSERT_TRUE(backend.open(server_fd, event_fd));
+    send_datagrams(6);
+
+    RecordingSink sink(event_fd, 6);
+    EXPECT_TRUE(serve_with_deadline(backend, sink));
+    ASSERT_EQ(sink.payloads.size(), 6u);
+    EXPECT_EQ(sink.batches, (std::vector<size_t>{4, 2}));
+    EXPECT_EQ(sink.capacities[0], 4u);
+
+    sockaddr_in client_addr{};
+    socklen_t len = sizeof(client_addr);
+    getsockname(client_fd, (sockaddr*)&client_addr, &len);
+    EXPECT_EQ(sink.sources[0].sin_port, client_addr.sin_port);
+}
+
+TEST_F(IngressBackendTest, EpollBatchSkipsEmptyDatagrams) {
+    EpollBackend backend(4);
+    ASSERT_TRUE(backend.open(server_fd, event_fd));
+    uint8_t payload[2] = {0x21, 0x43};
+    sendto(client_fd, payload, 0, 0, (sockaddr*)&server_addr, sizeof(server_addr));
+    sendto(client_fd, payload, sizeof(payload), 0, (sockaddr*)&server_addr, sizeof(server_addr));
+    sendto(client_fd, payload, 0, 0, (sockaddr*)&server_addr, sizeof(server_addr));
+    sendto(client_fd, payload, sizeof(payload), 0, (sockaddr*)&server_addr, sizeof(server_addr));
+
+    RecordingSink sink(event_fd, 2);
+    EXPECT_TRUE(serve_with_deadline(backend, sink));
+    ASSERT_EQ(sink.payloads.size(), 2u);
+    EXPECT_EQ(sink.payloads[0], (std::vector<uint8_t>{0x21, 0x43}));
+    EXPECT_EQ(sink.batches, (std::vector<size_t>{2}));
+}
+
+TEST_F(IngressBackendTest, EpollServeReturnsOnShutdownEvent) {
+    EpollBackend backend(32);
+    ASSERT_TRUE(backend.open(server_fd, event_fd));
+    uint64_t signal = 1;
+    write(event_fd, &signal, sizeof(signal));
+
+    RecordingSink sink(event_fd, 1);
+    EXPECT_TRUE(serve_with_deadline(backend, sink));
+    EXPECT_TRUE(sink.payloads.empty());
+
+    // The event stays readable for the other reactors.
+    uint64_t value = 0;
+    EXPECT_EQ(read(event_fd, &value, sizeof(value)), static_cast<ssize_t>(sizeof(value)));
+}
+
+TEST_F(IngressBackendTest, EpollSendsWithPlainBatchAndReadsSocket) {
+    EpollBackend backend(32);
+    auto batch = backend.make_send_batch(8);
+    ASSERT_NE(batch, nullptr);
+    EXPECT_EQ(batch->capacity(), 8u);
+    EXPECT_EQ(dynamic_cast<IoUringSendBatch*>(batch.get()), nullptr);
+    EXPECT_FALSE(backend.zero_copy());
+    EXPECT_TRUE(backend.reads_socket());
+}
+
+TEST_F(IngressBackendTest, IoUringDeliversAndSendsThroughRing) {
+    IoUringBackend backend(8);
+    if (!backend.open(server_fd, event_fd)) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    send_datagrams(5);
+
+    RecordingSink sink(event_fd, 5);
+    EXPECT_TRUE(serve_with_deadline(backend, sink));
+    ASSERT_EQ(sink.payloads.size(), 5u);
+    EXPECT_EQ(sink.payloads[4], (std::vector<uint8_t>{0x21, 4}));
+    EXPECT_EQ(sink.capacities[0], 8u);
+    EXPECT_NE(dynamic_cast<IoUringSendBatch*>(backend.make_send_batch(4).get()), nullptr);
+}
+
+TEST_F(IngressBackendTest, PacketRingIsZeroCopyAndLeavesSocketForSending) {
+    PacketRingBackend backend("lo", "127.0.0.1", PORT);
+    EXPECT_TRUE(backend.zero_copy());
+    EXPECT_FALSE(backend.reads_socket());
+    if (!backend.open(server_fd, event_fd)) {
+        GTEST_SKIP() << "AF_PACKET ring is not available (needs CAP_NET_RAW)";
+    }
+    send_datagrams(5);
+
+    RecordingSink sink(event_fd, 5);
+    EXPECT_TRUE(serve_with_deadline(backend, sink));
+    ASSERT_EQ(sink.payloads.size(), 5u);
+    EXPECT_EQ(sink.payloads[0], (std::vector<uint8_t>{0x21, 0}));
+}
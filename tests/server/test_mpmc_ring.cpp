@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include "server/mpmc_ring.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+TEST(MpmcRingTest, CapacityRoundsUpToPowerOfTwo) {
+    EXPECT_EQ(MpmcRing<int>(1).capacity(), 2u);
+    EXPECT_EQ(MpmcRing<int>(5).capacity(), 8u);
+    EXPECT_EQ(MpmcRing<int>(64).capacity(), 64u);
+}
+
+TEST(MpmcRingTest, KeepsFifoOrderUntilFull) {
+    MpmcRing<int> ring(4);
+    EXPECT_TRUE(ring.empty());
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(ring.try_push(int{i}));
+    }
+    EXPECT_FALSE(ring.try_push(4));
+    EXPECT_EQ(ring.size(), 4u);
+
+    int item = -1;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(ring.try_pop(item));
+        EXPECT_EQ(item, i);
+    }
+    EXPECT_FALSE(ring.try_pop(item));
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(MpmcRingTest, WrapsAroundManyTimes) {
+    MpmcRing<int> ring(2);
+    int item = 0;
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(ring.try_push(int{i}));
+        ASSERT_TRUE(ring.try_pop(item));
+        ASSERT_EQ(item, i);
+    }
+}
+
+TEST(MpmcRingTest, MovesOnlyOnSuccess) {
+    MpmcRing<std::unique_ptr<int>> ring(2);
+    ring.try_push(std::make_unique<int>(1));
+    ring.try_push(std::make_unique<int>(2));
+    auto extra = std::make_unique<int>(3);
+    EXPECT_FALSE(ring.try_push(std::move(extra)));
+    ASSERT_NE(extra, nullptr);
+    EXPECT_EQ(*extra, 3);
+}
+
+TEST(MpmcRingTest, EveryItemIsTakenExactlyOnceUnderContention) {
+    constexpr int PRODUCERS = 3;
+    constexpr int CONSUMERS = 3;
+    constexpr int PER_PRODUCER = 20000;
+    MpmcRing<int> ring(64);
+    std::vector<std::atomic<int>> seen(PRODUCERS * PER_PRODUCER);
+    std::atomic<int> taken{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < PER_PRODUCER; ++i) {
+                int value = p * PER_PRODUCER + i;
+                while (!ring.try_push(int{value})) std::this_thread::yield();
+            }
+        });
+    }
+    for (int c = 0; c < CONSUMERS; ++c) {
+        threads.emplace_back([&] {
+            int item = 0;
+            while (taken.load() < PRODUCERS * PER_PRODUCER) {
+                if (ring.try_pop(item)) {
+                    seen[item].fetch_add(1);
+                    taken.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    for (size_t i = 0; i < seen.size(); ++i) {
+        ASSERT_EQ(seen[i].load(), 1) << "item " << i;
+    }
+}
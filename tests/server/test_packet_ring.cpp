@@ -0,0 +1,283 @@
+#include <gtest/gtest.h>
+#include "server/packet_ring.hpp"
+#include <arpa/inet.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+uint16_t fold_checksum(uint32_t sum) {
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return static_cast<uint16_t>(~sum);
+}
+
+uint32_t sum_words(const uint8_t* p, size_t len) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        sum += (p[i] << 8) | p[i + 1];
+    }
+    if (len & 1) sum += p[len - 1] << 8;
+    return sum;
+}
+
+// IPv4 + UDP packet as seen by a SOCK_DGRAM packet socket (no link header).
+std::vector<uint8_t> build_udp_packet(const std::string& src, uint16_t sport, const std::string& dst, uint16_t dport,
+                                      const std::vector<uint8_t>& payload) {
+    std::vector<uint8_t> packet(sizeof(iphdr) + sizeof(udphdr) + payload.size());
+    auto* ip = reinterpret_cast<iphdr*>(packet.data());
+    ip->version = 4;
+    ip->ihl = 5;
+    ip->ttl = 64;
+    ip->protocol = IPPROTO_UDP;
+    ip->tot_len = htons(packet.size());
+    ip->saddr = inet_addr(src.c_str());
+    ip->daddr = inet_addr(dst.c_str());
+
+    auto* udp = reinterpret_cast<udphdr*>(packet.data() + sizeof(iphdr));
+    udp->source = htons(sport);
+    udp->dest = htons(dport);
+    udp->len = htons(sizeof(udphdr) + payload.size());
+    std::copy(payload.begin(), payload.end(), packet.begin() + sizeof(iphdr) + sizeof(udphdr));
+
+    uint32_t sum = sum_words(packet.data() + 12, 8) + IPPROTO_UDP + sizeof(udphdr) + payload.size();
+    sum += sum_words(packet.data() + sizeof(iphdr), sizeof(udphdr) + payload.size());
+    udp->check = htons(fold_checksum(sum));
+    return packet;
+}
+}
+
+TEST(PacketParseTest, ParsesPayloadAndSource) {
+    std::vector<uint8_t> payload = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF5};
+    auto packet = build_udp_packet("10.0.0.7", 40000, "127.0.0.1", 9000, payload);
+
+    PacketView view{};
+    ASSERT_TRUE(parse_udp_packet(packet.data(), packet.size(), inet_addr("127.0.0.1"), 9000, view));
+    ASSERT_EQ(view.length, payload.size());
+    EXPECT_TRUE(std::equal(payload.begin(), payload.end(), view.payload));
+    EXPECT_EQ(view.payload, packet.data() + 28);
+    EXPECT_EQ(view.source.sin_family, AF_INET);
+    EXPECT_EQ(view.source.sin_addr.s_addr, inet_addr("10.0.0.7"));
+    EXPECT_EQ(ntohs(view.source.sin_port), 40000);
+}
+
+TEST(PacketParseTest, RejectsOtherPortOrAddress) {
+    auto packet = build_udp_packet("10.0.0.7", 40000, "10.0.0.1", 9000, {0x11});
+
+    PacketView view{};
+    EXPECT_FALSE(parse_udp_packet(packet.data(), packet.size(), INADDR_ANY, 9001, view));
+    EXPECT_FALSE(parse_udp_packet(packet.data(), packet.size(), inet_addr("127.0.0.1"), 9000, view));
+    EXPECT_TRUE(parse_udp_packet(packet.data(), packet.size(), INADDR_ANY, 9000, view));
+}
+
+TEST(PacketParseTest, RejectsFragmentsAndOtherProtocols) {
+    auto packet = build_udp_packet("10.0.0.7", 40000, "10.0.0.1", 9000, {0x11});
+    auto* ip = reinterpret_cast<iphdr*>(packet.data());
+    PacketView view{};
+
+    ip->frag_off = htons(IP_MF);
+    EXPECT_FALSE(parse_udp_packet(packet.data(), packet.size(), INADDR_ANY, 9000, view));
+    ip->frag_off = htons(IP_DF);
+    EXPECT_TRUE(parse_udp_packet(packet.data(), packet.size(), INADDR_ANY, 9000, view));
+    ip->protocol = IPPROTO_TCP;
+    EXPECT_FALSE(parse_udp_packet(packet.data(), packet.size(), INADDR_ANY, 9000, view));
+}
+
+TEST(PacketParseTest, RejectsInconsistentLengths) {
+    auto packet = build_udp_packet("10.0.0.7", 40000, "10.0.0.1", 9000, {0x11, 0x22, 0x33});
+    PacketView view{};
+
+    EXPECT_FALSE(parse_udp_packet(packet.data(), packet.size() - 1, INADDR_ANY, 9000, view));
+    EXPECT_FALSE(parse_udp_packet(packet.data(), 20, INADDR_ANY, 9000, view));
+
+    auto* udp = reinterpret_cast<udphdr*>(packet.data() + sizeof(iphdr));
+    udp->len = htons(64);
+    EXPECT_FALSE(parse_udp_packet(packet.data(), packet.size(), INADDR_ANY, 9000, view));
+    udp->len = htons(4);
+    EXPECT_FALSE(parse_udp_packet(packet.data(), packet.size(), INADDR_ANY, 9000, view));
+}
+
+TEST(PacketParseTest, ChecksumDetectsCorruption) {
+    auto packet = build_udp_packet("10.0.0.7", 40000, "10.0.0.1", 9000, {0x21, 0x43, 0x65});
+    EXPECT_TRUE(udp_checksum_valid(packet.data(), packet.size()));
+
+    packet.back() ^= 0x01;
+    EXPECT_FALSE(udp_checksum_valid(packet.data(), packet.size()));
+
+    // A zero checksum field means "not computed".
+    auto* udp = reinterpret_cast<udphdr*>(packet.data() + sizeof(iphdr));
+    udp->check = 0;
+    EXPECT_TRUE(udp_checksum_valid(packet.data(), packet.size()));
+}
+
+class PacketRingTest : public ::testing::Test {
+protected:
+    static constexpr uint16_t PORT = 9898;
+    int server_fd = -1;
+    sockaddr_in server_addr{};
+
+    void SetUp() override {
+        PacketRing probe;
+        if (!probe.open("lo", "127.0.0.1", PORT)) {
+            GTEST_SKIP() << "AF_PACKET ring is not available (needs CAP_NET_RAW)";
+        }
+
+        // A bound UDP socket keeps the kernel from answering with ICMP port unreachable.
+        server_fd = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_GE(server_fd, 0);
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_port = htons(PORT);
+        server_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+        ASSERT_EQ(bind(server_fd, (sockaddr*)&server_addr, sizeof(server_addr)), 0);
+    }
+
+    void TearDown() override {
+        if (server_fd >= 0) close(server_fd);
+    }
+
+    void send_from(int fd, const std::vector<uint8_t>& payload, uint16_t port = PORT) {
+        sockaddr_in addr = server_addr;
+        addr.sin_port = htons(port);
+        sendto(fd, payload.data(), payload.size(), 0, (sockaddr*)&addr, sizeof(addr));
+    }
+
+    // Collects payloads from the ring until `expected` arrived or `timeout_ms` passed.
+    std::vector<std::vector<uint8_t>> drain(PacketRing& ring, size_t expected, int timeout_ms) {
+        std::vector<std::vector<uint8_t>> payloads;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (std::chrono::steady_clock::now() < deadline) {
+            while (ring.next_block()) {
+                for (size_t i = 0; i < ring.size(); ++i) {
+                    payloads.emplace_back(ring.data(i), ring.data(i) + ring.length(i));
+                }
+                ring.release_block();
+            }
+            if (payloads.size() > expected) break;
+            pollfd pfd{ring.fd(), POLLIN, 0};
+            poll(&pfd, 1, 10);
+        }
+        return payloads;
+    }
+};
+
+TEST_F(PacketRingTest, ReceivesLoopbackDatagramsOnce) {
+    PacketRing ring;
+    ASSERT_TRUE(ring.open("lo", "127.0.0.1", PORT));
+
+    int client_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    for (uint8_t i = 0; i < 5; ++i) {
+        send_from(client_fd, {0x21, 0x43, i});
+    }
+    send_from(client_fd, {0x99}, PORT + 1);
+    close(client_fd);
+
+    // Wait past the block timeout so a duplicate (outgoing copy) would show up too.
+    auto payloads = drain(ring, 5, 300);
+    ASSERT_EQ(payloads.size(), 5u);
+    for (uint8_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(payloads[i], (std::vector<uint8_t>{0x21, 0x43, i}));
+    }
+}
+
+TEST_F(PacketRingTest, ReportsSenderAddress) {
+    PacketRing ring;
+    ASSERT_TRUE(ring.open("lo", "127.0.0.1", PORT));
+
+    int client_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in client_addr{};
+    client_addr.sin_family = AF_INET;
+    client_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    ASSERT_EQ(bind(client_fd, (sockaddr*)&client_addr, sizeof(client_addr)), 0);
+    socklen_t len = sizeof(client_addr);
+    getsockname(client_fd, (sockaddr*)&client_addr, &len);
+    send_from(client_fd, {0x11});
+    close(client_fd);
+
+    bool found = false;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+    while (!found && std::chrono::steady_clock::now() < deadline) {
+        pollfd pfd{ring.fd(), POLLIN, 0};
+        poll(&pfd, 1, 10);
+        while (ring.next_block()) {
+            for (size_t i = 0; i < ring.size(); ++i) {
+                EXPECT_EQ(ring.address(i).sin_addr.s_addr, client_addr.sin_addr.s_addr);
+                EXPECT_EQ(ring.address(i).sin_port, client_addr.sin_port);
+                found = true;
+            }
+            ring.release_block();
+        }
+    }
+    EXPECT_TRUE(found);
+}
+
+TEST_F(PacketRingTest, FanoutSharesTrafficBetweenRings) {
+    PacketRing first;
+    PacketRing second;
+    ASSERT_TRUE(first.open("lo", "127.0.0.1", PORT));
+    ASSERT_TRUE(second.open("lo", "127.0.0.1", PORT));
+
+    uint16_t group = 0;
+    ASSERT_TRUE(first.join_fanout(group));
+    EXPECT_NE(group, 0);
+    ASSERT_TRUE(second.join_fanout(group));
+
+    // Sixteen flows: every datagram reaches exactly one of the rings. The
+    // payloads carry this process's pid, so traffic other tests or processes
+    // send to PORT on lo is not counted.
+    uint32_t marker = static_cast<uint32_t>(getpid());
+    auto tagged = [&](uint8_t flow) {
+        return std::vector<uint8_t>{0xFA, static_cast<uint8_t>(marker >> 24), static_cast<uint8_t>(marker >> 16),
+                                    static_cast<uint8_t>(marker >> 8), static_cast<uint8_t>(marker), flow};
+    };
+    for (uint8_t i = 0; i < 16; ++i) {
+        int client_fd = socket(AF_INET, SOCK_DGRAM, 0);
+        send_from(client_fd, tagged(i));
+        close(client_fd);
+    }
+
+    std::map<uint8_t, int> seen;
+    size_t received = 0;
+    auto collect = [&](PacketRing& ring) {
+        while (ring.next_block()) {
+            for (size_t i = 0; i < ring.size(); ++i) {
+                std::vector<uint8_t> payload(ring.data(i), ring.data(i) + ring.length(i));
+                if (payload.size() == 6 && payload == tagged(payload[5])) {
+                    ++seen[payload[5]];
+                    ++received;
+                }
+            }
+            ring.release_block();
+        }
+    };
+    // Both rings are drained until every flow arrived, then past the block
+    // timeout once more so a duplicate would show up too.
+    auto poll_rings = [&](std::chrono::steady_clock::time_point deadline, bool until_all) {
+        while (std::chrono::steady_clock::now() < deadline && !(until_all && seen.size() == 16)) {
+            collect(first);
+            collect(second);
+            pollfd pfds[2] = {{first.fd(), POLLIN, 0}, {second.fd(), POLLIN, 0}};
+            poll(pfds, 2, 10);
+        }
+    };
+    poll_rings(std::chrono::steady_clock::now() + std::chrono::seconds(5), true);
+    poll_rings(std::chrono::steady_clock::now() + std::chrono::milliseconds(300), false);
+
+    EXPECT_EQ(seen.size(), 16u);
+    EXPECT_EQ(received, 16u);
+    for (const auto& [flow, count] : seen) {
+        EXPECT_EQ(count, 1) << "flow " << static_cast<int>(flow);
+    }
+}
+
+TEST_F(PacketRingTest, UnknownInterfaceFails) {
+    PacketRing ring;
+    EXPECT_FALSE(ring.open("no-such-if0", "127.0.0.1", PORT));
+    EXPECT_EQ(ring.fd(), -1);
+}
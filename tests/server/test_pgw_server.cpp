@@ -5,14 +5,19 @@
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/eventfd.h>
 #include <netinet/in.h>
 #include <signal.h>
 #include <fcntl.h>
+#include <dirent.h>
+#include <sched.h>
 #include <errno.h>
 #include <thread>
 #include <vector>
 #include <string>
 #include <chrono>
+#include <fstream>
+#include <map>
 
 class PgwServerTest : public ::testing::Test {
 protected:
@@ -42,10 +47,9 @@ TEST_F(PgwServerTest, SetupEpollCreatesEpollFD) {
     int sockfd = server.test_setup_socket();
     ASSERT_GE(sockfd, 0);
 
-    int epoll_fd = server.test_setup_epoll(sockfd);
-    EXPECT_GE(epoll_fd, 0);
+    EpollBackend backend(config.recv_batch_size);
+    EXPECT_TRUE(backend.open(sockfd, -1));
 
-    if (epoll_fd >= 0) close(epoll_fd);
     if (sockfd >= 0) close(sockfd);
 }
 
@@ -107,6 +111,7 @@ TEST_F(PgwServerTest, HandleClient_EmptyImsi) {
     int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
     server.test_handle_client(sockfd, addr, buffer);
     close(sockfd);
+    EXPECT_EQ(server.test_stats().app_dropped(ServerStats::DropReason::Invalid), 1u);
 }
 
 TEST_F(PgwServerTest, SessionCleanerRemovesExpiredSessions) {
@@ -114,8 +119,8 @@ TEST_F(PgwServerTest, SessionCleanerRemovesExpiredSessions) {
     config.session_timeout_sec = 1;
     PgwServer server(config);
 
-    std::string imsi = "9999";
-    server.test_sessions()[imsi] = std::chrono::steady_clock::now() - std::chrono::seconds(5);
+    ImsiKey imsi = pack_imsi("9999");
+    server.test_sessions().insert(imsi, std::chrono::steady_clock::now() - std::chrono::seconds(5));
     server.test_running() = true;
 
     std::thread t([&server]() {
@@ -126,7 +131,7 @@ TEST_F(PgwServerTest, SessionCleanerRemovesExpiredSessions) {
     });
     t.join();
 
-    EXPECT_EQ(server.test_sessions().count(imsi), 0);
+    EXPECT_FALSE(server.test_sessions().active(imsi));
 }
 
 TEST_F(PgwServerTest, SessionCleanerDoesNotRemoveActiveSessions) {
@@ -134,8 +139,8 @@ TEST_F(PgwServerTest, SessionCleanerDoesNotRemoveActiveSessions) {
     config.session_timeout_sec = 10;
     PgwServer server(config);
 
-    std::string imsi = "8888";
-    server.test_sessions()[imsi] = std::chrono::steady_clock::now();
+    ImsiKey imsi = pack_imsi("8888");
+    server.test_sessions().insert(imsi, std::chrono::steady_clock::now());
     server.test_running() = true;
 
     std::thread t([&server]() {
@@ -146,7 +151,7 @@ TEST_F(PgwServerTest, SessionCleanerDoesNotRemoveActiveSessions) {
     });
     t.join();
 
-    EXPECT_EQ(server.test_sessions().count(imsi), 1);
+    EXPECT_TRUE(server.test_sessions().active(imsi));
 }
 
 TEST_F(PgwServerTest, SetupSocketFailsOnInvalidPort) {
@@ -190,7 +195,7 @@ TEST_F(PgwServerTest, HandleClient_InvalidBuffer) {
     server.test_handle_client(sockfd, addr, buffer);
     close(sockfd);
 
-    EXPECT_EQ(server.test_sessions().count("FFFF"), 0);
+    EXPECT_FALSE(server.test_sessions().active("FFFF"));
 }
 
 TEST_F(PgwServerTest, HandleClient_LargeBufferRejectedDueToInvalidImsi) {
@@ -217,10 +222,10 @@ TEST_F(PgwServerTest, SessionCleanerHandlesMultipleSessions) {
     PgwServer server(config);
 
     auto now = std::chrono::steady_clock::now();
-    server.test_sessions()["1111"] = now - std::chrono::seconds(5); 
-    server.test_sessions()["2222"] = now + std::chrono::seconds(1); 
-    server.test_sessions()["3333"] = now - std::chrono::seconds(10);
-    server.test_sessions()["4444"] = now + std::chrono::seconds(1); 
+    server.test_sessions().insert(pack_imsi("1111"), now - std::chrono::seconds(5)); 
+    server.test_sessions().insert(pack_imsi("2222"), now + std::chrono::seconds(1)); 
+    server.test_sessions().insert(pack_imsi("3333"), now - std::chrono::seconds(10));
+    server.test_sessions().insert(pack_imsi("4444"), now + std::chrono::seconds(1)); 
 
     server.test_running() = true;
 
@@ -232,10 +237,10 @@ TEST_F(PgwServerTest, SessionCleanerHandlesMultipleSessions) {
     });
     t.join();
 
-    EXPECT_EQ(server.test_sessions().count("1111"), 0);
-    EXPECT_EQ(server.test_sessions().count("2222"), 1);
-    EXPECT_EQ(server.test_sessions().count("3333"), 0);
-    EXPECT_EQ(server.test_sessions().count("4444"), 1);
+    EXPECT_FALSE(server.test_sessions().active("1111"));
+    EXPECT_TRUE(server.test_sessions().active("2222"));
+    EXPECT_FALSE(server.test_sessions().active("3333"));
+    EXPECT_TRUE(server.test_sessions().active("4444"));
 }
 
 TEST_F(PgwServerTest, SessionCleanerEmptyTable) {
@@ -309,7 +314,7 @@ TEST_F(PgwServerTest, RunHandlesMultipleClients) {
     close(sockfd);
 
     for (const auto& imsi : imsis) {
-        EXPECT_EQ(server.test_sessions().count(imsi), 1) << "Session not created for IMSI " << imsi;
+        EXPECT_TRUE(server.test_sessions().active(imsi)) << "Session not created for IMSI " << imsi;
     }
 }
 
@@ -466,7 +471,7 @@ TEST_F(PgwServerTest, RunHandlesThousandClientsConcurrently) {
     server_thread.join();
 
     for (const auto& imsi : imsis) {
-        EXPECT_EQ(server.test_sessions().count(imsi), 1) << "Session not created for IMSI " << imsi;
+        EXPECT_TRUE(server.test_sessions().active(imsi)) << "Session not created for IMSI " << imsi;
     }
 }
 
@@ -493,9 +498,8 @@ TEST_F(PgwServerTest, SocketCreationFails) {
 }
 
 TEST_F(PgwServerTest, SetupEpollFailsOnBadFD) {
-    PgwServer server(config);
-    int epoll_fd = server.test_setup_epoll(-1);
-    EXPECT_EQ(epoll_fd, -1);  // эполл упадёт
+    EpollBackend backend(config.recv_batch_size);
+    EXPECT_FALSE(backend.open(-1, -1));  // эполл упадёт
 }
 
 TEST_F(PgwServerTest, RunHandlesEpollWaitFatalError) {
@@ -538,8 +542,8 @@ TEST_F(PgwServerTest, SetupEpollFailsAfterSockClose) {
     ASSERT_GE(sockfd, 0);
     close(sockfd); 
 
-    int epoll_fd = server.test_setup_epoll(sockfd); 
-    EXPECT_EQ(epoll_fd, -1);
+    EpollBackend backend(config.recv_batch_size);
+    EXPECT_FALSE(backend.open(sockfd, -1));
 }
 
 TEST_F(PgwServerTest, HandleClient_BlacklistedImsi_RespondsRejected) {
@@ -603,10 +607,1288 @@ TEST_F(PgwServerTest, HandleClient_BlacklistedImsi_RespondsRejected) {
     server_thread.join();
 }
 
+TEST_F(PgwServerTest, RunBatchReceiveCountsEveryDatagram) {
+    config.blacklist.clear();
+    config.recv_batch_size = 8;
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    auto encode_imsi_bcd = [](const std::string& imsi) -> std::vector<uint8_t> {
+        std::vector<uint8_t> bcd;
+        for (size_t i = 0; i < imsi.size(); i += 2) {
+            uint8_t low = imsi[i] - '0';
+            uint8_t high = (i + 1 < imsi.size()) ? (imsi[i + 1] - '0') : 0xF;
+            bcd.push_back((high << 4) | low);
+        }
+        return bcd;
+    };
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sockfd, 0);
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    std::vector<std::string> imsis;
+    for (int i = 0; i < 100; ++i) {
+        imsis.push_back(std::to_string(200000000000000 + i));
+        std::vector<uint8_t> bcd = encode_imsi_bcd(imsis.back());
+        sendto(sockfd, bcd.data(), bcd.size(), 0,
+               (sockaddr*)&server_addr, sizeof(server_addr));
+    }
+    close(sockfd);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto stats = cli.Get("/stats");
+    ASSERT_TRUE(stats && stats->status == 200);
+    EXPECT_NE(stats->body.find("rx_datagrams 100\n"), std::string::npos);
+
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+
+    server.test_running() = false;
+    server_thread.join();
+
+    EXPECT_EQ(server.test_stats().rx_datagrams(), 100u);
+    EXPECT_GE(server.test_stats().rx_batches(), 100u / 8);
+    EXPECT_LE(server.test_stats().rx_batches(), 100u);
+    for (const auto& imsi : imsis) {
+        EXPECT_TRUE(server.test_sessions().active(imsi)) << "Session not created for IMSI " << imsi;
+    }
+}
+
+TEST_F(PgwServerTest, RunSingleDatagramReceiveMode) {
+    config.blacklist.clear();
+    config.recv_batch_size = 1;
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::vector<uint8_t> bcd = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF5};
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sockfd, 0);
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    for (int i = 0; i < 3; ++i) {
+        sendto(sockfd, bcd.data(), bcd.size(), 0,
+               (sockaddr*)&server_addr, sizeof(server_addr));
+    }
+    close(sockfd);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+
+    server.test_running() = false;
+    server_thread.join();
+
+    EXPECT_EQ(server.test_stats().rx_datagrams(), 3u);
+    EXPECT_EQ(server.test_stats().rx_batches(), 3u);
+    EXPECT_EQ(server.test_stats().rx_batch_fill(ServerStats::FILL_BUCKETS - 1), 3u);
+    EXPECT_TRUE(server.test_sessions().active("123456789012345"));
+}
+
+TEST_F(PgwServerTest, RunBatchSizeFlushAnswersEveryRequest) {
+    config.blacklist = {"123456789012345"};
+    config.send_flush = "batch_size";
+    config.send_batch_size = 4;
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    auto encode_imsi_bcd = [](const std::string& imsi) -> std::vector<uint8_t> {
+        std::vector<uint8_t> bcd;
+        for (size_t i = 0; i < imsi.size(); i += 2) {
+            uint8_t low = imsi[i] - '0';
+            uint8_t high = (i + 1 < imsi.size()) ? (imsi[i + 1] - '0') : 0xF;
+            bcd.push_back((high << 4) | low);
+        }
+        return bcd;
+    };
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sockfd, 0);
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    std::vector<std::string> imsis = {"123456789012345"};
+    for (int i = 0; i < 9; ++i) {
+        imsis.push_back(std::to_string(300000000000000 + i));
+    }
+    for (const auto& imsi : imsis) {
+        std::vector<uint8_t> bcd = encode_imsi_bcd(imsi);
+        sendto(sockfd, bcd.data(), bcd.size(), 0,
+               (sockaddr*)&server_addr, sizeof(server_addr));
+    }
+
+    struct timeval timeout{};
+    timeout.tv_sec = 1;
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    int created = 0;
+    int rejected = 0;
+    for (size_t i = 0; i < imsis.size(); ++i) {
+        char response[16];
+        ssize_t n = recv(sockfd, response, sizeof(response), 0);
+        ASSERT_GT(n, 0) << "Missing response " << i;
+        std::string text(response, n);
+        if (text == "created") ++created;
+        if (text == "rejected") ++rejected;
+    }
+    close(sockfd);
+
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+
+    server.test_running() = false;
+    server_thread.join();
+
+    EXPECT_EQ(created, 9);
+    EXPECT_EQ(rejected, 1);
+    EXPECT_EQ(server.test_stats().tx_datagrams(), 10u);
+    EXPECT_GE(server.test_stats().tx_batches(), 3u);
+}
+
+TEST_F(PgwServerTest, SetupSocketSharesPortAcrossReactors) {
+    config.reactor_count = 2;
+    PgwServer server(config);
+    int first = server.test_setup_socket();
+    int second = server.test_setup_socket();
+    EXPECT_GE(first, 0);
+    EXPECT_GE(second, 0);
+    if (first >= 0) close(first);
+    if (second >= 0) close(second);
+}
+
+TEST_F(PgwServerTest, RunMultipleReactorsSpreadsFlows) {
+    config.blacklist.clear();
+    config.reactor_count = 4;
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    auto encode_imsi_bcd = [](const std::string& imsi) -> std::vector<uint8_t> {
+        std::vector<uint8_t> bcd;
+        for (size_t i = 0; i < imsi.size(); i += 2) {
+            uint8_t low = imsi[i] - '0';
+            uint8_t high = (i + 1 < imsi.size()) ? (imsi[i + 1] - '0') : 0xF;
+            bcd.push_back((high << 4) | low);
+        }
+        return bcd;
+    };
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    // Every client socket gets its own source port, i.e. its own flow.
+    std::vector<std::string> imsis;
+    for (int i = 0; i < 32; ++i) {
+        int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_GE(sockfd, 0);
+        imsis.push_back(std::to_string(400000000000000 + i));
+        std::vector<uint8_t> bcd = encode_imsi_bcd(imsis.back());
+        sendto(sockfd, bcd.data(), bcd.size(), 0,
+               (sockaddr*)&server_addr, sizeof(server_addr));
+        close(sockfd);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+
+    server.test_running() = false;
+    server_thread.join();
+
+    size_t active_reactors = 0;
+    uint64_t total = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        if (server.test_stats().reactor_rx(i) > 0) ++active_reactors;
+        total += server.test_stats().reactor_rx(i);
+    }
+    EXPECT_EQ(total, 32u);
+    EXPECT_GT(active_reactors, 1u);
+    for (const auto& imsi : imsis) {
+        EXPECT_TRUE(server.test_sessions().active(imsi)) << "Session not created for IMSI " << imsi;
+    }
+}
+
+TEST_F(PgwServerTest, RunImsiSteeringPinsSubscriberToOneReactor) {
+    config.blacklist.clear();
+    config.reactor_count = 4;
+    config.reactor_steering = "imsi";
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::vector<uint8_t> bcd = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF5};
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    for (int i = 0; i < 16; ++i) {
+        int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_GE(sockfd, 0);
+        sendto(sockfd, bcd.data(), bcd.size(), 0,
+               (sockaddr*)&server_addr, sizeof(server_addr));
+        close(sockfd);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+
+    server.test_running() = false;
+    server_thread.join();
+
+    uint32_t owner = imsi_steering_index(bcd.data(), bcd.size(), 4);
+    for (size_t i = 0; i < 4; ++i) {
+        EXPECT_EQ(server.test_stats().reactor_rx(i), i == owner ? 16u : 0u) << "reactor " << i;
+    }
+    EXPECT_TRUE(server.test_sessions().active("123456789012345"));
+}
+
+TEST_F(PgwServerTest, RunSocketFilterDropsMalformedDatagramsInKernel) {
+    config.blacklist.clear();
+    config.socket_filter = true;
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sockfd, 0);
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    std::vector<std::vector<uint8_t>> junk = {
+        {0xFF, 0xFF},
+        {0x21, 0x43},
+        std::vector<uint8_t>(64, 0x12),
+        {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0x65},
+        {0x21, 0x43, 0x6A, 0x87, 0x09, 0x21, 0x43, 0xF5},
+    };
+    for (const auto& payload : junk) {
+        sendto(sockfd, payload.data(), payload.size(), 0,
+               (sockaddr*)&server_addr, sizeof(server_addr));
+    }
+    std::vector<uint8_t> valid = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF5};
+    sendto(sockfd, valid.data(), valid.size(), 0,
+           (sockaddr*)&server_addr, sizeof(server_addr));
+    close(sockfd);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    server.test_sample_kernel_counters();
+    // Nothing overflowed here, so every socket drop is a filter rejection.
+    EXPECT_EQ(server.test_stats().socket_drops(), junk.size());
+    // And /stats says that kernel_rx_dropped counts them too.
+    EXPECT_TRUE(server.test_stats().socket_filter());
 
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
 
+    server.test_running() = false;
+    server_thread.join();
 
+    EXPECT_EQ(server.test_stats().rx_datagrams(), 1u);
+    EXPECT_EQ(server.test_sessions().size(), 1u);
+    EXPECT_TRUE(server.test_sessions().active("123456789012345"));
+}
 
+TEST_F(PgwServerTest, RunIoUringBackendAnswersEveryRequest) {
+    config.blacklist = {"123456789012345"};
+    config.io_backend = "io_uring";
+    config.reactor_count = 2;
+    PgwServer server(config);
 
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
 
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
 
+    auto encode_imsi_bcd = [](const std::string& imsi) -> std::vector<uint8_t> {
+        std::vector<uint8_t> bcd;
+        for (size_t i = 0; i < imsi.size(); i += 2) {
+            uint8_t low = imsi[i] - '0';
+            uint8_t high = (i + 1 < imsi.size()) ? (imsi[i + 1] - '0') : 0xF;
+            bcd.push_back((high << 4) | low);
+        }
+        return bcd;
+    };
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sockfd, 0);
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    std::vector<std::string> imsis = {"123456789012345"};
+    for (int i = 0; i < 19; ++i) {
+        imsis.push_back(std::to_string(400000000000000 + i));
+    }
+    for (const auto& imsi : imsis) {
+        std::vector<uint8_t> bcd = encode_imsi_bcd(imsi);
+        sendto(sockfd, bcd.data(), bcd.size(), 0,
+               (sockaddr*)&server_addr, sizeof(server_addr));
+    }
+
+    struct timeval timeout{};
+    timeout.tv_sec = 1;
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    int created = 0;
+    int rejected = 0;
+    for (size_t i = 0; i < imsis.size(); ++i) {
+        char response[16];
+        ssize_t n = recv(sockfd, response, sizeof(response), 0);
+        ASSERT_GT(n, 0) << "Missing response " << i;
+        std::string text(response, n);
+        if (text == "created") ++created;
+        if (text == "rejected") ++rejected;
+    }
+    close(sockfd);
+
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+
+    server.test_running() = false;
+    server_thread.join();
+
+    // Without io_uring support the reactors fall back to epoll and the answers are the same.
+    EXPECT_EQ(created, 19);
+    EXPECT_EQ(rejected, 1);
+    EXPECT_EQ(server.test_stats().rx_datagrams(), 20u);
+    EXPECT_EQ(server.test_stats().tx_datagrams(), 20u);
+    EXPECT_EQ(server.test_sessions().size(), 19u);
+}
+
+TEST_F(PgwServerTest, RunPacketMmapBackendAnswersEveryRequest) {
+    config.blacklist = {"123456789012345"};
+    config.io_backend = "packet_mmap";
+    config.packet_interface = "lo";
+    config.reactor_count = 2;
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    auto encode_imsi_bcd = [](const std::string& imsi) -> std::vector<uint8_t> {
+        std::vector<uint8_t> bcd;
+        for (size_t i = 0; i < imsi.size(); i += 2) {
+            uint8_t low = imsi[i] - '0';
+            uint8_t high = (i + 1 < imsi.size()) ? (imsi[i + 1] - '0') : 0xF;
+            bcd.push_back((high << 4) | low);
+        }
+        return bcd;
+    };
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sockfd, 0);
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    std::vector<std::string> imsis = {"123456789012345"};
+    for (int i = 0; i < 19; ++i) {
+        imsis.push_back(std::to_string(500000000000000 + i));
+    }
+    for (const auto& imsi : imsis) {
+        std::vector<uint8_t> bcd = encode_imsi_bcd(imsi);
+        sendto(sockfd, bcd.data(), bcd.size(), 0,
+               (sockaddr*)&server_addr, sizeof(server_addr));
+    }
+
+    struct timeval timeout{};
+    timeout.tv_sec = 1;
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    int created = 0;
+    int rejected = 0;
+    for (size_t i = 0; i < imsis.size(); ++i) {
+        char response[16];
+        ssize_t n = recv(sockfd, response, sizeof(response), 0);
+        ASSERT_GT(n, 0) << "Missing response " << i;
+        std::string text(response, n);
+        if (text == "created") ++created;
+        if (text == "rejected") ++rejected;
+    }
+    close(sockfd);
+
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+
+    server.test_running() = false;
+    server_thread.join();
+
+    // Without CAP_NET_RAW the reactors fall back to epoll and the answers are the same.
+    EXPECT_EQ(created, 19);
+    EXPECT_EQ(rejected, 1);
+    EXPECT_EQ(server.test_stats().rx_datagrams(), 20u);
+    EXPECT_EQ(server.test_stats().tx_datagrams(), 20u);
+    EXPECT_EQ(server.test_sessions().size(), 19u);
+}
+
+TEST_F(PgwServerTest, RunToCompletionAnswersInlineAndHandsCdrsToWorkers) {
+    config.blacklist = {"123456789012345"};
+    config.dispatch_mode = "run_to_completion";
+    config.reactor_count = 2;
+    config.cdr_file = "test_rtc_cdr.log";
+    std::remove(config.cdr_file.c_str());
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    auto encode_imsi_bcd = [](const std::string& imsi) -> std::vector<uint8_t> {
+        std::vector<uint8_t> bcd;
+        for (size_t i = 0; i < imsi.size(); i += 2) {
+            uint8_t low = imsi[i] - '0';
+            uint8_t high = (i + 1 < imsi.size()) ? (imsi[i + 1] - '0') : 0xF;
+            bcd.push_back((high << 4) | low);
+        }
+        return bcd;
+    };
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sockfd, 0);
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    std::vector<std::string> imsis = {"123456789012345"};
+    for (int i = 0; i < 19; ++i) {
+        imsis.push_back(std::to_string(600000000000000 + i));
+    }
+    for (const auto& imsi : imsis) {
+        std::vector<uint8_t> bcd = encode_imsi_bcd(imsi);
+        sendto(sockfd, bcd.data(), bcd.size(), 0,
+               (sockaddr*)&server_addr, sizeof(server_addr));
+    }
+
+    struct timeval timeout{};
+    timeout.tv_sec = 1;
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    int created = 0;
+    int rejected = 0;
+    for (size_t i = 0; i < imsis.size(); ++i) {
+        char response[16];
+        ssize_t n = recv(sockfd, response, sizeof(response), 0);
+        ASSERT_GT(n, 0) << "Missing response " << i;
+        std::string text(response, n);
+        if (text == "created") ++created;
+        if (text == "rejected") ++rejected;
+    }
+    close(sockfd);
+
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+
+    server.test_running() = false;
+    server_thread.join();
+
+    EXPECT_EQ(created, 19);
+    EXPECT_EQ(rejected, 1);
+    EXPECT_EQ(server.test_stats().rx_datagrams(), 20u);
+    EXPECT_EQ(server.test_stats().tx_datagrams(), 20u);
+    EXPECT_EQ(server.test_sessions().size(), 19u);
+
+    // The workers wrote every deferred CDR before the pool stopped.
+    std::ifstream cdr(config.cdr_file);
+    std::string line;
+    int create_records = 0;
+    while (std::getline(cdr, line)) {
+        if (line.find(", create") != std::string::npos) ++create_records;
+    }
+    EXPECT_EQ(create_records, 19);
+    std::remove(config.cdr_file.c_str());
+}
+
+TEST_F(PgwServerTest, SetupSocketAppliesBufferSizesAndDropReporting) {
+    config.socket_rcvbuf = 65536;
+    config.socket_sndbuf = 32768;
+    PgwServer server(config);
+    int sockfd = server.test_setup_socket();
+    ASSERT_GE(sockfd, 0);
+
+    // The kernel reports twice the requested size.
+    int value = 0;
+    socklen_t len = sizeof(value);
+    getsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &value, &len);
+    EXPECT_GE(value, 65536);
+    getsockopt(sockfd, SOL_SOCKET, SO_SNDBUF, &value, &len);
+    EXPECT_GE(value, 32768);
+    getsockopt(sockfd, SOL_SOCKET, SO_RXQ_OVFL, &value, &len);
+    EXPECT_EQ(value, 1);
+    close(sockfd);
+}
+
+namespace {
+// Stands in for an io_uring backend whose receive fails as soon as it starts.
+class FailingBackend : public IngressBackend {
+public:
+    const char* name() const override { return "failing"; }
+    bool open(int, int) override { return true; }
+    bool serve(IngressSink&) override { return false; }
+};
+}
+
+TEST_F(PgwServerTest, KernelDropsFollowTheEpollFallback) {
+    config.blacklist.clear();
+    // A receive buffer of a few datagrams, so a burst overflows it.
+    config.socket_rcvbuf = 4096;
+    PgwServer server(config);
+    int event_fd = eventfd(0, EFD_NONBLOCK);
+    ASSERT_GE(event_fd, 0);
+    ASSERT_TRUE(server.open_reactors(event_fd));
+    PgwServer::Reactor& reactor = *server.reactors_[0];
+    reactor.ingress = std::make_unique<FailingBackend>();
+    server.start_thread_pool(1);
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sockfd, 0);
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+    std::vector<uint8_t> bcd = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF5};
+    auto send_burst = [&](int count) {
+        for (int i = 0; i < count; ++i) {
+            sendto(sockfd, bcd.data(), bcd.size(), 0, (sockaddr*)&server_addr, sizeof(server_addr));
+        }
+    };
+    // Received from the socket, drops included, once the counters are sampled.
+    auto sample_after = [&](uint64_t received) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (server.stats_.rx_datagrams() <= received && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        server.sample_kernel_counters();
+        return server.stats_.kernel_rx_dropped();
+    };
+
+    // Nothing reads yet: most of the burst is dropped, the epoll fallback
+    // reads the rest. Only a datagram queued after the drops carries their count.
+    send_burst(200);
+    std::thread reactor_thread(&PgwServer::reactor_loop, &server, std::ref(reactor), event_fd);
+    sample_after(0);
+    uint64_t received = server.stats_.rx_datagrams();
+    send_burst(1);
+    uint64_t first = sample_after(received);
+    EXPECT_GT(first, 0u);
+
+    // Later drops are seen through the fallback as well.
+    uint64_t later = first;
+    for (int round = 0; round < 50 && later == first; ++round) {
+        received = server.stats_.rx_datagrams();
+        send_burst(2000);
+        later = sample_after(received);
+    }
+    EXPECT_GT(later, first);
+    close(sockfd);
+
+    uint64_t signal = 1;
+    ASSERT_EQ(write(event_fd, &signal, sizeof(signal)), sizeof(signal));
+    reactor_thread.join();
+    server.stop_thread_pool();
+    server.close_reactors();
+    close(event_fd);
+    std::remove(config.cdr_file.c_str());
+}
+
+TEST_F(PgwServerTest, RunSpinThenParkAnswersEveryRequest) {
+    config.blacklist.clear();
+    config.spin_budget_us = 200;
+    config.busy_poll_us = 50;
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sockfd, 0);
+    struct timeval timeout{};
+    timeout.tv_sec = 1;
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    // One request at a time, so the workers go idle between them.
+    std::vector<uint8_t> bcd = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF5};
+    int answered = 0;
+    for (int i = 0; i < 20; ++i) {
+        sendto(sockfd, bcd.data(), bcd.size(), 0,
+               (sockaddr*)&server_addr, sizeof(server_addr));
+        char response[16];
+        if (recv(sockfd, response, sizeof(response), 0) > 0) ++answered;
+    }
+    close(sockfd);
+
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+
+    server.test_running() = false;
+    server_thread.join();
+
+    EXPECT_EQ(answered, 20);
+    EXPECT_EQ(server.test_stats().rx_datagrams(), 20u);
+    EXPECT_GT(server.test_stats().worker_spin_ns(), 0u);
+    EXPECT_GT(server.test_stats().worker_parks(), 0u);
+}
+
+TEST_F(PgwServerTest, RunRateLimitDropsFloodFromOneSource) {
+    config.blacklist.clear();
+    config.rate_limit_ip_rate = 1;
+    config.rate_limit_ip_burst = 5;
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sockfd, 0);
+    struct timeval timeout{};
+    timeout.tv_usec = 300000;
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    std::vector<uint8_t> bcd = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF5};
+    for (int i = 0; i < 20; ++i) {
+        sendto(sockfd, bcd.data(), bcd.size(), 0,
+               (sockaddr*)&server_addr, sizeof(server_addr));
+    }
+    int answered = 0;
+    char response[16];
+    while (recv(sockfd, response, sizeof(response), 0) > 0) ++answered;
+    close(sockfd);
+
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+
+    server.test_running() = false;
+    server_thread.join();
+
+    // The burst passes, the rest of the flood is dropped before the queue.
+    EXPECT_EQ(answered, 5);
+    EXPECT_EQ(server.test_stats().rx_datagrams(), 20u);
+    EXPECT_EQ(server.test_stats().app_dropped(ServerStats::DropReason::RateLimitedIp), 15u);
+    EXPECT_NE(server.test_stats().render().find("app_dropped{reason=\"rate_limited_ip\"} 15\n"), std::string::npos);
+}
+
+TEST_F(PgwServerTest, RunFullQueueShedsDatagramsItCannotHold) {
+    config.blacklist.clear();
+    config.queue_capacity = 2;
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sockfd, 0);
+    struct timeval timeout{};
+    timeout.tv_usec = 300000;
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    // Sent back to back, so recvmmsg hands the reactor more than one at a time.
+    std::vector<uint8_t> bcd = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF5};
+    for (int i = 0; i < 200; ++i) {
+        sendto(sockfd, bcd.data(), bcd.size(), 0,
+               (sockaddr*)&server_addr, sizeof(server_addr));
+    }
+    uint64_t answered = 0;
+    char response[16];
+    while (recv(sockfd, response, sizeof(response), 0) > 0) ++answered;
+    close(sockfd);
+
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+
+    server.test_running() = false;
+    server_thread.join();
+
+    const ServerStats& stats = server.test_stats();
+    uint64_t shed = stats.app_dropped(ServerStats::DropReason::QueueFull);
+    EXPECT_GT(shed, 0u);
+    EXPECT_EQ(answered + shed, stats.rx_datagrams());
+    EXPECT_LE(stats.queue_depth(0), 2u);
+}
+
+TEST_F(PgwServerTest, RunImsiAffinityKeepsSessionsWithOwningWorkers) {
+    config.blacklist = {"123456789012345"};
+    config.dispatch_mode = "imsi_affinity";
+    config.reactor_count = 2;
+    config.cdr_file = "test_affinity_cdr.log";
+    std::remove(config.cdr_file.c_str());
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    auto encode_imsi_bcd = [](const std::string& imsi) -> std::vector<uint8_t> {
+        std::vector<uint8_t> bcd;
+        for (size_t i = 0; i < imsi.size(); i += 2) {
+            uint8_t low = imsi[i] - '0';
+            uint8_t high = (i + 1 < imsi.size()) ? (imsi[i + 1] - '0') : 0xF;
+            bcd.push_back((high << 4) | low);
+        }
+        return bcd;
+    };
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sockfd, 0);
+    struct timeval timeout{};
+    timeout.tv_sec = 1;
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    // Every subscriber sends three times: only the first opens a session.
+    std::vector<std::string> imsis = {"123456789012345"};
+    for (int i = 0; i < 19; ++i) {
+        imsis.push_back(std::to_string(600000000000000 + i));
+    }
+    int created = 0;
+    int rejected = 0;
+    for (int round = 0; round < 3; ++round) {
+        for (const auto& imsi : imsis) {
+            std::vector<uint8_t> bcd = encode_imsi_bcd(imsi);
+            sendto(sockfd, bcd.data(), bcd.size(), 0,
+                   (sockaddr*)&server_addr, sizeof(server_addr));
+        }
+        for (size_t i = 0; i < imsis.size(); ++i) {
+            char response[16];
+            ssize_t n = recv(sockfd, response, sizeof(response), 0);
+            ASSERT_GT(n, 0) << "Missing response " << i << " in round " << round;
+            std::string text(response, n);
+            if (text == "created") ++created;
+            if (text == "rejected") ++rejected;
+        }
+    }
+    close(sockfd);
+
+    // The HTTP thread asks the owning workers.
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto active = cli.Get("/check_subscriber?imsi=600000000000007");
+    auto inactive = cli.Get("/check_subscriber?imsi=600000000000099");
+    ASSERT_TRUE(active && inactive);
+    EXPECT_EQ(active->body, "active\n");
+    EXPECT_EQ(inactive->body, "not active\n");
+
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+
+    server.test_running() = false;
+    server_thread.join();
+
+    EXPECT_EQ(created, 57);
+    EXPECT_EQ(rejected, 3);
+    EXPECT_EQ(server.test_partition_sessions(), 19u);
+    EXPECT_TRUE(server.test_sessions().empty());
+
+    // Every partition reports its own backlog, drained by now; the reactors report none.
+    const ServerStats& stats = server.test_stats();
+    ASSERT_GT(stats.partitions(), 0u);
+    for (size_t i = 0; i < stats.partitions(); ++i) {
+        EXPECT_EQ(stats.partition_depth(i), 0u);
+    }
+    EXPECT_EQ(stats.queue_depth(0), 0u);
+    EXPECT_EQ(stats.queue_depth(1), 0u);
+
+    std::ifstream cdr(config.cdr_file);
+    std::string line;
+    int create_records = 0;
+    while (std::getline(cdr, line)) {
+        if (line.find(", create") != std::string::npos) ++create_records;
+    }
+    EXPECT_EQ(create_records, 19);
+    std::remove(config.cdr_file.c_str());
+}
+
+TEST_F(PgwServerTest, RunImsiAffinityWorkersExpireTheirOwnSessions) {
+    config.blacklist.clear();
+    config.dispatch_mode = "imsi_affinity";
+    config.session_timeout_sec = 0;
+    config.cdr_file = "test_affinity_expiry_cdr.log";
+    std::remove(config.cdr_file.c_str());
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sockfd, 0);
+    struct timeval timeout{};
+    timeout.tv_sec = 1;
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    std::vector<uint8_t> bcd = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF5};
+    sendto(sockfd, bcd.data(), bcd.size(), 0,
+           (sockaddr*)&server_addr, sizeof(server_addr));
+    char response[16];
+    ASSERT_GT(recv(sockfd, response, sizeof(response), 0), 0);
+    close(sockfd);
+
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto before = cli.Get("/check_subscriber?imsi=123456789012345");
+    ASSERT_TRUE(before);
+    EXPECT_EQ(before->body, "active\n");
+
+    // The session is older than 0 s after one second; the cleaner runs once a second.
+    std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+    auto after = cli.Get("/check_subscriber?imsi=123456789012345");
+    ASSERT_TRUE(after);
+    EXPECT_EQ(after->body, "not active\n");
+
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+
+    server.test_running() = false;
+    server_thread.join();
+
+    EXPECT_EQ(server.test_partition_sessions(), 0u);
+    std::ifstream cdr(config.cdr_file);
+    std::string line;
+    int timeout_records = 0;
+    while (std::getline(cdr, line)) {
+        if (line.find(", timeout") != std::string::npos) ++timeout_records;
+    }
+    EXPECT_EQ(timeout_records, 1);
+    std::remove(config.cdr_file.c_str());
+}
+
+TEST_F(PgwServerTest, RunNamesAndPinsThreadsPerRole) {
+    cpu_set_t available;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(available), &available), 0);
+    int cpu = 0;
+    while (!CPU_ISSET(cpu, &available)) ++cpu;
+    config.worker_count = 2;
+    config.reactor_cpus = {cpu};
+    config.worker_cpus = {cpu};
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    // Thread name -> CPUs it may run on, as the kernel reports them.
+    std::map<std::string, std::string> threads;
+    DIR* tasks = opendir("/proc/self/task");
+    ASSERT_NE(tasks, nullptr);
+    while (dirent* entry = readdir(tasks)) {
+        if (entry->d_name[0] == '.') continue;
+        std::string dir = std::string("/proc/self/task/") + entry->d_name;
+        std::string name;
+        std::getline(std::ifstream(dir + "/comm"), name);
+        std::ifstream status(dir + "/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("Cpus_allowed_list:", 0) == 0) {
+                threads[name] = line.substr(line.find_first_not_of(" \t", sizeof("Cpus_allowed_list:") - 1));
+            }
+        }
+    }
+    closedir(tasks);
+
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+    server.test_running() = false;
+    server_thread.join();
+
+    std::string pinned = std::to_string(cpu);
+    ASSERT_TRUE(threads.count("pgw-reactor-0"));
+    EXPECT_EQ(threads["pgw-reactor-0"], pinned);
+    ASSERT_TRUE(threads.count("pgw-worker-0"));
+    EXPECT_EQ(threads["pgw-worker-0"], pinned);
+    ASSERT_TRUE(threads.count("pgw-worker-1"));
+    EXPECT_EQ(threads["pgw-worker-1"], pinned);
+    EXPECT_FALSE(threads.count("pgw-worker-2"));
+    EXPECT_TRUE(threads.count("pgw-cleaner"));
+    EXPECT_TRUE(threads.count("pgw-http"));
+}
+
+TEST_F(PgwServerTest, RunBatchedWorkersOpenEachSessionOnce) {
+    config.blacklist = {"123456789012345"};
+    config.worker_count = 2;
+    config.worker_batch_size = 8;
+    config.cdr_file = "test_batched_cdr.log";
+    std::remove(config.cdr_file.c_str());
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    auto encode_imsi_bcd = [](const std::string& imsi) -> std::vector<uint8_t> {
+        std::vector<uint8_t> bcd;
+        for (size_t i = 0; i < imsi.size(); i += 2) {
+            uint8_t low = imsi[i] - '0';
+            uint8_t high = (i + 1 < imsi.size()) ? (imsi[i + 1] - '0') : 0xF;
+            bcd.push_back((high << 4) | low);
+        }
+        return bcd;
+    };
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sockfd, 0);
+    struct timeval timeout{};
+    timeout.tv_sec = 1;
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    // Each IMSI is sent twice in a row, so both copies mostly land in one batch.
+    std::vector<std::string> imsis = {"123456789012345"};
+    for (int i = 0; i < 39; ++i) {
+        imsis.push_back(std::to_string(700000000000000 + i));
+    }
+    for (const auto& imsi : imsis) {
+        std::vector<uint8_t> bcd = encode_imsi_bcd(imsi);
+        for (int copy = 0; copy < 2; ++copy) {
+            sendto(sockfd, bcd.data(), bcd.size(), 0,
+                   (sockaddr*)&server_addr, sizeof(server_addr));
+        }
+    }
+    int created = 0;
+    int rejected = 0;
+    for (size_t i = 0; i < imsis.size() * 2; ++i) {
+        char response[16];
+        ssize_t n = recv(sockfd, response, sizeof(response), 0);
+        ASSERT_GT(n, 0) << "Missing response " << i;
+        std::string text(response, n);
+        if (text == "created") ++created;
+        if (text == "rejected") ++rejected;
+    }
+    close(sockfd);
+
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+
+    server.test_running() = false;
+    server_thread.join();
+
+    EXPECT_EQ(created, 78);
+    EXPECT_EQ(rejected, 2);
+    EXPECT_EQ(server.test_sessions().size(), 39u);
+
+    std::ifstream cdr(config.cdr_file);
+    std::string line;
+    int create_records = 0;
+    while (std::getline(cdr, line)) {
+        if (line.find(", create") != std::string::npos) ++create_records;
+    }
+    EXPECT_EQ(create_records, 39);
+    std::remove(config.cdr_file.c_str());
+}
+
+TEST_F(PgwServerTest, RunElasticPoolGrowsUnderLoadAndShrinksWhenIdle) {
+    config.worker_count = 2;
+    config.elastic_workers = true;
+    config.elastic_min_workers = 1;
+    // Any time in queue counts as hot, any idle second as calm.
+    config.elastic_grow_sojourn_us = 1;
+    config.elastic_shrink_sojourn_us = 0;
+    config.elastic_shrink_after_sec = 1;
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_EQ(server.test_stats().active_workers(0), 1u);
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sockfd, 0);
+    struct timeval timeout{};
+    timeout.tv_sec = 1;
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    // The session cleaner samples the queue once a second; every round must be answered.
+    std::vector<uint8_t> imsi = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF5};
+    auto send_round = [&]() {
+        for (int i = 0; i < 20; ++i) {
+            sendto(sockfd, imsi.data(), imsi.size(), 0, (sockaddr*)&server_addr, sizeof(server_addr));
+        }
+        for (int i = 0; i < 20; ++i) {
+            char response[16];
+            ASSERT_GT(recv(sockfd, response, sizeof(response), 0), 0) << "Missing response " << i;
+        }
+    };
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (server.test_stats().active_workers(0) < 2 && std::chrono::steady_clock::now() < deadline) {
+        send_round();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    EXPECT_EQ(server.test_stats().active_workers(0), 2u);
+
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (server.test_stats().active_workers(0) > 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    EXPECT_EQ(server.test_stats().active_workers(0), 1u);
+    // The worker left with nothing queued, and the one still running answers everything.
+    send_round();
+    close(sockfd);
+
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+    server.test_running() = false;
+    server_thread.join();
+}
+
+TEST_F(PgwServerTest, RunCoroutinesAnswerOnceTheCdrIsWritten) {
+    config.blacklist = {"123456789012345"};
+    config.dispatch_mode = "coroutine";
+    config.reactor_count = 2;
+    config.cdr_file = "test_coroutine_cdr.log";
+    std::remove(config.cdr_file.c_str());
+    PgwServer server(config);
+
+    server.test_running() = true;
+    std::thread server_thread([&server]() {
+        server.run();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    auto encode_imsi_bcd = [](const std::string& imsi) -> std::vector<uint8_t> {
+        std::vector<uint8_t> bcd;
+        for (size_t i = 0; i < imsi.size(); i += 2) {
+            uint8_t low = imsi[i] - '0';
+            uint8_t high = (i + 1 < imsi.size()) ? (imsi[i + 1] - '0') : 0xF;
+            bcd.push_back((high << 4) | low);
+        }
+        return bcd;
+    };
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sockfd, 0);
+    struct timeval timeout{};
+    timeout.tv_sec = 1;
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(config.udp_port);
+    server_addr.sin_addr.s_addr = inet_addr(config.udp_ip.c_str());
+
+    std::vector<std::string> imsis = {"123456789012345"};
+    for (int i = 0; i < 19; ++i) {
+        imsis.push_back(std::to_string(500000000000000 + i));
+    }
+    for (const auto& imsi : imsis) {
+        std::vector<uint8_t> bcd = encode_imsi_bcd(imsi);
+        sendto(sockfd, bcd.data(), bcd.size(), 0,
+               (sockaddr*)&server_addr, sizeof(server_addr));
+    }
+
+    int created = 0;
+    int rejected = 0;
+    for (size_t i = 0; i < imsis.size(); ++i) {
+        char response[16];
+        ssize_t n = recv(sockfd, response, sizeof(response), 0);
+        ASSERT_GT(n, 0) << "Missing response " << i;
+        std::string text(response, n);
+        if (text == "created") ++created;
+        if (text == "rejected") ++rejected;
+    }
+    close(sockfd);
+
+    // Every client was answered after its record reached the file, so all of them are there already.
+    auto count_creates = [this]() {
+        std::ifstream cdr(config.cdr_file);
+        std::string line;
+        int create_records = 0;
+        while (std::getline(cdr, line)) {
+            if (line.find(", create") != std::string::npos) ++create_records;
+        }
+        return create_records;
+    };
+    EXPECT_EQ(count_creates(), 19);
+
+    httplib::Client cli("http://127.0.0.1:8080");
+    auto res = cli.Post("/stop");
+    ASSERT_TRUE(res && res->status == 200);
+
+    server.test_running() = false;
+    server_thread.join();
+
+    EXPECT_EQ(created, 19);
+    EXPECT_EQ(rejected, 1);
+    EXPECT_EQ(server.test_stats().tx_datagrams(), 20u);
+    EXPECT_EQ(server.test_sessions().size(), 19u);
+    EXPECT_EQ(server.test_thread_pool().size(), 0u);
+    EXPECT_EQ(count_creates(), 19);
+    std::remove(config.cdr_file.c_str());
+}
+
+TEST_F(PgwServerTest, SessionCleanerHonoursMillisecondTimeout) {
+    config.blacklist.clear();
+    config.session_tick_ms = 10;
+    config.session_timeout_ms = 100;
+    PgwServer server(config);
+
+    auto now = std::chrono::steady_clock::now();
+    server.test_sessions().insert(pack_imsi("7777"), now);
+    server.test_sessions().insert(pack_imsi("6666"), now + std::chrono::seconds(10));
+    server.test_running() = true;
+
+    server.test_start_session_cleaner();
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    server.test_running() = false;
+    server.test_cleaner_thread().join();
+
+    EXPECT_FALSE(server.test_sessions().active("7777"));
+    EXPECT_TRUE(server.test_sessions().active("6666"));
+}
+
+TEST_F(PgwServerTest, SessionCleanerWithALongTickStopsWithinASecond) {
+    config.session_tick_ms = 60000;
+    PgwServer server(config);
+    server.test_running() = true;
+
+    server.test_start_session_cleaner();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    server.test_running() = false;
+    auto stopping = std::chrono::steady_clock::now();
+    server.test_cleaner_thread().join();
+
+    EXPECT_LT(std::chrono::steady_clock::now() - stopping, std::chrono::milliseconds(1500));
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include "server/rate_limiter.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr uint64_t SECOND = 1000000000ULL;
+// Any non-zero steady-clock reading will do.
+constexpr uint64_t START = 1000 * SECOND;
+
+Datagram make_datagram(const char* ip, const uint8_t* payload, size_t length) {
+    Datagram datagram{payload, length, {}};
+    datagram.source.sin_family = AF_INET;
+    datagram.source.sin_addr.s_addr = inet_addr(ip);
+    return datagram;
+}
+}
+
+TEST(TokenBucketTableTest, AllowsBurstThenRefillsAtRate) {
+    TokenBucketTable table(64, 10, 3, std::chrono::seconds(60));
+    EXPECT_TRUE(table.consume(1, START));
+    EXPECT_TRUE(table.consume(1, START));
+    EXPECT_TRUE(table.consume(1, START));
+    EXPECT_FALSE(table.consume(1, START));
+
+    // One token every 100 ms.
+    EXPECT_FALSE(table.consume(1, START + SECOND / 20));
+    EXPECT_TRUE(table.consume(1, START + SECOND / 10));
+    EXPECT_FALSE(table.consume(1, START + SECOND / 10));
+}
+
+TEST(TokenBucketTableTest, KeysHaveSeparateBuckets) {
+    TokenBucketTable table(64, 1, 1, std::chrono::seconds(60));
+    EXPECT_TRUE(table.consume(1, START));
+    EXPECT_FALSE(table.consume(1, START));
+    EXPECT_TRUE(table.consume(2, START));
+    EXPECT_EQ(table.active(START), 2u);
+}
+
+TEST(TokenBucketTableTest, FullWindowReplacesLongestIdleEntry) {
+    // Eight slots: every key lands in the same probe window.
+    TokenBucketTable table(8, 1, 1, std::chrono::seconds(60));
+    EXPECT_EQ(table.capacity(), 8u);
+    for (uint64_t key = 1; key <= 8; ++key) {
+        EXPECT_TRUE(table.consume(key, START + key));
+    }
+    EXPECT_TRUE(table.consume(9, START + 10));
+    EXPECT_EQ(table.active(START + 10), 8u);
+
+    // Key 1 was evicted and starts over with a full bucket, key 2 was kept.
+    EXPECT_TRUE(table.consume(1, START + 11));
+    EXPECT_FALSE(table.consume(3, START + 12));
+}
+
+TEST(TokenBucketTableTest, IdleBucketsAreNotActive) {
+    TokenBucketTable table(64, 100, 1, std::chrono::seconds(1));
+    table.consume(1, START);
+    EXPECT_EQ(table.active(START), 1u);
+    EXPECT_EQ(table.active(START + 3 * SECOND), 0u);
+}
+
+TEST(TokenBucketTableTest, ConcurrentConsumersNeverExceedBurst) {
+    TokenBucketTable table(64, 1, 100, std::chrono::seconds(60));
+    std::atomic<int> passed{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; ++i) {
+                if (table.consume(42, START)) passed.fetch_add(1);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(passed.load(), 100);
+}
+
+TEST(RateLimiterTest, DisabledWithoutRates) {
+    ServerConfig config;
+    RateLimiter limiter(config);
+    EXPECT_FALSE(limiter.enabled());
+    EXPECT_EQ(limiter.by_ip(), nullptr);
+    EXPECT_EQ(limiter.by_imsi(), nullptr);
+}
+
+TEST(RateLimiterTest, LimitsEachSourceIpSeparately) {
+    ServerConfig config;
+    config.rate_limit_ip_rate = 1;
+    config.rate_limit_ip_burst = 2;
+    RateLimiter limiter(config);
+    ASSERT_TRUE(limiter.enabled());
+
+    uint8_t payload[8] = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF5};
+    Datagram noisy = make_datagram("10.0.0.1", payload, sizeof(payload));
+    Datagram quiet = make_datagram("10.0.0.2", payload, sizeof(payload));
+    EXPECT_EQ(limiter.check(noisy, START), RateLimiter::Verdict::Pass);
+    EXPECT_EQ(limiter.check(noisy, START), RateLimiter::Verdict::Pass);
+    EXPECT_EQ(limiter.check(noisy, START), RateLimiter::Verdict::SourceIp);
+    EXPECT_EQ(limiter.check(quiet, START), RateLimiter::Verdict::Pass);
+}
+
+TEST(RateLimiterTest, LimitsImsiAcrossSources) {
+    ServerConfig config;
+    config.rate_limit_imsi_rate = 1;
+    config.rate_limit_imsi_burst = 1;
+    RateLimiter limiter(config);
+
+    uint8_t imsi_a[8] = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF5};
+    uint8_t imsi_b[8] = {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0xF6};
+    EXPECT_EQ(limiter.check(make_datagram("10.0.0.1", imsi_a, 8), START), RateLimiter::Verdict::Pass);
+    EXPECT_EQ(limiter.check(make_datagram("10.0.0.2", imsi_a, 8), START), RateLimiter::Verdict::Imsi);
+    EXPECT_EQ(limiter.check(make_datagram("10.0.0.2", imsi_b, 8), START), RateLimiter::Verdict::Pass);
+
+    // Payloads of another length are not IMSIs and are left to the decoder.
+    EXPECT_EQ(limiter.check(make_datagram("10.0.0.1", imsi_a, 4), START), RateLimiter::Verdict::Pass);
+    EXPECT_EQ(limiter.check(make_datagram("10.0.0.1", imsi_a, 4), START), RateLimiter::Verdict::Pass);
+}
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include "server/server_stats.hpp"
+#include <string>
+
+TEST(ServerStatsTest, StartsAtZero) {
+    ServerStats stats;
+    EXPECT_EQ(stats.rx_datagrams(), 0u);
+    EXPECT_EQ(stats.rx_batches(), 0u);
+    for (size_t i = 0; i < ServerStats::FILL_BUCKETS; ++i) {
+        EXPECT_EQ(stats.rx_batch_fill(i), 0u);
+    }
+}
+
+TEST(ServerStatsTest, RecordsBatchFillBuckets) {
+    ServerStats stats;
+    stats.record_rx_batch(32, 32);
+    stats.record_rx_batch(16, 32);
+    stats.record_rx_batch(1, 32);
+
+    EXPECT_EQ(stats.rx_datagrams(), 49u);
+    EXPECT_EQ(stats.rx_batches(), 3u);
+    EXPECT_EQ(stats.rx_batch_fill(10), 1u);
+    EXPECT_EQ(stats.rx_batch_fill(5), 1u);
+    EXPECT_EQ(stats.rx_batch_fill(0), 1u);
+}
+
+TEST(ServerStatsTest, IgnoresEmptyBatches) {
+    ServerStats stats;
+    stats.record_rx_batch(0, 32);
+    EXPECT_EQ(stats.rx_batches(), 0u);
+}
+
+TEST(ServerStatsTest, RenderListsCounters) {
+    ServerStats stats;
+    stats.record_rx_batch(4, 4);
+
+    std::string text = stats.render();
+    EXPECT_NE(text.find("rx_datagrams 4\n"), std::string::npos);
+    EXPECT_NE(text.find("rx_batches 1\n"), std::string::npos);
+    EXPECT_NE(text.find("rx_batch_fill{pct=\"100\"} 1\n"), std::string::npos);
+}
+
+TEST(ServerStatsTest, RecordsTxBatches) {
+    ServerStats stats;
+    stats.record_tx_batch(5);
+    stats.record_tx_batch(0);
+    stats.record_tx_batch(3);
+
+    EXPECT_EQ(stats.tx_datagrams(), 8u);
+    EXPECT_EQ(stats.tx_batches(), 2u);
+    EXPECT_NE(stats.render().find("tx_datagrams 8\n"), std::string::npos);
+}
+
+TEST(ServerStatsTest, RecordsPerReactorRx) {
+    ServerStats stats;
+    stats.record_reactor_rx(0, 2);
+    stats.record_reactor_rx(3, 5);
+    stats.record_reactor_rx(ServerStats::MAX_REACTORS, 7);
+
+    EXPECT_EQ(stats.reactor_rx(0), 2u);
+    EXPECT_EQ(stats.reactor_rx(3), 5u);
+
+    std::string text = stats.render();
+    EXPECT_NE(text.find("reactor_rx{reactor=\"3\"} 5\n"), std::string::npos);
+    EXPECT_EQ(text.find("reactor_rx{reactor=\"1\"}"), std::string::npos);
+}
+
+TEST(ServerStatsTest, RecordsDropsPerReason) {
+    ServerStats stats;
+    stats.record_app_drop(ServerStats::DropReason::Invalid);
+    stats.record_app_drop(ServerStats::DropReason::Invalid, 2);
+    stats.record_app_drop(ServerStats::DropReason::Count);
+
+    EXPECT_EQ(stats.app_dropped(ServerStats::DropReason::Invalid), 3u);
+    EXPECT_EQ(stats.app_dropped(), 3u);
+    EXPECT_NE(stats.render().find("app_dropped{reason=\"invalid\"} 3\n"), std::string::npos);
+}
+
+TEST(ServerStatsTest, KernelDropsKeepLatestValuePerReactor) {
+    ServerStats stats;
+    stats.set_reactor_kernel_drops(0, 4);
+    stats.set_reactor_kernel_drops(0, 10);
+    stats.set_reactor_kernel_drops(2, 5);
+    stats.set_reactor_kernel_drops(ServerStats::MAX_REACTORS, 100);
+
+    EXPECT_EQ(stats.kernel_rx_dropped(), 15u);
+    EXPECT_NE(stats.render().find("kernel_rx_dropped 15\n"), std::string::npos);
+}
+
+TEST(ServerStatsTest, NotesFilterRejectionsInKernelDrops) {
+    ServerStats stats;
+    EXPECT_EQ(stats.render().find("# kernel_rx_dropped includes socket filter rejections\n"), std::string::npos);
+
+    stats.set_socket_filter(true);
+    stats.set_socket_drops(3);
+    std::string text = stats.render();
+    EXPECT_NE(text.find("socket_drops 3\n"), std::string::npos);
+    EXPECT_NE(text.find("# kernel_rx_dropped includes socket filter rejections\nkernel_rx_dropped 0\n"),
+              std::string::npos);
+}
+
+TEST(ServerStatsTest, RecordsWorkerSpinAndParkTime) {
+    ServerStats stats;
+    stats.record_worker_spin(300, true);
+    stats.record_worker_spin(500, false);
+    stats.record_worker_park(2000);
+
+    EXPECT_EQ(stats.worker_spin_ns(), 800u);
+    EXPECT_EQ(stats.worker_spin_wakeups(), 1u);
+    EXPECT_EQ(stats.worker_park_ns(), 2000u);
+    EXPECT_EQ(stats.worker_parks(), 1u);
+
+    std::string text = stats.render();
+    EXPECT_NE(text.find("worker_spin_ns 800\n"), std::string::npos);
+    EXPECT_NE(text.find("worker_parks 1\n"), std::string::npos);
+}
+
+TEST(ServerStatsTest, CountsWorkerSteals) {
+    ServerStats stats;
+    EXPECT_NE(stats.render().find("worker_steals 0\n"), std::string::npos);
+    stats.record_worker_steal();
+    stats.record_worker_steal();
+    EXPECT_EQ(stats.worker_steals(), 2u);
+    EXPECT_NE(stats.render().find("worker_steals 2\n"), std::string::npos);
+}
+
+TEST(ServerStatsTest, ReportsActiveRateLimitBuckets) {
+    ServerStats stats;
+    stats.set_rate_limit_buckets(12, 3);
+
+    EXPECT_EQ(stats.rate_limit_ip_buckets(), 12u);
+    EXPECT_EQ(stats.rate_limit_imsi_buckets(), 3u);
+    EXPECT_NE(stats.render().find("rate_limit_buckets{table=\"ip\"} 12\n"), std::string::npos);
+}
+
+TEST(ServerStatsTest, ReportsQueueGaugesForActiveReactors) {
+    ServerStats stats;
+    stats.record_reactor_rx(1, 10);
+    stats.set_queue_depth(1, 7);
+    stats.set_queue_sojourn(1, 2500);
+    stats.set_queue_depth(ServerStats::MAX_REACTORS, 1);
+
+    EXPECT_EQ(stats.queue_depth(1), 7u);
+    EXPECT_EQ(stats.queue_sojourn_ns(1), 2500u);
+    std::string text = stats.render();
+    EXPECT_NE(text.find("task_queue_depth{reactor=\"1\"} 7\n"), std::string::npos);
+    EXPECT_NE(text.find("task_queue_sojourn_ns{reactor=\"1\"} 2500\n"), std::string::npos);
+    EXPECT_EQ(text.find("task_queue_depth{reactor=\"0\"}"), std::string::npos);
+}
+
+TEST(ServerStatsTest, ReportsActiveWorkersPerReactor) {
+    ServerStats stats;
+    stats.record_reactor_rx(0, 1);
+    stats.set_active_workers(0, 3);
+    stats.set_active_workers(ServerStats::MAX_REACTORS, 1);
+
+    EXPECT_EQ(stats.active_workers(0), 3u);
+    EXPECT_NE(stats.render().find("active_workers{reactor=\"0\"} 3\n"), std::string::npos);
+}
+
+TEST(ServerStatsTest, ReportsQueueDepthPerPartition) {
+    ServerStats stats;
+    stats.set_partitions(2);
+    stats.set_partition_depth(1, 5);
+    stats.set_partition_depth(ServerStats::MAX_PARTITIONS, 1);
+
+    EXPECT_EQ(stats.partitions(), 2u);
+    EXPECT_EQ(stats.partition_depth(1), 5u);
+    std::string text = stats.render();
+    EXPECT_NE(text.find("partition_queue_depth{worker=\"0\"} 0\n"), std::string::npos);
+    EXPECT_NE(text.find("partition_queue_depth{worker=\"1\"} 5\n"), std::string::npos);
+    EXPECT_EQ(text.find("partition_queue_depth{worker=\"2\"}"), std::string::npos);
+    // Without partitions there is no such series.
+    EXPECT_EQ(ServerStats().render().find("partition_queue_depth"), std::string::npos);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "server/session_store.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+ImsiKey imsi_of(int n) {
+    std::string digits = std::to_string(n);
+    return pack_imsi(std::string(15 - digits.size(), '0') + digits);
+}
+}
+
+TEST(ShardedSessionTableTest, OpensEachImsiOnceAndKeepsItsStart) {
+    ShardedSessionTable table(4);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(table.open(pack_imsi("001010000000001"), start));
+    EXPECT_FALSE(table.open(pack_imsi("001010000000001"), start + 5s));
+    EXPECT_TRUE(table.active("001010000000001"));
+    EXPECT_FALSE(table.active("001010000000002"));
+    EXPECT_EQ(table.size(), 1u);
+
+    // Still started at `start`: the second open did not move it.
+    std::vector<ImsiKey> expired;
+    table.expire(start + 3s, 2s, expired);
+    EXPECT_EQ(expired, std::vector<ImsiKey>{pack_imsi("001010000000001")});
+    EXPECT_TRUE(table.empty());
+}
+
+TEST(ShardedSessionTableTest, ExpireSweepsEveryShard) {
+    ShardedSessionTable table(8);
+    auto now = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100; ++i) {
+        table.insert(imsi_of(i), i % 2 ? now - 10s : now);
+    }
+    EXPECT_EQ(table.size(), 100u);
+
+    std::vector<ImsiKey> expired;
+    table.expire(now, 1s, expired);
+    EXPECT_EQ(expired.size(), 50u);
+    EXPECT_EQ(table.size(), 50u);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(table.active(imsi_of(i)), i % 2 == 0) << unpack_imsi(imsi_of(i));
+    }
+}
+
+TEST(ShardedSessionTableTest, HasAtLeastOneShard) {
+    ShardedSessionTable table(0);
+    EXPECT_EQ(table.shards(), 1u);
+    EXPECT_TRUE(table.open(pack_imsi("001010000000001"), std::chrono::steady_clock::now()));
+    EXPECT_TRUE(table.active("001010000000001"));
+}
+
+TEST(ShardedSessionTableTest, RefusesKeysThatAreNotImsis) {
+    ShardedSessionTable table(4);
+    EXPECT_FALSE(table.open(0, std::chrono::steady_clock::now()));
+    EXPECT_FALSE(table.active("00101000000000x"));
+    EXPECT_FALSE(table.active(""));
+    EXPECT_TRUE(table.empty());
+}
+
+TEST(ShardedSessionTableTest, ConcurrentOpensCreateEachSessionOnce) {
+    ShardedSessionTable table(16);
+    constexpr int THREADS = 4;
+    constexpr int IMSIS = 2000;
+    std::atomic<int> opened{0};
+    std::vector<std::thread> threads;
+    // Every thread opens every IMSI, each starting at another one.
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&table, &opened, t]() {
+            for (int i = 0; i < IMSIS; ++i) {
+                if (table.open(imsi_of((i + t * IMSIS / THREADS) % IMSIS), std::chrono::steady_clock::now())) {
+                    ++opened;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(opened.load(), IMSIS);
+    EXPECT_EQ(table.size(), static_cast<size_t>(IMSIS));
+}
@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+#include "server/socket_filters.hpp"
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+std::vector<uint8_t> encode_imsi_bcd(const std::string& imsi) {
+    std::vector<uint8_t> bcd;
+    for (size_t i = 0; i < imsi.size(); i += 2) {
+        uint8_t low = imsi[i] - '0';
+        uint8_t high = (i + 1 < imsi.size()) ? (imsi[i + 1] - '0') : 0xF;
+        bcd.push_back((high << 4) | low);
+    }
+    return bcd;
+}
+
+int bind_reuseport_socket(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int count_pending(int fd) {
+    int count = 0;
+    char buffer[64];
+    while (recv(fd, buffer, sizeof(buffer), 0) > 0) ++count;
+    return count;
+}
+}
+
+TEST(SocketFiltersTest, SteeringIndexIsStableAndInRange) {
+    auto bcd = encode_imsi_bcd("250990000000001");
+    uint32_t first = imsi_steering_index(bcd.data(), bcd.size(), 4);
+    EXPECT_LT(first, 4u);
+    EXPECT_EQ(imsi_steering_index(bcd.data(), bcd.size(), 4), first);
+    EXPECT_EQ(imsi_steering_index(bcd.data(), bcd.size(), 1), 0u);
+}
+
+TEST(SocketFiltersTest, ShortPayloadFallsBackToFlowHash) {
+    auto bcd = encode_imsi_bcd("12345");
+    EXPECT_EQ(imsi_steering_index(bcd.data(), bcd.size(), 4), 4u);
+}
+
+TEST(SocketFiltersTest, SteeringSpreadsImsisOverGroups) {
+    std::vector<int> hits(4, 0);
+    for (int i = 0; i < 400; ++i) {
+        auto bcd = encode_imsi_bcd(std::to_string(250990000000000 + i));
+        ++hits[imsi_steering_index(bcd.data(), bcd.size(), 4)];
+    }
+    for (int count : hits) {
+        EXPECT_GT(count, 50);
+    }
+}
+
+TEST(SocketFiltersTest, ProgramEndsWithFallbackReturn) {
+    auto program = build_imsi_steering_program(8);
+    ASSERT_FALSE(program.empty());
+    EXPECT_EQ(program.back().code, BPF_RET | BPF_K);
+    EXPECT_EQ(program.back().k, 8u);
+}
+
+TEST(SocketFiltersTest, AttachFailsOnInvalidArguments) {
+    EXPECT_FALSE(attach_imsi_steering(-1, 2));
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(fd, 0);
+    EXPECT_FALSE(attach_imsi_steering(fd, 0));
+    close(fd);
+}
+
+TEST(SocketFiltersTest, KernelSteersImsiToPredictedSocket) {
+    const uint16_t port = 9311;
+    std::vector<int> group;
+    for (int i = 0; i < 4; ++i) {
+        int fd = bind_reuseport_socket(port);
+        ASSERT_GE(fd, 0);
+        group.push_back(fd);
+    }
+    ASSERT_TRUE(attach_imsi_steering(group[0], group.size()));
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port);
+    server_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    std::vector<std::string> imsis = {"250990000000001", "250990000000002", "250990000000003"};
+    std::vector<int> expected(group.size(), 0);
+    for (const auto& imsi : imsis) {
+        auto bcd = encode_imsi_bcd(imsi);
+        // Eight different source ports per IMSI: flow hashing would scatter them.
+        for (int i = 0; i < 8; ++i) {
+            int client = socket(AF_INET, SOCK_DGRAM, 0);
+            sendto(client, bcd.data(), bcd.size(), 0, (sockaddr*)&server_addr, sizeof(server_addr));
+            close(client);
+        }
+        expected[imsi_steering_index(bcd.data(), bcd.size(), group.size())] += 8;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    for (size_t i = 0; i < group.size(); ++i) {
+        EXPECT_EQ(count_pending(group[i]), expected[i]) << "socket " << i;
+        close(group[i]);
+    }
+}
+
+class ImsiValidationFilterTest : public ::testing::Test {
+protected:
+    int server_fd = -1;
+    int client_fd = -1;
+    sockaddr_in server_addr{};
+
+    void SetUp() override {
+        server_fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+        ASSERT_GE(server_fd, 0);
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+        ASSERT_EQ(bind(server_fd, (sockaddr*)&server_addr, sizeof(server_addr)), 0);
+        socklen_t len = sizeof(server_addr);
+        getsockname(server_fd, (sockaddr*)&server_addr, &len);
+        ASSERT_TRUE(attach_imsi_validation(server_fd));
+
+        client_fd = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_GE(client_fd, 0);
+    }
+
+    void TearDown() override {
+        if (server_fd >= 0) close(server_fd);
+        if (client_fd >= 0) close(client_fd);
+    }
+
+    bool delivered(const std::vector<uint8_t>& payload) {
+        sendto(client_fd, payload.data(), payload.size(), 0, (sockaddr*)&server_addr, sizeof(server_addr));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return count_pending(server_fd) == 1;
+    }
+};
+
+TEST_F(ImsiValidationFilterTest, AcceptsFifteenDigitImsi) {
+    EXPECT_TRUE(delivered(encode_imsi_bcd("001010123456789")));
+    EXPECT_TRUE(delivered(encode_imsi_bcd("999999999999999")));
+}
+
+TEST_F(ImsiValidationFilterTest, DropsWrongLength) {
+    EXPECT_FALSE(delivered(encode_imsi_bcd("12345")));
+    EXPECT_FALSE(delivered(encode_imsi_bcd("1234567890123456")));
+    EXPECT_FALSE(delivered({}));
+    EXPECT_FALSE(delivered(std::vector<uint8_t>(16, 0x11)));
+}
+
+TEST_F(ImsiValidationFilterTest, DropsInvalidNibbles) {
+    auto bcd = encode_imsi_bcd("001010123456789");
+    bcd[3] = 0x1A;
+    EXPECT_FALSE(delivered(bcd));
+    bcd[3] = 0xB1;
+    EXPECT_FALSE(delivered(bcd));
+    bcd[3] = 0x11;
+    bcd[7] = 0xFA;
+    EXPECT_FALSE(delivered(bcd));
+}
+
+TEST_F(ImsiValidationFilterTest, RequiresPaddingInLastByteOnly) {
+    auto bcd = encode_imsi_bcd("001010123456789");
+    bcd[7] = 0x99;
+    EXPECT_FALSE(delivered(bcd));
+    bcd[7] = 0xF9;
+    bcd[0] = 0xF0;
+    EXPECT_FALSE(delivered(bcd));
+}
+
+TEST_F(ImsiValidationFilterTest, DropCountTracksRejectedDatagrams) {
+    uint64_t before = socket_drop_count(server_fd);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_FALSE(delivered({0xFF, 0xFF}));
+    }
+    EXPECT_TRUE(delivered(encode_imsi_bcd("001010123456789")));
+    EXPECT_EQ(socket_drop_count(server_fd) - before, 3u);
+}
+
+TEST(SocketFiltersTest, DropCountOfInvalidSocketIsZero) {
+    EXPECT_EQ(socket_drop_count(-1), 0u);
+}
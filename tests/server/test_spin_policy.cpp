@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+#include "server/spin_policy.hpp"
+
+using std::chrono::microseconds;
+using std::chrono::nanoseconds;
+
+TEST(SpinPolicyTest, ZeroBudgetNeverSpins) {
+    SpinPolicy spin(microseconds(0));
+    EXPECT_EQ(spin.budget(), nanoseconds::zero());
+    spin.record_wait(microseconds(1));
+    EXPECT_EQ(spin.budget(), nanoseconds::zero());
+}
+
+TEST(SpinPolicyTest, StartsAtMaximumBudget) {
+    SpinPolicy spin(microseconds(50));
+    EXPECT_EQ(spin.budget(), microseconds(50));
+}
+
+TEST(SpinPolicyTest, ShortGapsShrinkBudgetToTwiceTheGap) {
+    SpinPolicy spin(microseconds(100));
+    for (int i = 0; i < 100; ++i) {
+        spin.record_wait(microseconds(10));
+    }
+    EXPECT_GE(spin.budget(), microseconds(19));
+    EXPECT_LE(spin.budget(), microseconds(21));
+}
+
+TEST(SpinPolicyTest, LongGapsStopSpinningAndShortGapsResumeIt) {
+    SpinPolicy spin(microseconds(50));
+    for (int i = 0; i < 20; ++i) {
+        spin.record_wait(std::chrono::seconds(1));
+    }
+    EXPECT_EQ(spin.budget(), nanoseconds::zero());
+
+    // Idle periods are capped, so a burst brings the spin back quickly.
+    for (int i = 0; i < 20; ++i) {
+        spin.record_wait(microseconds(5));
+    }
+    EXPECT_GT(spin.budget(), nanoseconds::zero());
+    EXPECT_LE(spin.budget(), microseconds(50));
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include "server/thread_topology.hpp"
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+
+namespace {
+std::string current_thread_name() {
+    char name[16] = {};
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    return name;
+}
+
+std::vector<int> current_thread_cpus() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::vector<int> cpus;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+}
+
+TEST(ThreadTopologyTest, NamesThreadAndCutsOffLongNames) {
+    std::string short_name;
+    std::string long_name;
+    std::thread([&] {
+        set_thread_name("pgw-worker-3");
+        short_name = current_thread_name();
+        set_thread_name("pgw-worker-with-a-long-name");
+        long_name = current_thread_name();
+    }).join();
+    EXPECT_EQ(short_name, "pgw-worker-3");
+    EXPECT_EQ(long_name, "pgw-worker-with");
+}
+
+TEST(ThreadTopologyTest, PinsThreadToCpuList) {
+    std::vector<int> available = current_thread_cpus();
+    ASSERT_FALSE(available.empty());
+    std::vector<int> pinned;
+    bool result = false;
+    std::thread([&] {
+        result = pin_thread({available.back()});
+        pinned = current_thread_cpus();
+    }).join();
+    EXPECT_TRUE(result);
+    EXPECT_EQ(pinned, std::vector<int>{available.back()});
+}
+
+TEST(ThreadTopologyTest, EmptyListLeavesThreadUnpinned) {
+    std::vector<int> before = current_thread_cpus();
+    std::vector<int> after;
+    std::thread([&] {
+        EXPECT_TRUE(pin_thread({}));
+        after = current_thread_cpus();
+    }).join();
+    EXPECT_EQ(after, before);
+}
+
+TEST(ThreadTopologyTest, FailsOnCpuOutsideTheSet) {
+    std::thread([] {
+        EXPECT_FALSE(pin_thread({CPU_SETSIZE}));
+        EXPECT_FALSE(pin_thread({-1}));
+    }).join();
+}
+
+TEST(ThreadTopologyTest, DealsCpusToThreadsInTurn) {
+    std::vector<int> cpus = {2, 3, 6};
+    EXPECT_EQ(cpu_of(cpus, 0), std::vector<int>{2});
+    EXPECT_EQ(cpu_of(cpus, 1), std::vector<int>{3});
+    EXPECT_EQ(cpu_of(cpus, 2), std::vector<int>{6});
+    EXPECT_EQ(cpu_of(cpus, 3), std::vector<int>{2});
+    EXPECT_TRUE(cpu_of({}, 5).empty());
+}
+
+TEST(ThreadTopologyTest, FormatsCpuListAsRanges) {
+    EXPECT_EQ(format_cpu_list({}), "any");
+    EXPECT_EQ(format_cpu_list({4}), "4");
+    EXPECT_EQ(format_cpu_list({0, 1, 2, 3, 8}), "0-3,8");
+    EXPECT_EQ(format_cpu_list({1, 3, 4}), "1,3-4");
+}
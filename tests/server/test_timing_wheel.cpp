@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include "server/timing_wheel.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+TEST(TimingWheelTest, TakesEntriesOnEveryLevelAtTheirTick) {
+    TimingWheel wheel;
+    // One entry for each level.
+    std::vector<uint32_t> ticks = {0, 5, 300, 70000, 20000000};
+    for (uint32_t id = 1; id < ticks.size(); ++id) {
+        wheel.schedule(id, ticks[id]);
+    }
+    EXPECT_EQ(wheel.size(), 4u);
+
+    std::vector<uint32_t> due;
+    wheel.advance(4, ticks, due);
+    EXPECT_TRUE(due.empty());
+    wheel.advance(5, ticks, due);
+    EXPECT_EQ(due, std::vector<uint32_t>{1});
+    wheel.advance(299, ticks, due);
+    EXPECT_EQ(due.size(), 1u);
+    wheel.advance(69999, ticks, due);
+    EXPECT_EQ(due, (std::vector<uint32_t>{1, 2}));
+    wheel.advance(19999999, ticks, due);
+    EXPECT_EQ(due, (std::vector<uint32_t>{1, 2, 3}));
+    wheel.advance(20000000, ticks, due);
+    EXPECT_EQ(due, (std::vector<uint32_t>{1, 2, 3, 4}));
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimingWheelTest, TicksWrapAround) {
+    TimingWheel wheel(UINT32_MAX - 10);
+    std::vector<uint32_t> ticks = {0, UINT32_MAX - 5, 20};
+    wheel.schedule(1, ticks[1]);
+    wheel.schedule(2, ticks[2]);
+
+    std::vector<uint32_t> due;
+    wheel.advance(UINT32_MAX, ticks, due);
+    EXPECT_EQ(due, std::vector<uint32_t>{1});
+    wheel.advance(19, ticks, due);
+    EXPECT_EQ(due.size(), 1u);
+    wheel.advance(20, ticks, due);
+    EXPECT_EQ(due, (std::vector<uint32_t>{1, 2}));
+}
+
+TEST(TimingWheelTest, PassedTicksWaitForTheirTurn) {
+    TimingWheel wheel(1000);
+    std::vector<uint32_t> ticks = {0, 900, 950};
+    wheel.schedule(1, ticks[1]);
+    wheel.schedule(2, ticks[2]);
+
+    std::vector<uint32_t> due;
+    wheel.advance(899, ticks, due);
+    EXPECT_TRUE(due.empty());
+    wheel.advance(900, ticks, due);
+    EXPECT_EQ(due, std::vector<uint32_t>{1});
+    EXPECT_EQ(wheel.size(), 1u);
+    wheel.advance(2000, ticks, due);
+    EXPECT_EQ(due, (std::vector<uint32_t>{1, 2}));
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimingWheelTest, DropsEntriesLeftBehind) {
+    TimingWheel wheel;
+    std::vector<uint32_t> ticks = {0, 300, 70000};
+    wheel.schedule(1, ticks[1]);
+    wheel.schedule(2, ticks[2]);
+    // Both ids get new ticks: 1 in another unit, 2 in the same level-1 unit.
+    ticks[1] = 70000;
+    wheel.schedule(1, ticks[1]);
+    ticks[2] = 70100;
+    wheel.schedule(2, ticks[2]);
+    EXPECT_EQ(wheel.size(), 4u);
+
+    std::vector<uint32_t> due;
+    wheel.advance(69999, ticks, due);
+    EXPECT_TRUE(due.empty());
+    wheel.advance(70000, ticks, due);
+    EXPECT_EQ(due, std::vector<uint32_t>{1});
+    // The entry 2 left behind comes out as a second one for its new tick.
+    wheel.advance(70100, ticks, due);
+    EXPECT_EQ(due, (std::vector<uint32_t>{1, 2, 2}));
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimingWheelTest, MatchesSortedTicksUnderRandomSteps) {
+    std::mt19937 random(7);
+    TimingWheel wheel(1000);
+    std::vector<uint32_t> ticks(20000);
+    for (uint32_t id = 0; id < ticks.size(); ++id) {
+        ticks[id] = 1000 + random() % (1u << 22);
+        wheel.schedule(id, ticks[id]);
+    }
+    std::vector<uint32_t> sorted = ticks;
+    std::sort(sorted.begin(), sorted.end());
+
+    std::vector<uint32_t> due;
+    size_t taken = 0;
+    for (uint32_t to = 1000; to < 1000 + (1u << 22) + 5000; to += 1 + random() % 5000) {
+        wheel.advance(to, ticks, due);
+        while (taken < sorted.size() && sorted[taken] <= to) {
+            ++taken;
+        }
+        ASSERT_EQ(due.size(), taken) << to;
+        for (uint32_t id : due) {
+            ASSERT_LE(ticks[id], to);
+        }
+    }
+    EXPECT_EQ(due.size(), ticks.size());
+    EXPECT_EQ(wheel.size(), 0u);
+}
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include "server/udp_batch.hpp"
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string>
+#include <vector>
+
+class UdpRecvBatchTest : public ::testing::Test {
+protected:
+    int server_fd = -1;
+    int client_fd = -1;
+    sockaddr_in server_addr{};
+
+    void SetUp() override {
+        server_fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+        ASSERT_GE(server_fd, 0);
+
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_port = 0;
+        server_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+        ASSERT_EQ(bind(server_fd, (sockaddr*)&server_addr, sizeof(server_addr)), 0);
+
+        socklen_t len = sizeof(server_addr);
+        getsockname(server_fd, (sockaddr*)&server_addr, &len);
+
+        client_fd = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_GE(client_fd, 0);
+    }
+
+    void TearDown() override {
+        if (server_fd >= 0) close(server_fd);
+        if (client_fd >= 0) close(client_fd);
+    }
+
+    void send_payload(const std::vector<uint8_t>& payload) {
+        sendto(client_fd, payload.data(), payload.size(), 0, (sockaddr*)&server_addr, sizeof(server_addr));
+    }
+};
+
+TEST_F(UdpRecvBatchTest, EmptySocketReturnsZero) {
+    UdpRecvBatch batch(8);
+    EXPECT_EQ(batch.receive(server_fd), 0);
+}
+
+TEST_F(UdpRecvBatchTest, ReceivesSeveralDatagramsInOneCall) {
+    for (uint8_t i = 0; i < 5; ++i) {
+        send_payload({0x21, 0x43, i});
+    }
+
+    UdpRecvBatch batch(8);
+    ASSERT_EQ(batch.receive(server_fd), 5);
+    for (size_t i = 0; i < 5; ++i) {
+        ASSERT_EQ(batch.length(i), 3u);
+        EXPECT_EQ(batch.data(i)[0], 0x21);
+        EXPECT_EQ(batch.data(i)[2], i);
+        EXPECT_EQ(batch.address(i).sin_addr.s_addr, inet_addr("127.0.0.1"));
+    }
+    EXPECT_EQ(batch.receive(server_fd), 0);
+}
+
+TEST_F(UdpRecvBatchTest, StopsAtCapacity) {
+    for (int i = 0; i < 6; ++i) {
+        send_payload({0x11});
+    }
+
+    UdpRecvBatch batch(4);
+    EXPECT_EQ(batch.receive(server_fd), 4);
+    EXPECT_EQ(batch.receive(server_fd), 2);
+    EXPECT_EQ(batch.receive(server_fd), 0);
+}
+
+TEST_F(UdpRecvBatchTest, TruncatesOversizedDatagram) {
+    send_payload(std::vector<uint8_t>(64, 0x12));
+
+    UdpRecvBatch batch(2);
+    ASSERT_EQ(batch.receive(server_fd), 1);
+    EXPECT_EQ(batch.length(0), UdpRecvBatch::MAX_DATAGRAM_SIZE);
+}
+
+TEST_F(UdpRecvBatchTest, InvalidSocketReturnsError) {
+    UdpRecvBatch batch(2);
+    EXPECT_EQ(batch.receive(-1), -1);
+}
+
+TEST_F(UdpRecvBatchTest, ReportsKernelDropsWithRxqOvfl) {
+    int enable = 1;
+    ASSERT_EQ(setsockopt(server_fd, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable)), 0);
+    int rcvbuf = 1;  // the kernel rounds up to its minimum, a few datagrams fit
+    setsockopt(server_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    UdpRecvBatch batch(4);
+    EXPECT_EQ(batch.kernel_drops(), 0u);
+    for (int i = 0; i < 200; ++i) {
+        send_payload({0x21, 0x43});
+    }
+
+    // A datagram carries the count as of its own arrival: the drops show up
+    // with the first datagram queued after them.
+    while (batch.receive(server_fd) > 0) {
+    }
+    EXPECT_EQ(batch.kernel_drops(), 0u);
+    send_payload({0x21, 0x43});
+    ASSERT_EQ(batch.receive(server_fd), 1);
+    EXPECT_GT(batch.kernel_drops(), 0u);
+    EXPECT_LT(batch.kernel_drops(), 200u);
+}
+
+class UdpSendBatchTest : public UdpRecvBatchTest {};
+
+TEST_F(UdpSendBatchTest, FlushDeliversEveryDatagram) {
+    static const char payload[] = "created";
+    UdpSendBatch batch(4);
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(batch.add(client_fd, server_addr, payload, sizeof(payload) - 1));
+    }
+    EXPECT_EQ(batch.size(), 3u);
+    EXPECT_EQ(batch.flush(), 3);
+    EXPECT_TRUE(batch.empty());
+
+    UdpRecvBatch rx(8);
+    ASSERT_EQ(rx.receive(server_fd), 3);
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(std::string(reinterpret_cast<const char*>(rx.data(i)), rx.length(i)), "created");
+    }
+}
+
+TEST_F(UdpSendBatchTest, AddFailsWhenFull) {
+    static const char payload[] = "x";
+    UdpSendBatch batch(2);
+    EXPECT_TRUE(batch.add(client_fd, server_addr, payload, 1));
+    EXPECT_TRUE(batch.add(client_fd, server_addr, payload, 1));
+    EXPECT_TRUE(batch.full());
+    EXPECT_FALSE(batch.add(client_fd, server_addr, payload, 1));
+    EXPECT_EQ(batch.flush(), 2);
+}
+
+TEST_F(UdpSendBatchTest, AddFailsForAnotherSocket) {
+    static const char payload[] = "x";
+    UdpSendBatch batch(4);
+    EXPECT_TRUE(batch.add(client_fd, server_addr, payload, 1));
+    EXPECT_FALSE(batch.add(server_fd, server_addr, payload, 1));
+    EXPECT_EQ(batch.flush(), 1);
+    EXPECT_TRUE(batch.add(server_fd, server_addr, payload, 1));
+    batch.flush();
+}
+
+TEST_F(UdpSendBatchTest, FlushEmptyBatchSendsNothing) {
+    UdpSendBatch batch(4);
+    EXPECT_EQ(batch.flush(), 0);
+}
+
+TEST_F(UdpSendBatchTest, FlushOnInvalidSocketDropsDatagrams) {
+    static const char payload[] = "x";
+    UdpSendBatch batch(4);
+    batch.add(-1, server_addr, payload, 1);
+    batch.add(-1, server_addr, payload, 1);
+    EXPECT_EQ(batch.flush(), 0);
+    EXPECT_TRUE(batch.empty());
+}
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include "server/worker_queues.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+QueueLimits make_limits(size_t capacity) {
+    QueueLimits limits;
+    limits.capacity = capacity;
+    return limits;
+}
+}
+
+TEST(WorkerQueuesTest, SplitsCapacityAmongWorkers) {
+    WorkerQueues<int> queues(3, make_limits(8));
+    EXPECT_EQ(queues.workers(), 3u);
+    EXPECT_EQ(queues.capacity(), 8u);
+
+    auto now = Clock::now();
+    for (int i = 0; i < 10; ++i) {
+        queues.push(int{i}, now);
+    }
+    EXPECT_EQ(queues.size(), 8u);
+    EXPECT_EQ(queues.size(0), 3u);
+    EXPECT_EQ(queues.size(1), 3u);
+    EXPECT_EQ(queues.size(2), 2u);
+}
+
+TEST(WorkerQueuesTest, DealsItemsInTurn) {
+    WorkerQueues<int> queues(2, make_limits(16));
+    QueueConsumer consumer(make_limits(16));
+    auto now = Clock::now();
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(queues.push(int{i}, now), WorkerQueues<int>::PushResult::Queued);
+    }
+
+    int item = -1;
+    bool stolen = true;
+    ASSERT_TRUE(queues.pop(1, item, now, consumer, stolen));
+    EXPECT_EQ(item, 1);
+    EXPECT_FALSE(stolen);
+    ASSERT_TRUE(queues.pop(1, item, now, consumer, stolen));
+    EXPECT_EQ(item, 3);
+    EXPECT_FALSE(stolen);
+}
+
+TEST(WorkerQueuesTest, IdleWorkerStealsFromSibling) {
+    WorkerQueues<int> queues(2, make_limits(16));
+    QueueConsumer consumer(make_limits(16));
+    auto now = Clock::now();
+    for (int i = 0; i < 3; ++i) {
+        queues.push(int{i}, now);
+    }
+
+    int item = -1;
+    bool stolen = false;
+    ASSERT_TRUE(queues.pop(1, item, now, consumer, stolen));
+    EXPECT_EQ(item, 1);
+    // Worker 1's queue is empty now: it takes the head of worker 0's.
+    ASSERT_TRUE(queues.pop(1, item, now, consumer, stolen));
+    EXPECT_EQ(item, 0);
+    EXPECT_TRUE(stolen);
+    EXPECT_EQ(queues.size(0), 1u);
+    ASSERT_TRUE(queues.pop(1, item, now, consumer, stolen));
+    EXPECT_EQ(item, 2);
+    EXPECT_FALSE(queues.pop(1, item, now, consumer, stolen));
+    EXPECT_TRUE(queues.empty());
+}
+
+TEST(WorkerQueuesTest, PassesOverFullQueuesAndRejectsWhenAllAreFull) {
+    WorkerQueues<int> queues(2, make_limits(2));
+    QueueConsumer consumer(make_limits(2));
+    auto now = Clock::now();
+    queues.push(0, now);
+    queues.push(1, now);
+    EXPECT_EQ(queues.push(2, now), WorkerQueues<int>::PushResult::Rejected);
+
+    int item = -1;
+    bool stolen = false;
+    ASSERT_TRUE(queues.pop(0, item, now, consumer, stolen));
+    // Worker 1 is next in turn but full, so worker 0 takes the item.
+    EXPECT_EQ(queues.push(3, now), WorkerQueues<int>::PushResult::Queued);
+    EXPECT_EQ(queues.size(0), 1u);
+    EXPECT_EQ(queues.size(1), 1u);
+}
+
+TEST(WorkerQueuesTest, NotifyDealtWakesOnlyWorkersThatGotItems) {
+    WorkerQueues<int> queues(2, make_limits(16));
+    uint32_t first = queues.work_ready(0).prepare_wait();
+    uint32_t second = queues.work_ready(1).prepare_wait();
+
+    queues.push(0, Clock::now());
+    queues.notify_dealt();
+
+    queues.work_ready(0).finish_wait();
+    queues.work_ready(1).finish_wait();
+    EXPECT_NE(queues.work_ready(0).prepare_wait(), first);
+    EXPECT_EQ(queues.work_ready(1).prepare_wait(), second);
+    queues.work_ready(0).finish_wait();
+    queues.work_ready(1).finish_wait();
+}
+
+TEST(WorkerQueuesTest, DealsOnlyToActiveWorkersUntilTheyAreFull) {
+    WorkerQueues<int> queues(3, make_limits(6));
+    queues.set_active(1);
+    EXPECT_EQ(queues.active(), 1u);
+    auto now = Clock::now();
+    for (int i = 0; i < 3; ++i) {
+        queues.push(int{i}, now);
+    }
+    EXPECT_EQ(queues.size(0), 2u);
+    // The active queue is full: the rest overflows into a retired worker's queue.
+    EXPECT_EQ(queues.size(1), 1u);
+    EXPECT_EQ(queues.size(2), 0u);
+
+    // Worker 0 steals what overflowed, so nothing waits for a retired worker.
+    QueueConsumer consumer(make_limits(6));
+    int item = -1;
+    bool stolen = false;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(queues.pop(0, item, now, consumer, stolen));
+    }
+    EXPECT_TRUE(stolen);
+    EXPECT_TRUE(queues.empty());
+
+    queues.set_active(0);
+    EXPECT_EQ(queues.active(), 1u);
+    queues.set_active(5);
+    EXPECT_EQ(queues.active(), 3u);
+}
+
+TEST(WorkerQueuesTest, RetiringWakesTheRetiredAndRedirectsTheirWakeUps) {
+    WorkerQueues<int> queues(2, make_limits(16));
+    uint32_t retired = queues.work_ready(1).prepare_wait();
+    queues.set_active(1);
+    queues.work_ready(1).finish_wait();
+    EXPECT_NE(queues.work_ready(1).prepare_wait(), retired);
+    queues.work_ready(1).finish_wait();
+
+    // Worker 1's queue got an item while it grew back: worker 0 is woken to take it.
+    queues.set_active(2);
+    queues.push(0, Clock::now());
+    queues.push(1, Clock::now());
+    queues.set_active(1);
+    uint32_t active = queues.work_ready(0).prepare_wait();
+    retired = queues.work_ready(1).prepare_wait();
+    queues.notify_dealt();
+    queues.work_ready(0).finish_wait();
+    queues.work_ready(1).finish_wait();
+    EXPECT_NE(queues.work_ready(0).prepare_wait(), active);
+    EXPECT_EQ(queues.work_ready(1).prepare_wait(), retired);
+    queues.work_ready(0).finish_wait();
+    queues.work_ready(1).finish_wait();
+}
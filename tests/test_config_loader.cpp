@@ -138,6 +138,13 @@ TEST(ConfigLoaderTest, SessionTimeoutZeroThrows) {
     std::remove(path.c_str());
 }
 
+TEST(ConfigLoaderTest, SessionTimeoutAboveLimitThrows) {
+    std::string path = "huge_timeout.json";
+    write_temp_file(path, R"({ "session_timeout_sec": 1000001 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
 TEST(ConfigLoaderTest, MissingOptionalFieldsUsesDefaults) {
     std::string path = "missing_fields.json";
     write_temp_file(path, R"({
@@ -247,3 +254,304 @@ TEST(ConfigLoaderTest, ClientServerPortHighThrows) {
     std::remove(path.c_str());
 }
 
+TEST(ConfigLoaderTest, RecvBatchSizeDefaultsTo32) {
+    std::string path = "recv_batch_default.json";
+    write_temp_file(path, R"({ "udp_ip": "127.0.0.1" })");
+    ServerConfig config = load_config_server(path);
+    EXPECT_EQ(config.recv_batch_size, 32);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, RecvBatchSizeOutOfRangeThrows) {
+    std::string path = "recv_batch_bad.json";
+    write_temp_file(path, R"({ "recv_batch_size": 0 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    write_temp_file(path, R"({ "recv_batch_size": 2048 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, SendBatchSettingsDefaults) {
+    std::string path = "send_batch_default.json";
+    write_temp_file(path, R"({ "udp_ip": "127.0.0.1" })");
+    ServerConfig config = load_config_server(path);
+    EXPECT_EQ(config.send_batch_size, 32);
+    EXPECT_EQ(config.send_flush, "end_of_batch");
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, InvalidSendFlushThrows) {
+    std::string path = "send_flush_bad.json";
+    write_temp_file(path, R"({ "send_flush": "never" })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, SendBatchSizeOutOfRangeThrows) {
+    std::string path = "send_batch_bad.json";
+    write_temp_file(path, R"({ "send_batch_size": 0 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, ReactorCountOutOfRangeThrows) {
+    std::string path = "reactor_count_bad.json";
+    write_temp_file(path, R"({ "reactor_count": 0 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    write_temp_file(path, R"({ "reactor_count": 65 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, InvalidReactorSteeringThrows) {
+    std::string path = "reactor_steering_bad.json";
+    write_temp_file(path, R"({ "reactor_steering": "random" })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, SocketFilterDefaultsOff) {
+    std::string path = "socket_filter_default.json";
+    write_temp_file(path, R"({ "udp_ip": "127.0.0.1" })");
+    EXPECT_FALSE(load_config_server(path).socket_filter);
+    write_temp_file(path, R"({ "socket_filter": true })");
+    EXPECT_TRUE(load_config_server(path).socket_filter);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, IoBackendDefaultsToEpoll) {
+    std::string path = "io_backend_default.json";
+    write_temp_file(path, R"({ "udp_ip": "127.0.0.1" })");
+    EXPECT_EQ(load_config_server(path).io_backend, "epoll");
+    write_temp_file(path, R"({ "io_backend": "io_uring" })");
+    EXPECT_EQ(load_config_server(path).io_backend, "io_uring");
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, InvalidIoBackendThrows) {
+    std::string path = "io_backend_bad.json";
+    write_temp_file(path, R"({ "io_backend": "select" })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, PacketMmapBackendWithInterface) {
+    std::string path = "packet_mmap.json";
+    write_temp_file(path, R"({ "io_backend": "packet_mmap", "packet_interface": "lo" })");
+    ServerConfig config = load_config_server(path);
+    EXPECT_EQ(config.io_backend, "packet_mmap");
+    EXPECT_EQ(config.packet_interface, "lo");
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, DispatchModeDefaultsToWorkerPool) {
+    std::string path = "dispatch_mode_default.json";
+    write_temp_file(path, R"({ "udp_ip": "127.0.0.1" })");
+    EXPECT_EQ(load_config_server(path).dispatch_mode, "worker_pool");
+    write_temp_file(path, R"({ "dispatch_mode": "run_to_completion" })");
+    EXPECT_EQ(load_config_server(path).dispatch_mode, "run_to_completion");
+    write_temp_file(path, R"({ "dispatch_mode": "imsi_affinity" })");
+    EXPECT_EQ(load_config_server(path).dispatch_mode, "imsi_affinity");
+    write_temp_file(path, R"({ "dispatch_mode": "coroutine" })");
+    EXPECT_EQ(load_config_server(path).dispatch_mode, "coroutine");
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, InvalidDispatchModeThrows) {
+    std::string path = "dispatch_mode_bad.json";
+    write_temp_file(path, R"({ "dispatch_mode": "inline" })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    // Coroutines wait for the sockets in their own epoll executor.
+    write_temp_file(path, R"({ "dispatch_mode": "coroutine", "io_backend": "io_uring" })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, SocketBufferSizes) {
+    std::string path = "socket_buffers.json";
+    write_temp_file(path, R"({ "udp_ip": "127.0.0.1" })");
+    ServerConfig config = load_config_server(path);
+    EXPECT_EQ(config.socket_rcvbuf, 0);
+    EXPECT_EQ(config.socket_sndbuf, 0);
+
+    write_temp_file(path, R"({ "socket_rcvbuf": 4194304, "socket_sndbuf": 1048576 })");
+    config = load_config_server(path);
+    EXPECT_EQ(config.socket_rcvbuf, 4194304);
+    EXPECT_EQ(config.socket_sndbuf, 1048576);
+
+    write_temp_file(path, R"({ "socket_rcvbuf": -1 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, SpinBudgetAndBusyPoll) {
+    std::string path = "spin_budget.json";
+    write_temp_file(path, R"({ "udp_ip": "127.0.0.1" })");
+    ServerConfig config = load_config_server(path);
+    EXPECT_EQ(config.spin_budget_us, 0);
+    EXPECT_EQ(config.busy_poll_us, 0);
+
+    write_temp_file(path, R"({ "spin_budget_us": 50, "busy_poll_us": 20 })");
+    config = load_config_server(path);
+    EXPECT_EQ(config.spin_budget_us, 50);
+    EXPECT_EQ(config.busy_poll_us, 20);
+
+    write_temp_file(path, R"({ "spin_budget_us": 20000 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    write_temp_file(path, R"({ "busy_poll_us": -1 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, RateLimits) {
+    std::string path = "rate_limits.json";
+    write_temp_file(path, R"({ "udp_ip": "127.0.0.1" })");
+    ServerConfig config = load_config_server(path);
+    EXPECT_EQ(config.rate_limit_ip_rate, 0);
+    EXPECT_EQ(config.rate_limit_imsi_rate, 0);
+    EXPECT_EQ(config.rate_limit_table_size, 65536);
+
+    write_temp_file(path, R"({ "rate_limit_ip_rate": 1000, "rate_limit_ip_burst": 50,
+                               "rate_limit_imsi_rate": 5, "rate_limit_imsi_burst": 2,
+                               "rate_limit_table_size": 1024, "rate_limit_idle_sec": 10 })");
+    config = load_config_server(path);
+    EXPECT_EQ(config.rate_limit_ip_rate, 1000);
+    EXPECT_EQ(config.rate_limit_ip_burst, 50);
+    EXPECT_EQ(config.rate_limit_imsi_rate, 5);
+    EXPECT_EQ(config.rate_limit_imsi_burst, 2);
+    EXPECT_EQ(config.rate_limit_table_size, 1024);
+    EXPECT_EQ(config.rate_limit_idle_sec, 10);
+
+    write_temp_file(path, R"({ "rate_limit_ip_burst": 0 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    write_temp_file(path, R"({ "rate_limit_imsi_rate": -5 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, QueueCapacityAndPolicy) {
+    std::string path = "queue_policy.json";
+    write_temp_file(path, R"({ "udp_ip": "127.0.0.1" })");
+    ServerConfig config = load_config_server(path);
+    EXPECT_EQ(config.queue_capacity, 65536);
+    EXPECT_EQ(config.queue_policy, "tail_drop");
+
+    write_temp_file(path, R"({ "queue_capacity": 1000, "queue_policy": "codel",
+                               "codel_target_us": 2000, "codel_interval_us": 50000 })");
+    config = load_config_server(path);
+    EXPECT_EQ(config.queue_capacity, 1000);
+    EXPECT_EQ(config.queue_policy, "codel");
+    EXPECT_EQ(config.codel_target_us, 2000);
+    EXPECT_EQ(config.codel_interval_us, 50000);
+
+    write_temp_file(path, R"({ "queue_policy": "random" })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    write_temp_file(path, R"({ "queue_capacity": 0 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    write_temp_file(path, R"({ "codel_target_us": 10000, "codel_interval_us": 5000 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, ThreadTopology) {
+    std::string path = "thread_topology.json";
+    write_temp_file(path, R"({ "udp_ip": "127.0.0.1" })");
+    ServerConfig config = load_config_server(path);
+    EXPECT_EQ(config.worker_count, 0);
+    EXPECT_TRUE(config.reactor_cpus.empty());
+    EXPECT_TRUE(config.worker_cpus.empty());
+    EXPECT_TRUE(config.cleaner_cpus.empty());
+    EXPECT_TRUE(config.http_cpus.empty());
+
+    write_temp_file(path, R"({ "worker_count": 6, "reactor_cpus": "0-1", "worker_cpus": "4-6,2, 3",
+                               "cleaner_cpus": "7", "http_cpus": "7" })");
+    config = load_config_server(path);
+    EXPECT_EQ(config.worker_count, 6);
+    EXPECT_EQ(config.reactor_cpus, (std::vector<int>{0, 1}));
+    EXPECT_EQ(config.worker_cpus, (std::vector<int>{2, 3, 4, 5, 6}));
+    EXPECT_EQ(config.cleaner_cpus, std::vector<int>{7});
+    EXPECT_EQ(config.http_cpus, std::vector<int>{7});
+
+    write_temp_file(path, R"({ "worker_count": -1 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    write_temp_file(path, R"({ "worker_cpus": "3-1" })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    write_temp_file(path, R"({ "reactor_cpus": "0,,1" })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    write_temp_file(path, R"({ "http_cpus": "1024" })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, WorkerBatchSize) {
+    std::string path = "worker_batch_size.json";
+    write_temp_file(path, R"({ "udp_ip": "127.0.0.1" })");
+    EXPECT_EQ(load_config_server(path).worker_batch_size, 32);
+    write_temp_file(path, R"({ "worker_batch_size": 1 })");
+    EXPECT_EQ(load_config_server(path).worker_batch_size, 1);
+    write_temp_file(path, R"({ "worker_batch_size": 0 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    write_temp_file(path, R"({ "worker_batch_size": 2048 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, SessionShards) {
+    std::string path = "session_shards.json";
+    write_temp_file(path, R"({ "udp_ip": "127.0.0.1" })");
+    EXPECT_EQ(load_config_server(path).session_shards, 64);
+    write_temp_file(path, R"({ "session_shards": 1 })");
+    EXPECT_EQ(load_config_server(path).session_shards, 1);
+    write_temp_file(path, R"({ "session_shards": 0 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    write_temp_file(path, R"({ "session_shards": 100000 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, SessionTickAndMillisecondTimeout) {
+    std::string path = "session_tick.json";
+    write_temp_file(path, R"({ "udp_ip": "127.0.0.1" })");
+    ServerConfig config = load_config_server(path);
+    EXPECT_EQ(config.session_tick_ms, 1000);
+    EXPECT_EQ(config.session_timeout_ms, 0);
+    write_temp_file(path, R"({ "session_tick_ms": 10, "session_timeout_ms": 250 })");
+    config = load_config_server(path);
+    EXPECT_EQ(config.session_tick_ms, 10);
+    EXPECT_EQ(config.session_timeout_ms, 250);
+    write_temp_file(path, R"({ "session_tick_ms": 0 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    write_temp_file(path, R"({ "session_tick_ms": 60001 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    write_temp_file(path, R"({ "session_timeout_ms": -1 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(ConfigLoaderTest, ElasticWorkers) {
+    std::string path = "elastic_workers.json";
+    write_temp_file(path, R"({ "udp_ip": "127.0.0.1" })");
+    ServerConfig config = load_config_server(path);
+    EXPECT_FALSE(config.elastic_workers);
+    EXPECT_EQ(config.elastic_min_workers, 1);
+    EXPECT_EQ(config.elastic_max_workers, 0);
+    EXPECT_EQ(config.elastic_grow_sojourn_us, 1000);
+    EXPECT_EQ(config.elastic_shrink_sojourn_us, 100);
+    EXPECT_EQ(config.elastic_shrink_after_sec, 10);
+
+    write_temp_file(path, R"({ "elastic_workers": true, "elastic_min_workers": 2, "elastic_max_workers": 8 })");
+    config = load_config_server(path);
+    EXPECT_TRUE(config.elastic_workers);
+    EXPECT_EQ(config.elastic_min_workers, 2);
+    EXPECT_EQ(config.elastic_max_workers, 8);
+
+    write_temp_file(path, R"({ "elastic_workers": true, "dispatch_mode": "imsi_affinity" })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    write_temp_file(path, R"({ "elastic_min_workers": 4, "elastic_max_workers": 2 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    write_temp_file(path, R"({ "elastic_shrink_sojourn_us": 1000 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    write_temp_file(path, R"({ "elastic_shrink_after_sec": 0 })");
+    EXPECT_THROW(load_config_server(path), std::runtime_error);
+    std::remove(path.c_str());
+}